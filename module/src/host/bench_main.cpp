@@ -0,0 +1,999 @@
+//
+// Throughput of the dump pipeline against the mock libil2cpp.so at several scales.
+// Each scale runs in its own process, the mock builds its metadata once per process
+// and peak rss would otherwise carry over from the previous scale.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "il2cpp_api.h"
+#include "xdl.h"
+#include "il2cpp_dump.h"
+#include "dump_buffer.h"
+#include "dump_writer.h"
+#include "dump_modifiers.h"
+#include "type_name_cache.h"
+#include "targets.h"
+#include "companion.h"
+#include "mock_il2cpp.h"
+
+// defined in il2cpp_dump.cpp
+void dump_method(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names);
+void dump_property(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names);
+void dump_field(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names);
+void dump_type(const Il2CppType *type, DumpBuffer &outPut, TypeNameCache &names);
+
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    abort();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr unsigned int kDefaultScales[] = {1000, 10000, 100000};
+
+struct BenchOptions {
+    std::string lib;
+    // where the spawn_stub and spawn_full libraries were built
+    std::string binDir;
+    std::string outDir;
+    double minSeconds = 0.5;
+    unsigned int threads = 0;
+};
+
+struct Sample {
+    double seconds;
+    size_t bytes;
+    size_t allocations;
+    size_t passes;
+};
+
+// one field of /proc/self/status in kB
+static long status_kb(const char *field) {
+    long kb = 0;
+    if (auto file = fopen("/proc/self/status", "r")) {
+        char line[128];
+        auto len = strlen(field);
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, field, len) == 0 && line[len] == ':') {
+                kb = strtol(line + len + 1, nullptr, 10);
+                break;
+            }
+        }
+        fclose(file);
+    }
+    return kb;
+}
+
+static long current_rss_kb() {
+    return status_kb("VmRSS");
+}
+
+static long peak_rss_kb() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void report(const char *name, size_t classes, const Sample &sample) {
+    auto perPass = sample.seconds / sample.passes;
+    printf("  %-16s %10.1f ns/class %10.0f classes/s %9.1f MB/s %8.2f allocs/class\n", name,
+           perPass * 1e9 / classes, classes / perPass, sample.bytes / sample.seconds / 1e6,
+           (double) sample.allocations / sample.passes / classes);
+}
+
+// formats every class with one formatter, the buffer is dropped whenever dump()
+// would have flushed it so the pool sees the same reuse pattern
+template<typename Formatter>
+static Sample bench_formatter(const std::vector<Il2CppClass *> &classes, double minSeconds,
+                              Formatter format) {
+    Sample sample{};
+    auto allocsBefore = allocations.load();
+    auto start = Clock::now();
+    do {
+        TypeNameCache names;
+        DumpBuffer outPut;
+        for (auto klass: classes) {
+            format(klass, outPut, names);
+            if (outPut.size() >= DumpWriter::kFlushThreshold) {
+                sample.bytes += outPut.size();
+                outPut.clear();
+            }
+        }
+        sample.bytes += outPut.size();
+        ++sample.passes;
+        sample.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (sample.seconds < minSeconds);
+    sample.allocations = allocations.load() - allocsBefore;
+    return sample;
+}
+
+static Sample bench_dump(const BenchOptions &options, unsigned int threads, bool metadata) {
+    Sample best{};
+    auto dumpPath = options.outDir + "/files/dump.cs";
+    for (int i = 0; i < 3; ++i) {
+        auto allocsBefore = allocations.load();
+        auto start = Clock::now();
+        il2cpp_dump(options.outDir.data(), DumpOptions{threads, false, metadata});
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        struct stat st{};
+        stat(dumpPath.data(), &st);
+        if (i == 0 || seconds < best.seconds) {
+            best = {seconds, (size_t) st.st_size, allocations.load() - allocsBefore, 1};
+        }
+    }
+    unlink(dumpPath.data());
+    unlink((options.outDir + "/files/dump_metrics.json").data());
+    return best;
+}
+
+// The modifier code the tables replaced, kept as the reference: methods built a
+// std::string through their own stringstream, fields and types switched on the
+// flags and streamed every keyword into the declaration.
+static std::string legacy_method_modifier(uint32_t flags) {
+    std::stringstream outPut;
+    auto access = flags & METHOD_ATTRIBUTE_MEMBER_ACCESS_MASK;
+    switch (access) {
+        case METHOD_ATTRIBUTE_PRIVATE:
+            outPut << "private ";
+            break;
+        case METHOD_ATTRIBUTE_PUBLIC:
+            outPut << "public ";
+            break;
+        case METHOD_ATTRIBUTE_FAMILY:
+            outPut << "protected ";
+            break;
+        case METHOD_ATTRIBUTE_ASSEM:
+        case METHOD_ATTRIBUTE_FAM_AND_ASSEM:
+            outPut << "internal ";
+            break;
+        case METHOD_ATTRIBUTE_FAM_OR_ASSEM:
+            outPut << "protected internal ";
+            break;
+    }
+    if (flags & METHOD_ATTRIBUTE_STATIC) {
+        outPut << "static ";
+    }
+    if (flags & METHOD_ATTRIBUTE_ABSTRACT) {
+        outPut << "abstract ";
+        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_REUSE_SLOT) {
+            outPut << "override ";
+        }
+    } else if (flags & METHOD_ATTRIBUTE_FINAL) {
+        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_REUSE_SLOT) {
+            outPut << "sealed override ";
+        }
+    } else if (flags & METHOD_ATTRIBUTE_VIRTUAL) {
+        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_NEW_SLOT) {
+            outPut << "virtual ";
+        } else {
+            outPut << "override ";
+        }
+    }
+    if (flags & METHOD_ATTRIBUTE_PINVOKE_IMPL) {
+        outPut << "extern ";
+    }
+    return outPut.str();
+}
+
+static void legacy_field_modifier(std::stringstream &outPut, uint32_t attrs) {
+    auto access = attrs & FIELD_ATTRIBUTE_FIELD_ACCESS_MASK;
+    switch (access) {
+        case FIELD_ATTRIBUTE_PRIVATE:
+            outPut << "private ";
+            break;
+        case FIELD_ATTRIBUTE_PUBLIC:
+            outPut << "public ";
+            break;
+        case FIELD_ATTRIBUTE_FAMILY:
+            outPut << "protected ";
+            break;
+        case FIELD_ATTRIBUTE_ASSEMBLY:
+        case FIELD_ATTRIBUTE_FAM_AND_ASSEM:
+            outPut << "internal ";
+            break;
+        case FIELD_ATTRIBUTE_FAM_OR_ASSEM:
+            outPut << "protected internal ";
+            break;
+    }
+    if (attrs & FIELD_ATTRIBUTE_LITERAL) {
+        outPut << "const ";
+    } else {
+        if (attrs & FIELD_ATTRIBUTE_STATIC) {
+            outPut << "static ";
+        }
+        if (attrs & FIELD_ATTRIBUTE_INIT_ONLY) {
+            outPut << "readonly ";
+        }
+    }
+}
+
+static void legacy_type_modifier(std::stringstream &outPut, uint32_t flags, bool is_valuetype,
+                                 bool is_enum) {
+    auto visibility = flags & TYPE_ATTRIBUTE_VISIBILITY_MASK;
+    switch (visibility) {
+        case TYPE_ATTRIBUTE_PUBLIC:
+        case TYPE_ATTRIBUTE_NESTED_PUBLIC:
+            outPut << "public ";
+            break;
+        case TYPE_ATTRIBUTE_NOT_PUBLIC:
+        case TYPE_ATTRIBUTE_NESTED_FAM_AND_ASSEM:
+        case TYPE_ATTRIBUTE_NESTED_ASSEMBLY:
+            outPut << "internal ";
+            break;
+        case TYPE_ATTRIBUTE_NESTED_PRIVATE:
+            outPut << "private ";
+            break;
+        case TYPE_ATTRIBUTE_NESTED_FAMILY:
+            outPut << "protected ";
+            break;
+        case TYPE_ATTRIBUTE_NESTED_FAM_OR_ASSEM:
+            outPut << "protected internal ";
+            break;
+    }
+    if (flags & TYPE_ATTRIBUTE_ABSTRACT && flags & TYPE_ATTRIBUTE_SEALED) {
+        outPut << "static ";
+    } else if (!(flags & TYPE_ATTRIBUTE_INTERFACE) && flags & TYPE_ATTRIBUTE_ABSTRACT) {
+        outPut << "abstract ";
+    } else if (!is_valuetype && !is_enum && flags & TYPE_ATTRIBUTE_SEALED) {
+        outPut << "sealed ";
+    }
+    if (flags & TYPE_ATTRIBUTE_INTERFACE) {
+        outPut << "interface ";
+    } else if (is_enum) {
+        outPut << "enum ";
+    } else if (is_valuetype) {
+        outPut << "struct ";
+    } else {
+        outPut << "class ";
+    }
+}
+
+// method, field and type modifiers for every 16-bit flags value, streamed into one
+// declaration buffer the way the formatters used to
+template<typename Op>
+static void bench_modifier_sweep(const char *name, double minSeconds, Op op) {
+    std::stringstream outPut;
+    size_t lookups = 0;
+    size_t bytes = 0;
+    auto allocsBefore = allocations.load();
+    auto start = Clock::now();
+    double seconds;
+    do {
+        outPut.str({});
+        for (uint32_t flags = 0; flags < 0x10000; ++flags) {
+            op(outPut, flags);
+        }
+        lookups += 3 * 0x10000;
+        bytes = (size_t) outPut.tellp();
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < minSeconds);
+    printf("  %-16s %10.2f ns/lookup %8.2f allocs/lookup (%zu bytes per sweep)\n", name,
+           seconds * 1e9 / lookups, (double) (allocations.load() - allocsBefore) / lookups, bytes);
+}
+
+static void bench_modifiers(double minSeconds) {
+    bench_modifier_sweep("modifier switch", minSeconds, [](std::stringstream &outPut,
+                                                           uint32_t flags) {
+        outPut << legacy_method_modifier(flags);
+        legacy_field_modifier(outPut, flags);
+        legacy_type_modifier(outPut, flags, flags & 1, flags & 2);
+    });
+    bench_modifier_sweep("modifier tables", minSeconds, [](std::stringstream &outPut,
+                                                           uint32_t flags) {
+        outPut << get_method_modifier(flags);
+        outPut << get_field_modifier(flags);
+        outPut << get_type_modifier(flags, flags & 1, flags & 2);
+    });
+}
+
+template<typename Op>
+static void bench_op(const char *name, const char *unit, double minSeconds, Op op) {
+    size_t calls = 0;
+    size_t checksum = 0;
+    auto allocsBefore = allocations.load();
+    auto start = Clock::now();
+    double seconds;
+    do {
+        for (int i = 0; i < 1000; ++i) {
+            checksum += op();
+        }
+        calls += 1000;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < minSeconds);
+    printf("  %-16s %10.1f ns/%s %8.2f allocs/%s (checksum %zu)\n", name,
+           seconds * 1e9 / calls, unit, (double) (allocations.load() - allocsBefore) / calls, unit,
+           checksum);
+}
+
+// what preAppSpecialize pays per app spawn to decide whether to dump, with a
+// targets.txt of 64 packages and 4 globs
+static void bench_targets(double minSeconds) {
+    std::string text = "# benchmark targets\n";
+    for (int i = 0; i < 64; ++i) {
+        text.append("com.studio").append(std::to_string(i)).append(".game threads=4\n");
+    }
+    text.append("com.bigpublisher.* snapshot=1\nnet.*.unity\njp.co.*game?\norg.test.*\n");
+    TargetOptions defaults{1, 0, 0};
+    TargetTable table;
+    table.parse(text, defaults);
+    printf("targets.txt (%zu targets)\n", table.size());
+    bench_op("parse", "spawn", minSeconds, [&] {
+        TargetTable spawn;
+        spawn.parse(text, defaults);
+        return spawn.size();
+    });
+    bench_op("lookup miss", "spawn", minSeconds, [&] {
+        return table.find("com.android.systemui") != nullptr;
+    });
+    bench_op("lookup hit", "spawn", minSeconds, [&] {
+        return table.find("com.studio42.game") != nullptr;
+    });
+    bench_op("lookup glob", "spawn", minSeconds, [&] {
+        return table.find("org.test.sample") != nullptr;
+    });
+}
+
+// preAppSpecialize reading the module dir itself against asking the companion, which
+// keeps the parsed table, the dumper library fd and the payload memfd, and against
+// probing the targets.bin the companion writes and asking it only for a hit. Each
+// companion request gets a fresh socket pair and handler thread, like a
+// connectCompanion() call.
+static void bench_companion(double minSeconds) {
+    char dir[] = "/tmp/il2cppdumper_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return;
+    }
+    std::string text;
+    for (int i = 0; i < 64; ++i) {
+        text.append("com.studio").append(std::to_string(i)).append(".game threads=4\n");
+    }
+    text.append("com.bigpublisher.* snapshot=1\n");
+    std::vector<char> payload(256 * 1024, 0x7f);
+    auto targetsPath = std::string(dir) + "/targets.txt";
+    auto dumperDir = std::string(dir) + "/dumper";
+    // the host companion takes the x86_64 paths: its own dumper and the arm64 payload
+    auto payloadPath = dumperDir + "/arm64-v8a.so";
+    auto dumperPath = dumperDir + "/x86_64.so";
+    mkdir(dumperDir.c_str(), 0755);
+    auto targetsFile = fopen(targetsPath.c_str(), "w");
+    auto payloadFile = fopen(payloadPath.c_str(), "w");
+    auto dumperFile = fopen(dumperPath.c_str(), "w");
+    if (!targetsFile || !payloadFile || !dumperFile) {
+        perror("fopen");
+        return;
+    }
+    fwrite(text.data(), 1, text.size(), targetsFile);
+    fwrite(payload.data(), 1, payload.size(), payloadFile);
+    fwrite(payload.data(), 1, payload.size(), dumperFile);
+    fclose(targetsFile);
+    fclose(payloadFile);
+    fclose(dumperFile);
+    int moduleDir = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    auto query = [&](const char *package) -> size_t {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+            return 0;
+        }
+        std::thread server([fd = sv[1]] {
+            companion_handler(fd);
+            close(fd);
+        });
+        CompanionReply reply{};
+        int fds[2];
+        size_t result = companion_query(sv[0], moduleDir, package, reply, fds[0], fds[1]);
+        close(sv[0]);
+        server.join();
+        for (int fd: fds) {
+            if (fd != -1) {
+                struct stat sb{};
+                fstat(fd, &sb);
+                close(fd);
+                result += (size_t) sb.st_size;
+            }
+        }
+        return result + reply.target;
+    };
+
+    printf("spawn decision (%zu byte targets.txt, %zu byte payload)\n", text.size(),
+           payload.size());
+    bench_op("module dir miss", "spawn", minSeconds, [&] {
+        CompanionReply reply{};
+        return (size_t) lookup_target(moduleDir, "com.android.systemui", reply);
+    });
+    bench_op("module dir hit", "spawn", minSeconds, [&] {
+        CompanionReply reply{};
+        size_t found = lookup_target(moduleDir, "com.studio42.game", reply);
+        for (int fd: {open_dumper(moduleDir), load_payload(moduleDir)}) {
+            if (fd != -1) {
+                close(fd);
+                ++found;
+            }
+        }
+        return found;
+    });
+    bench_op("companion miss", "spawn", minSeconds, [&] {
+        return query("com.android.systemui");
+    });
+    bench_op("companion hit", "spawn", minSeconds, [&] {
+        return query("com.studio42.game");
+    });
+    // the requests above have had the companion write targets.bin
+    bench_op("targets.bin miss", "spawn", minSeconds, [&] {
+        CompanionReply reply{};
+        return (size_t) probe_target(moduleDir, "com.android.systemui", reply) + reply.target;
+    });
+    bench_op("targets.bin hit", "spawn", minSeconds, [&] {
+        CompanionReply reply{};
+        if (probe_target(moduleDir, "com.studio42.game", reply) && !reply.target) {
+            return (size_t) 1;
+        }
+        return query("com.studio42.game");
+    });
+
+    close(moduleDir);
+    unlink(payloadPath.c_str());
+    unlink(dumperPath.c_str());
+    unlink(targetsPath.c_str());
+    unlink((std::string(dir) + "/targets.bin").c_str());
+    rmdir(dumperDir.c_str());
+    rmdir(dir);
+}
+
+// il2cpp api init against the mock: one xdl_sym per DO_API name as before, and one
+// xdl_sym_batch with the hashes computed at compile time
+static void bench_symbols(const BenchOptions &options) {
+    auto handle = dlopen(options.lib.data(), RTLD_NOW);
+    auto name = options.lib.substr(options.lib.rfind('/') + 1);
+    auto il2cpp = handle ? xdl_open(name.data(), XDL_DEFAULT) : nullptr;
+    if (!il2cpp) {
+        fprintf(stderr, "xdl_open %s failed\n", name.data());
+        return;
+    }
+    printf("il2cpp api init (%zu names)\n", kIl2CppApiCount);
+    bench_op("xdl_sym loop", "init", options.minSeconds, [&] {
+        size_t found = 0;
+        for (auto apiName: kIl2CppApiNames) {
+            found += xdl_sym(il2cpp, apiName, nullptr) != nullptr;
+        }
+        return found;
+    });
+    bench_op("xdl_sym_batch", "init", options.minSeconds, [&] {
+        xdl_sym_req_t reqs[kIl2CppApiCount];
+        for (size_t i = 0; i < kIl2CppApiCount; ++i) {
+            reqs[i] = {kIl2CppApiNames[i], kIl2CppApiHashes[i], nullptr};
+        }
+        return xdl_sym_batch(il2cpp, reqs, kIl2CppApiCount);
+    });
+    // what a poll like GetNativeBridgeInitialized pays each round, the handle comes from
+    // the xdl_open cache after the first call
+    bench_op("open+sym+close", "call", options.minSeconds, [&] {
+        auto lib = xdl_open(name.data(), XDL_DEFAULT);
+        auto found = xdl_sym(lib, "il2cpp_domain_get", nullptr) != nullptr;
+        xdl_close(lib);
+        return (size_t) found;
+    });
+    xdl_close(il2cpp);
+    dlclose(handle);
+}
+
+// defined names in a library's .symtab, what xdl_dsym can find
+static std::vector<std::string> symtab_names(const std::string &path) {
+    std::vector<std::string> names;
+    auto file = fopen(path.data(), "rb");
+    if (!file) {
+        return names;
+    }
+    std::vector<char> data;
+    char chunk[64 * 1024];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    if (data.size() < sizeof(Elf64_Ehdr)) {
+        return names;
+    }
+    auto ehdr = (const Elf64_Ehdr *) data.data();
+    if (ehdr->e_shoff + (size_t) ehdr->e_shnum * sizeof(Elf64_Shdr) > data.size()) {
+        return names;
+    }
+    auto shdrs = (const Elf64_Shdr *) (data.data() + ehdr->e_shoff);
+    for (int i = 0; i < ehdr->e_shnum; ++i) {
+        if (shdrs[i].sh_type != SHT_SYMTAB || shdrs[i].sh_link >= ehdr->e_shnum) {
+            continue;
+        }
+        auto &strtab = shdrs[shdrs[i].sh_link];
+        auto syms = (const Elf64_Sym *) (data.data() + shdrs[i].sh_offset);
+        for (size_t k = 0; k < shdrs[i].sh_size / sizeof(Elf64_Sym); ++k) {
+            auto type = ELF64_ST_TYPE(syms[k].st_info);
+            if (syms[k].st_shndx == SHN_UNDEF || syms[k].st_shndx >= SHN_LORESERVE ||
+                syms[k].st_name == 0 || (type != STT_FUNC && type != STT_OBJECT)) {
+                continue;
+            }
+            names.emplace_back(data.data() + strtab.sh_offset + syms[k].st_name);
+        }
+    }
+    return names;
+}
+
+// xdl_dsym over every function name in .symtab of a library with 20000 hidden functions.
+// The first call loads .symtab, copied to the heap or mapped with XDL_MMAP_SYMTAB, and
+// builds the index, the rest are plain lookups.
+static void bench_dsym(const BenchOptions &options) {
+    auto path = options.binDir + "libsymtab_fixture.so";
+    if (auto real = realpath(path.data(), nullptr)) {
+        path = real;
+        free(real);
+    }
+    auto names = symtab_names(path);
+    auto handle = dlopen(path.data(), RTLD_NOW | RTLD_LOCAL);
+    if (names.empty() || !handle) {
+        fprintf(stderr, "%s: no .symtab to look up\n", path.data());
+        return;
+    }
+    printf("xdl_dsym (%zu names)\n", names.size());
+    for (auto [mode, flags]: {std::pair{"heap", XDL_DEFAULT}, std::pair{"mmap", XDL_MMAP_SYMTAB}}) {
+        auto lib = xdl_open(path.data(), flags | XDL_NO_CACHE);
+        if (!lib) {
+            fprintf(stderr, "xdl_open %s failed\n", path.data());
+            break;
+        }
+        auto anonBefore = status_kb("RssAnon");
+        auto fileBefore = status_kb("RssFile");
+        auto start = Clock::now();
+        auto first = xdl_dsym(lib, names[0].data(), nullptr);
+        auto loadSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        xdl_symtab_info_t info{};
+        xdl_info(lib, XDL_DI_SYMTAB, &info);
+        printf("  first call %-5s %10.1f us (found %d, %zu symtab entries)\n", mode,
+               loadSeconds * 1e6, first != nullptr, info.symtab_cnt);
+        printf("  %-16s %10zu kB heap, %zu kB mapped, %zu kB index for %zu symbols\n", "memory",
+               info.symtab_bytes / 1024, info.symtab_map_bytes / 1024, info.index_bytes / 1024,
+               info.index_cnt);
+        printf("  %-16s %10ld kB anonymous, %ld kB file backed\n", "rss growth",
+               status_kb("RssAnon") - anonBefore, status_kb("RssFile") - fileBefore);
+        if (flags == XDL_MMAP_SYMTAB) {
+            size_t next = 0;
+            bench_op("hit", "lookup", options.minSeconds, [&] {
+                auto &name = names[next++ % names.size()];
+                return (size_t) (xdl_dsym(lib, name.data(), nullptr) != nullptr);
+            });
+            bench_op("miss", "lookup", options.minSeconds, [&] {
+                return (size_t) (xdl_dsym(lib, "il2cpp_no_such_symbol", nullptr) != nullptr);
+            });
+        }
+        xdl_close(lib);
+    }
+    dlclose(handle);
+}
+
+// symbolizing sampled PCs inside the hidden functions of the same library, one by one
+// with xdl_addr and 1024 at a time with xdl_addr_batch. The first batch builds the
+// address index of .dynsym and .symtab.
+static void bench_addr(const BenchOptions &options) {
+    auto path = options.binDir + "libsymtab_fixture.so";
+    if (auto real = realpath(path.data(), nullptr)) {
+        path = real;
+        free(real);
+    }
+    auto names = symtab_names(path);
+    auto handle = dlopen(path.data(), RTLD_NOW | RTLD_LOCAL);
+    auto lib = handle ? xdl_open(path.data(), XDL_DEFAULT) : nullptr;
+    if (names.empty() || !lib) {
+        fprintf(stderr, "%s: no .symtab to symbolize\n", path.data());
+        return;
+    }
+    std::vector<void *> pcs;
+    for (size_t i = 0; i < names.size(); ++i) {
+        size_t size = 0;
+        auto addr = (char *) xdl_dsym(lib, names[(i * 7919) % names.size()].data(), &size);
+        if (addr && size > 1) {
+            pcs.push_back(addr + size / 2);
+        }
+    }
+    xdl_close(lib);
+    if (pcs.size() < 1024) {
+        fprintf(stderr, "%s: too few functions to sample\n", path.data());
+        dlclose(handle);
+        return;
+    }
+
+    void *cache = nullptr;
+    std::vector<xdl_info_t> infos(1024);
+    auto start = Clock::now();
+    auto found = xdl_addr_batch(pcs.data(), infos.data(), infos.size(), &cache);
+    auto firstSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("xdl_addr (%zu sampled pcs)\n", pcs.size());
+    printf("  %-16s %10.1f us (%zu of %zu resolved)\n", "first batch", firstSeconds * 1e6, found,
+           infos.size());
+    size_t next = 0;
+    bench_op("xdl_addr", "addr", options.minSeconds, [&] {
+        xdl_info_t info;
+        xdl_addr(pcs[next++ % pcs.size()], &info, &cache);
+        return (size_t) (info.dli_sname != nullptr);
+    });
+    start = Clock::now();
+    size_t batches = 0;
+    found = 0;
+    double seconds;
+    do {
+        auto offset = (batches * infos.size()) % (pcs.size() - infos.size());
+        found += xdl_addr_batch(pcs.data() + offset, infos.data(), infos.size(), &cache);
+        ++batches;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < options.minSeconds);
+    printf("  %-16s %10.1f ns/addr (resolved %zu of %zu)\n", "xdl_addr_batch",
+           seconds * 1e9 / (batches * infos.size()), found, batches * infos.size());
+    xdl_addr_clean(&cache);
+    dlclose(handle);
+}
+
+// xdl_dsym on the stripped fixture whose .symtab only exists xz-compressed in
+// .gnu_debugdata: decompressing every time, then through the on-disk cache, first the
+// call that fills it and then one that maps it
+static void bench_debugdata(const BenchOptions &options) {
+    auto path = options.binDir + "libdebugdata_fixture.so";
+    if (auto real = realpath(path.data(), nullptr)) {
+        path = real;
+        free(real);
+    }
+    auto names = symtab_names(options.binDir + "libsymtab_fixture.so");
+    // xdl finds the shim by the absolute path it was built with
+    auto lzmaPath = realpath((options.binDir + "liblzma_host.so").data(), nullptr);
+    auto lzma = lzmaPath ? dlopen(lzmaPath, RTLD_NOW | RTLD_LOCAL) : nullptr;
+    free(lzmaPath);
+    auto handle = lzma ? dlopen(path.data(), RTLD_NOW | RTLD_LOCAL) : nullptr;
+    if (names.empty() || !handle) {
+        fprintf(stderr, "%s: no .gnu_debugdata fixture\n", path.data());
+        if (lzma) {
+            dlclose(lzma);
+        }
+        return;
+    }
+    auto cacheDir = options.outDir + "/xdl_cache";
+    mkdir(cacheDir.data(), 0755);
+    if (auto dir = opendir(cacheDir.data())) {
+        while (auto entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                unlink((cacheDir + "/" + entry->d_name).data());
+            }
+        }
+        closedir(dir);
+    }
+
+    printf("xdl_dsym .gnu_debugdata (%zu names)\n", names.size());
+    for (auto [mode, dir]: {std::pair{"lzma", (const char *) nullptr},
+                            std::pair{"lzma+store", (const char *) cacheDir.data()},
+                            std::pair{"cached", (const char *) cacheDir.data()}}) {
+        xdl_set_debugdata_cache(dir);
+        auto lib = xdl_open(path.data(), XDL_NO_CACHE);
+        if (!lib) {
+            fprintf(stderr, "xdl_open %s failed\n", path.data());
+            break;
+        }
+        auto start = Clock::now();
+        auto first = xdl_dsym(lib, names[0].data(), nullptr);
+        auto loadSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        size_t found = 0;
+        for (auto &name: names) {
+            found += xdl_dsym(lib, name.data(), nullptr) != nullptr;
+        }
+        xdl_symtab_info_t info{};
+        xdl_info(lib, XDL_DI_SYMTAB, &info);
+        printf("  first call %-10s %8.1f us (found %d, then %zu of %zu), %zu kB heap, %zu kB mapped\n",
+               mode, loadSeconds * 1e6, first != nullptr, found, names.size(),
+               info.symtab_bytes / 1024, info.symtab_map_bytes / 1024);
+        xdl_close(lib);
+    }
+    xdl_set_debugdata_cache(nullptr);
+    dlclose(handle);
+    dlclose(lzma);
+}
+
+static int count_phdr_cb(struct dl_phdr_info *, size_t, void *arg) {
+    ++*(size_t *) arg;
+    return 0;
+}
+
+// xdl_iterate_phdr with XDL_FULL_PATHNAME, which looks up names that are not absolute
+// in /proc/self/maps, with the process padded to a game-sized map count
+static void bench_maps(const BenchOptions &options) {
+    constexpr size_t kPages = 8000;
+    auto page = (size_t) sysconf(_SC_PAGESIZE);
+    auto pad = (char *) mmap(nullptr, kPages * page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pad == MAP_FAILED) {
+        return;
+    }
+    // alternating protections keep the kernel from merging the pages into one region
+    for (size_t i = 0; i < kPages; i += 2) {
+        mprotect(pad + i * page, page, PROT_NONE);
+    }
+    size_t regions = 0;
+    if (auto maps = fopen("/proc/self/maps", "r")) {
+        for (int c; (c = fgetc(maps)) != EOF;) {
+            regions += c == '\n';
+        }
+        fclose(maps);
+    }
+    size_t objects = 0;
+    xdl_iterate_phdr(count_phdr_cb, &objects, XDL_FULL_PATHNAME);
+    printf("xdl_iterate_phdr full pathname (%zu objects, %zu maps regions)\n", objects, regions);
+    bench_op("iterate", "pass", options.minSeconds, [] {
+        size_t count = 0;
+        xdl_iterate_phdr(count_phdr_cb, &count, XDL_FULL_PATHNAME);
+        return count;
+    });
+    munmap(pad, kPages * page);
+}
+
+// bytes the loader maps for a library, the PT_LOAD segments without debug info
+static size_t mapped_size(const std::string &path) {
+    auto file = fopen(path.data(), "rb");
+    if (!file) {
+        return 0;
+    }
+    size_t size = 0;
+    Elf64_Ehdr ehdr{};
+    if (fread(&ehdr, sizeof(ehdr), 1, file) == 1 && memcmp(ehdr.e_ident, ELFMAG, SELFMAG) == 0 &&
+        ehdr.e_ident[EI_CLASS] == ELFCLASS64) {
+        for (int i = 0; i < ehdr.e_phnum; ++i) {
+            Elf64_Phdr phdr{};
+            if (fseek(file, (long) (ehdr.e_phoff + i * ehdr.e_phentsize), SEEK_SET) != 0 ||
+                fread(&phdr, sizeof(phdr), 1, file) != 1) {
+                break;
+            }
+            if (phdr.p_type == PT_LOAD) {
+                size += phdr.p_memsz;
+            }
+        }
+    }
+    fclose(file);
+    return size;
+}
+
+// What a zygote fork pays to map the module before DLCLOSE_MODULE_LIBRARY drops it:
+// a forked child loads the library with RTLD_NOW and exits, the parent collects the
+// child's minor faults. The stub is what every app maps now, full is the old single
+// library with the dumper linked in.
+static void bench_spawn(const BenchOptions &options) {
+    struct Case {
+        const char *name;
+        std::string path;
+    };
+    Case cases[]{{"fork only",  ""},
+                 {"stub",       options.binDir + "libspawn_stub.so"},
+                 {"stub+dumper", options.binDir + "libspawn_full.so"}};
+    printf("spawn (fork, dlopen, exit)\n");
+    for (auto &c: cases) {
+        size_t mapped = 0;
+        if (!c.path.empty() && (mapped = mapped_size(c.path)) == 0) {
+            fprintf(stderr, "%s: not a 64-bit elf library\n", c.path.data());
+            continue;
+        }
+        size_t spawns = 0;
+        long faults = 0;
+        auto start = Clock::now();
+        double seconds;
+        do {
+            for (int i = 0; i < 100; ++i) {
+                auto pid = fork();
+                if (pid == 0) {
+                    if (!c.path.empty()) {
+                        auto handle = dlopen(c.path.data(), RTLD_NOW | RTLD_LOCAL);
+                        if (!handle) {
+                            _exit(1);
+                        }
+                        dlclose(handle);
+                    }
+                    _exit(0);
+                }
+                int status = 0;
+                struct rusage usage{};
+                if (pid < 0 || wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) ||
+                    WEXITSTATUS(status) != 0) {
+                    fprintf(stderr, "%s: spawn failed\n", c.name);
+                    return;
+                }
+                faults += usage.ru_minflt;
+            }
+            spawns += 100;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (seconds < options.minSeconds);
+        printf("  %-16s %10.1f us/spawn %8.1f faults/spawn %6zu kB mapped\n", c.name,
+               seconds * 1e6 / spawns, (double) faults / spawns, mapped / 1024);
+    }
+}
+
+static int run_scale(const BenchOptions &options, unsigned int types) {
+    // the mock adds mscorlib on top, so split the requested types over ten assemblies
+    MockIl2CppConfig config = MOCK_IL2CPP_DEFAULT_CONFIG;
+    config.assemblies = 10;
+    config.classes_per_assembly = std::max(1u, types / config.assemblies);
+
+    auto handle = dlopen(options.lib.data(), RTLD_NOW);
+    if (!handle) {
+        fprintf(stderr, "dlopen %s: %s\n", options.lib.data(), dlerror());
+        return 1;
+    }
+    auto configure = (decltype(&mock_il2cpp_configure)) dlsym(handle, "mock_il2cpp_configure");
+    if (!configure) {
+        fprintf(stderr, "%s is not the mock libil2cpp.so\n", options.lib.data());
+        return 1;
+    }
+    configure(&config);
+    // resolve the api through xdl like on a device, by file name among loaded libraries
+    auto name = options.lib.substr(options.lib.rfind('/') + 1);
+    auto il2cpp = xdl_open(name.data(), XDL_DEFAULT);
+    if (!il2cpp) {
+        fprintf(stderr, "xdl_open %s failed\n", name.data());
+        return 1;
+    }
+    il2cpp_api_init(il2cpp);
+
+    std::vector<Il2CppClass *> classes;
+    size_t size;
+    auto assemblies = il2cpp_domain_get_assemblies(il2cpp_domain_get(), &size);
+    for (size_t i = 0; i < size; ++i) {
+        auto image = il2cpp_assembly_get_image(assemblies[i]);
+        auto classCount = il2cpp_image_get_class_count(image);
+        for (size_t j = 0; j < classCount; ++j) {
+            classes.push_back(const_cast<Il2CppClass *>(il2cpp_image_get_class(image, j)));
+        }
+    }
+    auto baselineRss = current_rss_kb();
+    printf("%zu types (metadata rss %ld kB)\n", classes.size(), baselineRss);
+
+    report("dump_type", classes.size(), bench_formatter(
+            classes, options.minSeconds, [](Il2CppClass *klass, DumpBuffer &outPut,
+                                            TypeNameCache &names) {
+                dump_type(il2cpp_class_get_type(klass), outPut, names);
+            }));
+    report("dump_field", classes.size(), bench_formatter(classes, options.minSeconds, dump_field));
+    report("dump_property", classes.size(),
+           bench_formatter(classes, options.minSeconds, dump_property));
+    report("dump_method", classes.size(), bench_formatter(classes, options.minSeconds, dump_method));
+    report("il2cpp_dump x1", classes.size(), bench_dump(options, 1, false));
+    auto threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads > 1) {
+        auto name = "il2cpp_dump x" + std::to_string(threads);
+        report(name.data(), classes.size(), bench_dump(options, threads, false));
+    }
+    // the same dump read straight from global-metadata.dat, open() included
+    report("metadata x1", classes.size(), bench_dump(options, 1, true));
+    if (threads > 1) {
+        auto name = "metadata x" + std::to_string(threads);
+        report(name.data(), classes.size(), bench_dump(options, threads, true));
+    }
+    bench_modifiers(options.minSeconds);
+    printf("  %-16s %10ld kB over metadata, %ld kB total\n", "peak rss",
+           peak_rss_kb() - baselineRss, peak_rss_kb());
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --types N        run a single scale, default runs 1000, 10000 and 100000\n"
+            "  --threads N      threads for the parallel dump, 0 uses every core (default 0)\n"
+            "  --min-time S     minimum seconds per formatter benchmark (default 0.5)\n"
+            "  --out DIR        scratch directory for dump.cs (default $TMPDIR or /tmp)\n"
+            "  --lib PATH       mock library (default libil2cpp.so next to this binary)\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    // il2cpp_dump logs every run at info level, keep the table readable
+    setenv("IL2CPPDUMPER_LOG", "warn", 0);
+    BenchOptions options;
+    std::string self = argv[0];
+    auto slash = self.rfind('/');
+    options.binDir = slash == std::string::npos ? "./" : self.substr(0, slash + 1);
+    options.lib = options.binDir + "libil2cpp.so";
+    auto tmp = getenv("TMPDIR");
+    options.outDir = std::string(tmp ? tmp : "/tmp").append("/il2cppdumper_bench");
+    unsigned int types = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        auto arg = argv[i];
+        auto value = argv[++i];
+        if (strcmp(arg, "--types") == 0) {
+            types = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--threads") == 0) {
+            options.threads = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--min-time") == 0) {
+            options.minSeconds = strtod(value, nullptr);
+        } else if (strcmp(arg, "--out") == 0) {
+            options.outDir = value;
+        } else if (strcmp(arg, "--lib") == 0) {
+            options.lib = value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // loaded by absolute path like the android linker does, xdl_open matches on it
+    if (auto path = realpath(options.lib.data(), nullptr)) {
+        options.lib = path;
+        free(path);
+    }
+    mkdir(options.outDir.data(), 0755);
+    mkdir((options.outDir + "/files").data(), 0755);
+    if (types) {
+        return run_scale(options, types);
+    }
+
+    for (auto scale: kDefaultScales) {
+        fflush(stdout);
+        auto pid = fork();
+        if (pid == 0) {
+            auto result = run_scale(options, scale);
+            fflush(stdout);
+            _exit(result);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "scale %u failed\n", scale);
+            return 1;
+        }
+    }
+    bench_targets(options.minSeconds);
+    bench_companion(options.minSeconds);
+    bench_spawn(options);
+    bench_symbols(options);
+    bench_dsym(options);
+    bench_addr(options);
+    bench_debugdata(options);
+    bench_maps(options);
+    return 0;
+}
@@ -0,0 +1,36 @@
+//
+// Host stand-in for liblog.
+//
+
+#include <android/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int min_priority(void) {
+    static int priority = 0;
+    if (priority == 0) {
+        const char *level = getenv("IL2CPPDUMPER_LOG");
+        priority = ANDROID_LOG_INFO;
+        if (level) {
+            if (strcmp(level, "debug") == 0) priority = ANDROID_LOG_DEBUG;
+            else if (strcmp(level, "warn") == 0) priority = ANDROID_LOG_WARN;
+            else if (strcmp(level, "error") == 0) priority = ANDROID_LOG_ERROR;
+            else if (strcmp(level, "silent") == 0) priority = ANDROID_LOG_ERROR + 1;
+        }
+    }
+    return priority;
+}
+
+int __android_log_print(int prio, const char *tag, const char *fmt, ...) {
+    if (prio < min_priority()) {
+        return 0;
+    }
+    static const char levels[] = "??VDIWEF";
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%c/%s: ", prio >= 0 && prio < 8 ? levels[prio] : '?', tag);
+    int n = vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    return n;
+}
@@ -0,0 +1,151 @@
+//
+// Runs the dumper on the host against the mock libil2cpp.so.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include "il2cpp_dump.h"
+#include "mock_il2cpp.h"
+#include "snapshot_reader.h"
+#include "xdl.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --out DIR            output directory, dump.cs goes to DIR/files (default .)\n"
+            "  --lib PATH           mock library (default libil2cpp.so next to this binary)\n"
+            "  --threads N          formatting threads, 0 uses every core (default 1)\n"
+            "  --snapshot           also write files/dump.bin, then read it back and check it\n"
+            "                       against files/dump.cs\n"
+            "  --metadata           dump from the mapped global-metadata.dat, not the api\n"
+            "  --metadata-version N global-metadata.dat version the mock maps, 24, 27, 29 or\n"
+            "                       31, 0 maps none (default 29)\n"
+            "  --assemblies N       synthetic assemblies besides mscorlib.dll\n"
+            "  --classes N          classes per assembly\n"
+            "  --methods N          methods per class\n"
+            "  --fields N           fields per class\n"
+            "  --properties N       properties per class\n"
+            "  --generic-every N    every n-th class is generic, 0 disables generics\n"
+            "  --nesting N          length of nested type chains, 0 disables nesting\n"
+            "  --init-delay MS      call il2cpp_init from the mock libunity.so after MS, so the\n"
+            "                       dumper has to wait for it\n",
+            argv0);
+}
+
+static std::string default_lib(const char *argv0) {
+    std::string path = argv0;
+    auto slash = path.rfind('/');
+    return slash == std::string::npos ? "./libil2cpp.so" : path.substr(0, slash + 1) + "libil2cpp.so";
+}
+
+int main(int argc, char **argv) {
+    MockIl2CppConfig config = MOCK_IL2CPP_DEFAULT_CONFIG;
+    DumpOptions options;
+    std::string outDir = ".";
+    std::string lib = default_lib(argv[0]);
+    int initDelay = -1;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = argv[i];
+        if (strcmp(arg, "--snapshot") == 0) {
+            options.snapshot = true;
+            continue;
+        }
+        if (strcmp(arg, "--metadata") == 0) {
+            options.metadata = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        auto value = argv[++i];
+        auto number = (uint32_t) strtoul(value, nullptr, 10);
+        if (strcmp(arg, "--out") == 0) {
+            outDir = value;
+        } else if (strcmp(arg, "--lib") == 0) {
+            lib = value;
+        } else if (strcmp(arg, "--threads") == 0) {
+            options.threads = number;
+        } else if (strcmp(arg, "--assemblies") == 0) {
+            config.assemblies = number;
+        } else if (strcmp(arg, "--classes") == 0) {
+            config.classes_per_assembly = number;
+        } else if (strcmp(arg, "--methods") == 0) {
+            config.methods_per_class = number;
+        } else if (strcmp(arg, "--fields") == 0) {
+            config.fields_per_class = number;
+        } else if (strcmp(arg, "--properties") == 0) {
+            config.properties_per_class = number;
+        } else if (strcmp(arg, "--generic-every") == 0) {
+            config.generic_every = number;
+        } else if (strcmp(arg, "--nesting") == 0) {
+            config.nesting_depth = number;
+        } else if (strcmp(arg, "--metadata-version") == 0) {
+            config.metadata_version = number;
+        } else if (strcmp(arg, "--init-delay") == 0) {
+            initDelay = (int) number;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // loaded by absolute path like the android linker does, xdl_open matches on it
+    if (auto path = realpath(lib.data(), nullptr)) {
+        lib = path;
+        free(path);
+    }
+    auto handle = dlopen(lib.data(), RTLD_NOW);
+    if (!handle) {
+        fprintf(stderr, "dlopen %s: %s\n", lib.data(), dlerror());
+        return 1;
+    }
+    auto configure = (decltype(&mock_il2cpp_configure)) dlsym(handle, "mock_il2cpp_configure");
+    if (!configure) {
+        fprintf(stderr, "%s is not the mock libil2cpp.so\n", lib.data());
+        return 1;
+    }
+    config.deferred_init = initDelay >= 0;
+    configure(&config);
+    if (initDelay >= 0) {
+        auto unityPath = lib.substr(0, lib.rfind('/') + 1) + "libunity.so";
+        auto unity = dlopen(unityPath.data(), RTLD_NOW);
+        auto start = unity ? (int (*)(void *, unsigned int)) dlsym(unity, "mock_unity_start")
+                           : nullptr;
+        if (!start || start(handle, initDelay) != 0) {
+            fprintf(stderr, "failed to start %s\n", unityPath.data());
+            return 1;
+        }
+    }
+
+    mkdir(outDir.data(), 0755);
+    mkdir((outDir + "/files").data(), 0755);
+    // resolve the api through xdl like on a device, by file name among loaded libraries
+    auto name = lib.substr(lib.rfind('/') + 1);
+    auto il2cpp = xdl_open(name.data(), XDL_DEFAULT);
+    if (!il2cpp) {
+        fprintf(stderr, "xdl_open %s failed\n", name.data());
+        return 1;
+    }
+    il2cpp_api_init(il2cpp);
+    il2cpp_dump(outDir.data(), options);
+    if (options.snapshot) {
+        auto snapshotPath = outDir + "/files/dump.bin";
+        auto dumpPath = outDir + "/files/dump.cs";
+        SnapshotSummary summary;
+        if (!verify_snapshot(snapshotPath.data(), dumpPath.data(), summary)) {
+            fprintf(stderr, "%s does not match %s\n", snapshotPath.data(), dumpPath.data());
+            return 1;
+        }
+        printf("%s: %zu images, %zu types, %zu interfaces, %zu fields, %zu properties, "
+               "%zu methods, %zu parameters, %zu string bytes, matches dump.cs\n",
+               snapshotPath.data(), summary.images, summary.types, summary.interfaces,
+               summary.fields, summary.properties, summary.methods, summary.parameters,
+               summary.string_bytes);
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+//
+// Host stand-in for <android/api-level.h>, for building xDL on Linux.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_HOST_ANDROID_API_LEVEL_H
+#define ZYGISK_IL2CPPDUMPER_HOST_ANDROID_API_LEVEL_H
+
+#define __ANDROID_API_FUTURE__ 10000
+#define __ANDROID_API_G__ 9
+#define __ANDROID_API_I__ 14
+#define __ANDROID_API_J__ 16
+#define __ANDROID_API_J_MR1__ 17
+#define __ANDROID_API_J_MR2__ 18
+#define __ANDROID_API_K__ 19
+#define __ANDROID_API_L__ 21
+#define __ANDROID_API_L_MR1__ 22
+#define __ANDROID_API_M__ 23
+#define __ANDROID_API_N__ 24
+#define __ANDROID_API_N_MR1__ 25
+#define __ANDROID_API_O__ 26
+#define __ANDROID_API_O_MR1__ 27
+#define __ANDROID_API_P__ 28
+#define __ANDROID_API_Q__ 29
+#define __ANDROID_API_R__ 30
+#define __ANDROID_API_S__ 31
+#define __ANDROID_API_T__ 33
+#define __ANDROID_API_U__ 34
+
+// the linker paths xDL takes for recent releases also work on glibc
+static inline int android_get_device_api_level(void) {
+    return __ANDROID_API_T__;
+}
+
+#endif //ZYGISK_IL2CPPDUMPER_HOST_ANDROID_API_LEVEL_H
@@ -0,0 +1,78 @@
+//
+// Host stand-in for the XzUnpacker part of Android's liblzma.so (the LZMA SDK), on top
+// of xz's liblzma, so xDL can decompress .gnu_debugdata on Linux.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <lzma.h>
+
+#define SZ_OK 0
+#define SZ_ERROR_DATA 1
+#define SZ_ERROR_MEM 2
+
+enum {
+    CODER_STATUS_NOT_SPECIFIED,
+    CODER_STATUS_FINISHED_WITH_MARK,
+    CODER_STATUS_NOT_FINISHED,
+    CODER_STATUS_NEEDS_MORE_INPUT
+};
+
+// lives in the state buffer xDL passes in
+struct XzUnpacker {
+    lzma_stream stream;
+    int ready;
+    int finished;
+};
+
+__attribute__((visibility("default"))) void CrcGenerateTable(void) {}
+
+__attribute__((visibility("default"))) void Crc64GenerateTable(void) {}
+
+__attribute__((visibility("default"))) void XzUnpacker_Construct(void *p, const void *alloc) {
+    (void) alloc;
+    struct XzUnpacker *unpacker = p;
+    lzma_stream init = LZMA_STREAM_INIT;
+    unpacker->stream = init;
+    unpacker->finished = 0;
+    unpacker->ready = lzma_stream_decoder(&unpacker->stream, UINT64_MAX, 0) == LZMA_OK;
+}
+
+__attribute__((visibility("default"))) int XzUnpacker_IsStreamWasFinished(const void *p) {
+    return ((const struct XzUnpacker *) p)->finished;
+}
+
+__attribute__((visibility("default"))) void XzUnpacker_Free(void *p) {
+    lzma_end(&((struct XzUnpacker *) p)->stream);
+}
+
+// the signature since Android Q, with srcFinished
+__attribute__((visibility("default"))) int XzUnpacker_Code(void *p, uint8_t *dest, size_t *destLen,
+                                                         const uint8_t *src, size_t *srcLen,
+                                                         int srcFinished, int finishMode,
+                                                         int *status) {
+    (void) srcFinished;
+    (void) finishMode;
+    struct XzUnpacker *unpacker = p;
+    if (!unpacker->ready) {
+        return SZ_ERROR_MEM;
+    }
+    unpacker->stream.next_in = src;
+    unpacker->stream.avail_in = *srcLen;
+    unpacker->stream.next_out = dest;
+    unpacker->stream.avail_out = *destLen;
+    lzma_ret ret = lzma_code(&unpacker->stream, LZMA_RUN);
+    *srcLen -= unpacker->stream.avail_in;
+    *destLen -= unpacker->stream.avail_out;
+    if (ret == LZMA_STREAM_END) {
+        unpacker->finished = 1;
+        *status = CODER_STATUS_FINISHED_WITH_MARK;
+        return SZ_OK;
+    }
+    if (ret != LZMA_OK && ret != LZMA_BUF_ERROR) {
+        return SZ_ERROR_DATA;
+    }
+    *status = unpacker->stream.avail_out == 0 ? CODER_STATUS_NOT_FINISHED
+                                              : CODER_STATUS_NEEDS_MORE_INPUT;
+    return SZ_OK;
+}
@@ -0,0 +1,1218 @@
+//
+// Host stand-in for libil2cpp.so. Builds synthetic metadata on first use and
+// serves it through the il2cpp api, so the dumper can run on a plain Linux box.
+//
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "il2cpp-class.h"
+#include "il2cpp-tabledefs.h"
+#include "mock_il2cpp.h"
+
+#define MOCK_API extern "C" __attribute__((visibility("default")))
+
+// Il2CppMetadataRegistration, and codeGenModulesCount and codeGenModules from the end of
+// Il2CppCodeRegistration. Only the dumper reads them, so they must not have internal
+// linkage or the compiler drops the stores.
+uintptr_t g_MetadataRegistration[16];
+uintptr_t g_CodeRegistrationModules[2];
+
+struct Il2CppAssembly {
+    Il2CppImage *image;
+};
+
+struct Il2CppImage {
+    std::string name;
+    std::vector<Il2CppClass *> classes;
+};
+
+struct Il2CppDomain {
+    std::vector<const Il2CppAssembly *> assemblies;
+};
+
+struct FieldInfo {
+    std::string name;
+    const Il2CppType *type;
+    int flags;
+    size_t offset;
+    uint64_t value;
+};
+
+struct MockParam {
+    std::string name;
+    const Il2CppType *type;
+};
+
+// MethodInfo only declares methodPointer, which has to stay the first member
+struct MockMethod {
+    MethodInfo info;
+    std::string name;
+    uint32_t flags;
+    uint32_t iflags;
+    uint32_t token;
+    const Il2CppType *return_type;
+    std::vector<MockParam> params;
+};
+
+struct PropertyInfo {
+    std::string name;
+    const MethodInfo *get;
+    const MethodInfo *set;
+    uint32_t flags;
+};
+
+struct Il2CppClass {
+    Il2CppType byval_arg;
+    std::string name;
+    std::string namespaze;
+    Il2CppImage *image = nullptr;
+    Il2CppClass *parent = nullptr;
+    Il2CppClass *declaring = nullptr;
+    std::vector<std::string> generic_params;
+    uint32_t flags = TYPE_ATTRIBUTE_PUBLIC;
+    uint32_t token = 0;
+    bool valuetype = false;
+    bool enumtype = false;
+    std::vector<Il2CppClass *> interfaces;
+    std::vector<FieldInfo> fields;
+    std::deque<MockMethod> methods;
+    std::vector<PropertyInfo> properties;
+};
+
+namespace {
+
+MockIl2CppConfig config = MOCK_IL2CPP_DEFAULT_CONFIG;
+std::once_flag build_once;
+// cleared by deferred_init until il2cpp_init is called
+std::atomic<bool> vm_ready{true};
+// global-metadata.dat, made readable by il2cpp_init with deferred_init
+std::pair<const void *, size_t> metadata_mapping;
+
+// everything below is written once by build() and only read afterwards,
+// so the api is safe to call from several dump threads
+Il2CppDomain domain;
+std::deque<Il2CppAssembly> assemblies;
+std::deque<Il2CppImage> images;
+std::deque<Il2CppClass> classes;
+std::deque<Il2CppType> types;
+std::deque<Il2CppArrayType> array_types;
+std::deque<Il2CppGenericClass> generic_classes;
+std::deque<Il2CppGenericInst> generic_insts;
+std::deque<std::vector<const Il2CppType *>> generic_args;
+// class behind types whose data union does not point at it
+std::unordered_map<const Il2CppType *, Il2CppClass *> type_classes;
+// the runtime shares array and generic instance types, so does the mock
+std::unordered_map<const Il2CppType *, const Il2CppType *> array_cache;
+std::map<std::vector<const Il2CppType *>, const Il2CppType *> instance_cache;
+std::map<std::pair<Il2CppClass *, size_t>, const Il2CppType *> param_cache;
+uintptr_t code_base;
+uint32_t next_method_token = 0x06000001;
+uint32_t next_type_token = 0x02000001;
+
+struct Corlib {
+    Il2CppClass *object, *value_type, *enum_type, *string, *void_type, *boolean, *int32, *int64,
+            *single, *double_type, *byte, *list, *dictionary, *enumerable, *disposable;
+} corlib;
+
+Il2CppClass *new_class(Il2CppImage *image, const char *namespaze, const char *name,
+                       Il2CppTypeEnum type) {
+    auto &klass = classes.emplace_back();
+    klass.name = name;
+    klass.namespaze = namespaze;
+    klass.image = image;
+    klass.token = next_type_token++;
+    klass.byval_arg.type = type;
+    klass.byval_arg.data.dummy = &klass;
+    image->classes.push_back(&klass);
+    return &klass;
+}
+
+Il2CppType *new_type(Il2CppTypeEnum type, Il2CppClass *klass) {
+    auto &t = types.emplace_back();
+    t.type = type;
+    t.data.dummy = klass;
+    return &t;
+}
+
+const Il2CppType *array_of(const Il2CppType *element) {
+    auto &cached = array_cache[element];
+    if (cached) {
+        return cached;
+    }
+    auto &t = types.emplace_back();
+    t.type = IL2CPP_TYPE_SZARRAY;
+    t.data.type = element;
+    auto &klass = classes.emplace_back();
+    klass.name = type_classes.count(element) ? type_classes[element]->name + "[]" : "Array";
+    klass.byval_arg = t;
+    type_classes[&t] = &klass;
+    return cached = &t;
+}
+
+const Il2CppType *multi_array_of(const Il2CppType *element, uint8_t rank) {
+    auto &array = array_types.emplace_back();
+    array.etype = element;
+    array.rank = rank;
+    auto &t = types.emplace_back();
+    t.type = IL2CPP_TYPE_ARRAY;
+    t.data.array = &array;
+    auto &klass = classes.emplace_back();
+    klass.name = "Array";
+    klass.byval_arg = t;
+    type_classes[&t] = &klass;
+    return &t;
+}
+
+const Il2CppType *pointer_to(const Il2CppType *element) {
+    auto &t = types.emplace_back();
+    t.type = IL2CPP_TYPE_PTR;
+    t.data.type = element;
+    auto &klass = classes.emplace_back();
+    klass.name = "Pointer";
+    klass.byval_arg = t;
+    type_classes[&t] = &klass;
+    return &t;
+}
+
+const Il2CppType *generic_param(Il2CppClass *owner, size_t index) {
+    auto &cached = param_cache[{owner, index}];
+    if (cached) {
+        return cached;
+    }
+    auto &param = classes.emplace_back();
+    param.name = owner->generic_params[index];
+    return cached = new_type(IL2CPP_TYPE_VAR, &param);
+}
+
+const Il2CppType *instantiate(Il2CppClass *definition,
+                              std::vector<const Il2CppType *> arguments) {
+    arguments.insert(arguments.begin(), &definition->byval_arg);
+    auto &cached = instance_cache[arguments];
+    if (cached) {
+        return cached;
+    }
+    arguments.erase(arguments.begin());
+    auto &args = generic_args.emplace_back(std::move(arguments));
+    auto &inst = generic_insts.emplace_back();
+    inst.type_argc = args.size();
+    inst.type_argv = args.data();
+    auto &generic = generic_classes.emplace_back();
+    generic.type = &definition->byval_arg;
+    generic.context.class_inst = &inst;
+    auto &inflated = classes.emplace_back();
+    inflated.name = definition->name;
+    inflated.namespaze = definition->namespaze;
+    inflated.image = definition->image;
+    inflated.parent = definition->parent;
+    inflated.declaring = definition->declaring;
+    inflated.flags = definition->flags;
+    inflated.token = definition->token;
+    generic.cached_class = &inflated;
+    auto &t = types.emplace_back();
+    t.type = IL2CPP_TYPE_GENERICINST;
+    t.data.generic_class = &generic;
+    inflated.byval_arg = t;
+    return cached = &t;
+}
+
+// parameters carry their attributes in the type, so each one gets its own copy
+const Il2CppType *param_type(const Il2CppType *type, uint16_t attrs, bool byref) {
+    auto &t = types.emplace_back(*type);
+    t.attrs = attrs;
+    t.byref = byref;
+    auto it = type_classes.find(type);
+    if (it != type_classes.end()) {
+        type_classes[&t] = it->second;
+    }
+    return &t;
+}
+
+MockMethod *add_method(Il2CppClass *klass, std::string name, uint32_t flags,
+                       const Il2CppType *return_type) {
+    auto &method = klass->methods.emplace_back();
+    method.name = std::move(name);
+    method.flags = flags;
+    method.iflags = 0;
+    method.token = next_method_token++;
+    method.return_type = return_type;
+    if (!(flags & METHOD_ATTRIBUTE_ABSTRACT)) {
+        // never called, only has to look like an address inside this library
+        method.info.methodPointer = (Il2CppMethodPointer) (code_base + 0x10000 +
+                                                           (method.token & 0xffffff) * 0x20);
+    }
+    return &method;
+}
+
+void build_corlib() {
+    auto &image = images.emplace_back();
+    image.name = "mscorlib.dll";
+    auto &assembly = assemblies.emplace_back();
+    assembly.image = &image;
+    domain.assemblies.push_back(&assembly);
+
+    corlib.object = new_class(&image, "System", "Object", IL2CPP_TYPE_OBJECT);
+    corlib.value_type = new_class(&image, "System", "ValueType", IL2CPP_TYPE_CLASS);
+    corlib.value_type->parent = corlib.object;
+    corlib.value_type->flags |= TYPE_ATTRIBUTE_ABSTRACT | TYPE_ATTRIBUTE_SERIALIZABLE;
+    corlib.enum_type = new_class(&image, "System", "Enum", IL2CPP_TYPE_CLASS);
+    corlib.enum_type->parent = corlib.value_type;
+    corlib.enum_type->flags |= TYPE_ATTRIBUTE_ABSTRACT | TYPE_ATTRIBUTE_SERIALIZABLE;
+    corlib.string = new_class(&image, "System", "String", IL2CPP_TYPE_STRING);
+    corlib.string->parent = corlib.object;
+    corlib.string->flags |= TYPE_ATTRIBUTE_SEALED | TYPE_ATTRIBUTE_SERIALIZABLE;
+    auto primitive = [&](const char *name, Il2CppTypeEnum type) {
+        auto klass = new_class(&image, "System", name, type);
+        klass->parent = corlib.value_type;
+        klass->valuetype = true;
+        klass->flags |= TYPE_ATTRIBUTE_SEALED | TYPE_ATTRIBUTE_SERIALIZABLE;
+        return klass;
+    };
+    corlib.void_type = primitive("Void", IL2CPP_TYPE_VOID);
+    corlib.boolean = primitive("Boolean", IL2CPP_TYPE_BOOLEAN);
+    corlib.byte = primitive("Byte", IL2CPP_TYPE_U1);
+    corlib.int32 = primitive("Int32", IL2CPP_TYPE_I4);
+    corlib.int64 = primitive("Int64", IL2CPP_TYPE_I8);
+    corlib.single = primitive("Single", IL2CPP_TYPE_R4);
+    corlib.double_type = primitive("Double", IL2CPP_TYPE_R8);
+    corlib.int32->fields.push_back({"m_value", &corlib.int32->byval_arg,
+                                    FIELD_ATTRIBUTE_ASSEMBLY, 0x10, 0});
+
+    corlib.disposable = new_class(&image, "System", "IDisposable", IL2CPP_TYPE_CLASS);
+    corlib.disposable->flags |= TYPE_ATTRIBUTE_INTERFACE | TYPE_ATTRIBUTE_ABSTRACT;
+    add_method(corlib.disposable, "Dispose",
+               METHOD_ATTRIBUTE_PUBLIC | METHOD_ATTRIBUTE_VIRTUAL | METHOD_ATTRIBUTE_ABSTRACT |
+               METHOD_ATTRIBUTE_NEW_SLOT, &corlib.void_type->byval_arg);
+
+    corlib.enumerable = new_class(&image, "System.Collections.Generic", "IEnumerable`1",
+                                  IL2CPP_TYPE_CLASS);
+    corlib.enumerable->flags |= TYPE_ATTRIBUTE_INTERFACE | TYPE_ATTRIBUTE_ABSTRACT;
+    corlib.enumerable->generic_params = {"T"};
+
+    corlib.list = new_class(&image, "System.Collections.Generic", "List`1", IL2CPP_TYPE_CLASS);
+    corlib.list->parent = corlib.object;
+    corlib.list->generic_params = {"T"};
+    auto list_t = generic_param(corlib.list, 0);
+    auto enumerable = instantiate(corlib.enumerable, {list_t});
+    corlib.list->interfaces.push_back(enumerable->data.generic_class->cached_class);
+    corlib.list->fields.push_back({"_items", array_of(list_t), FIELD_ATTRIBUTE_PRIVATE, 0x10, 0});
+    corlib.list->fields.push_back({"_size", &corlib.int32->byval_arg, FIELD_ATTRIBUTE_PRIVATE,
+                                   0x18, 0});
+    auto add = add_method(corlib.list, "Add", METHOD_ATTRIBUTE_PUBLIC,
+                          &corlib.void_type->byval_arg);
+    add->params.push_back({"item", list_t});
+
+    corlib.dictionary = new_class(&image, "System.Collections.Generic", "Dictionary`2",
+                                  IL2CPP_TYPE_CLASS);
+    corlib.dictionary->parent = corlib.object;
+    corlib.dictionary->generic_params = {"TKey", "TValue"};
+    auto key_collection = new_class(&image, "", "KeyCollection", IL2CPP_TYPE_CLASS);
+    key_collection->parent = corlib.object;
+    key_collection->declaring = corlib.dictionary;
+    key_collection->flags = TYPE_ATTRIBUTE_NESTED_PUBLIC | TYPE_ATTRIBUTE_SEALED;
+    key_collection->generic_params = {"TKey", "TValue"};
+    auto try_get = add_method(corlib.dictionary, "TryGetValue", METHOD_ATTRIBUTE_PUBLIC,
+                              &corlib.boolean->byval_arg);
+    try_get->params.push_back({"key", generic_param(corlib.dictionary, 0)});
+    try_get->params.push_back({"value", param_type(generic_param(corlib.dictionary, 1),
+                                                   PARAM_ATTRIBUTE_OUT, true)});
+}
+
+const Il2CppType *pick_type(size_t seed, Il2CppImage &image, Il2CppClass *owner) {
+    auto &image_classes = image.classes;
+    auto other = image_classes.empty() ? corlib.object : image_classes[seed % image_classes.size()];
+    switch (seed % 10) {
+        case 0:
+            return &corlib.int32->byval_arg;
+        case 1:
+            return &corlib.string->byval_arg;
+        case 2:
+            return &corlib.single->byval_arg;
+        case 3:
+            return &other->byval_arg;
+        case 4:
+            return instantiate(corlib.list, {&other->byval_arg});
+        case 5:
+            return instantiate(corlib.dictionary, {&corlib.int32->byval_arg, &other->byval_arg});
+        case 6:
+            return array_of(&other->byval_arg);
+        case 7: {
+            static auto matrix = multi_array_of(&corlib.int32->byval_arg, 2);
+            return matrix;
+        }
+        case 8:
+            if (!owner->generic_params.empty()) {
+                return generic_param(owner, seed % owner->generic_params.size());
+            }
+            return &corlib.boolean->byval_arg;
+        default:
+            return owner->valuetype ? pointer_to(&corlib.byte->byval_arg)
+                                    : &corlib.int64->byval_arg;
+    }
+}
+
+constexpr uint32_t kMethodAccess[] = {METHOD_ATTRIBUTE_PUBLIC, METHOD_ATTRIBUTE_PRIVATE,
+                                      METHOD_ATTRIBUTE_FAMILY, METHOD_ATTRIBUTE_ASSEM,
+                                      METHOD_ATTRIBUTE_FAM_OR_ASSEM};
+constexpr uint32_t kFieldAccess[] = {FIELD_ATTRIBUTE_PRIVATE, FIELD_ATTRIBUTE_PUBLIC,
+                                     FIELD_ATTRIBUTE_FAMILY, FIELD_ATTRIBUTE_ASSEMBLY};
+
+void fill_class(Il2CppClass *klass, Il2CppImage &image, size_t index) {
+    if (klass->enumtype) {
+        klass->fields.push_back({"value__", &corlib.int32->byval_arg,
+                                 FIELD_ATTRIBUTE_PUBLIC | FIELD_ATTRIBUTE_SPECIAL_NAME |
+                                 FIELD_ATTRIBUTE_RT_SPECIAL_NAME, 0x10, 0});
+        for (uint32_t i = 0; i < config.fields_per_class; ++i) {
+            klass->fields.push_back({"Value" + std::to_string(i), &klass->byval_arg,
+                                     FIELD_ATTRIBUTE_PUBLIC | FIELD_ATTRIBUTE_STATIC |
+                                     FIELD_ATTRIBUTE_LITERAL, 0, i});
+        }
+        return;
+    }
+    bool is_interface = klass->flags & TYPE_ATTRIBUTE_INTERFACE;
+    if (!is_interface) {
+        size_t offset = 0x10;
+        for (uint32_t i = 0; i < config.fields_per_class; ++i) {
+            int flags = kFieldAccess[i % std::size(kFieldAccess)];
+            if (i % 5 == 3) {
+                flags |= FIELD_ATTRIBUTE_STATIC;
+            }
+            if (i % 7 == 6) {
+                flags |= FIELD_ATTRIBUTE_INIT_ONLY;
+            }
+            klass->fields.push_back({"field" + std::to_string(i),
+                                     pick_type(index * 31 + i, image, klass), flags,
+                                     flags & FIELD_ATTRIBUTE_STATIC ? 0 : offset, 0});
+            if (!(flags & FIELD_ATTRIBUTE_STATIC)) {
+                offset += 8;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < config.methods_per_class; ++i) {
+        uint32_t flags = kMethodAccess[i % std::size(kMethodAccess)] |
+                         METHOD_ATTRIBUTE_HIDE_BY_SIG;
+        if (is_interface) {
+            flags = METHOD_ATTRIBUTE_PUBLIC | METHOD_ATTRIBUTE_VIRTUAL |
+                    METHOD_ATTRIBUTE_ABSTRACT | METHOD_ATTRIBUTE_NEW_SLOT;
+        } else if (i % 6 == 1) {
+            flags |= METHOD_ATTRIBUTE_STATIC;
+        } else if (i % 6 == 2) {
+            flags |= METHOD_ATTRIBUTE_VIRTUAL | METHOD_ATTRIBUTE_NEW_SLOT;
+        } else if (i % 6 == 3 && klass->parent != corlib.object) {
+            flags |= METHOD_ATTRIBUTE_VIRTUAL;
+        }
+        auto return_type = i % 3 == 0 ? &corlib.void_type->byval_arg
+                                      : pick_type(index * 17 + i, image, klass);
+        auto method = add_method(klass, "Method" + std::to_string(i), flags, return_type);
+        for (uint32_t p = 0; p < i % 4; ++p) {
+            auto type = pick_type(index * 13 + i * 3 + p, image, klass);
+            switch ((i + p) % 5) {
+                case 1:
+                    type = param_type(type, PARAM_ATTRIBUTE_OUT, true);
+                    break;
+                case 2:
+                    type = param_type(type, 0, true);
+                    break;
+                default:
+                    break;
+            }
+            method->params.push_back({"arg" + std::to_string(p), type});
+        }
+    }
+    for (uint32_t i = 0; i < config.properties_per_class; ++i) {
+        auto name = "Property" + std::to_string(i);
+        auto type = pick_type(index * 7 + i, image, klass);
+        uint32_t flags = METHOD_ATTRIBUTE_PUBLIC | METHOD_ATTRIBUTE_SPECIAL_NAME |
+                         METHOD_ATTRIBUTE_HIDE_BY_SIG;
+        if (is_interface) {
+            flags |= METHOD_ATTRIBUTE_VIRTUAL | METHOD_ATTRIBUTE_ABSTRACT |
+                     METHOD_ATTRIBUTE_NEW_SLOT;
+        }
+        auto get = add_method(klass, "get_" + name, flags, type);
+        const MockMethod *set = nullptr;
+        if (i % 2 == 0) {
+            auto setter = add_method(klass, "set_" + name, flags, &corlib.void_type->byval_arg);
+            setter->params.push_back({"value", type});
+            set = setter;
+        }
+        klass->properties.push_back({name, &get->info, set ? &set->info : nullptr, 0});
+    }
+}
+
+void build_assembly(uint32_t number) {
+    auto &image = images.emplace_back();
+    image.name = number == 0 ? "Assembly-CSharp.dll"
+                             : "Assembly-CSharp-" + std::to_string(number) + ".dll";
+    auto &assembly = assemblies.emplace_back();
+    assembly.image = &image;
+    domain.assemblies.push_back(&assembly);
+    auto namespaze = number == 0 ? std::string() : "Game.Module" + std::to_string(number);
+
+    for (uint32_t c = 0; c < config.classes_per_assembly; ++c) {
+        auto name = "Class" + std::to_string(c);
+        Il2CppClass *klass;
+        if (c % 13 == 12) {
+            klass = new_class(&image, namespaze.data(), ("I" + name).data(), IL2CPP_TYPE_CLASS);
+            klass->flags |= TYPE_ATTRIBUTE_INTERFACE | TYPE_ATTRIBUTE_ABSTRACT;
+        } else if (c % 10 == 9) {
+            klass = new_class(&image, namespaze.data(), (name + "Kind").data(),
+                              IL2CPP_TYPE_VALUETYPE);
+            klass->parent = corlib.enum_type;
+            klass->valuetype = true;
+            klass->enumtype = true;
+            klass->flags |= TYPE_ATTRIBUTE_SEALED;
+        } else if (c % 7 == 6) {
+            klass = new_class(&image, namespaze.data(), (name + "Data").data(),
+                              IL2CPP_TYPE_VALUETYPE);
+            klass->parent = corlib.value_type;
+            klass->valuetype = true;
+            klass->flags |= TYPE_ATTRIBUTE_SEALED | TYPE_ATTRIBUTE_SERIALIZABLE;
+        } else {
+            klass = new_class(&image, namespaze.data(), name.data(), IL2CPP_TYPE_CLASS);
+            klass->parent = corlib.object;
+            if (config.generic_every && c % config.generic_every == 0) {
+                klass->name += c % 2 ? "`2" : "`1";
+                klass->generic_params = c % 2 ? std::vector<std::string>{"TKey", "TValue"}
+                                              : std::vector<std::string>{"T"};
+            } else if (c % 4 == 1 && c > 0) {
+                auto base = image.classes[c - 1];
+                if (!(base->flags & TYPE_ATTRIBUTE_INTERFACE) && !base->valuetype &&
+                    !(base->flags & TYPE_ATTRIBUTE_SEALED)) {
+                    klass->parent = base->generic_params.empty() ? base : corlib.object;
+                }
+            } else if (c % 4 == 2) {
+                klass->flags |= TYPE_ATTRIBUTE_SEALED;
+            } else if (c % 4 == 3) {
+                klass->flags |= TYPE_ATTRIBUTE_ABSTRACT;
+            }
+            if (c % 3 == 0) {
+                klass->interfaces.push_back(corlib.disposable);
+            }
+        }
+        if (config.nesting_depth && c % (config.nesting_depth + 1) != 0) {
+            klass->declaring = image.classes[c - 1];
+            klass->namespaze.clear();
+            klass->flags = (klass->flags & ~TYPE_ATTRIBUTE_VISIBILITY_MASK) |
+                           (c % 2 ? TYPE_ATTRIBUTE_NESTED_PUBLIC : TYPE_ATTRIBUTE_NESTED_PRIVATE);
+        }
+    }
+    for (uint32_t c = 0; c < config.classes_per_assembly; ++c) {
+        fill_class(image.classes[c], image, c);
+    }
+}
+
+// global-metadata.dat in the layout of config.metadata_version, mapped from a memfd of
+// that name like il2cpp maps the file, plus the registrations pointing into it
+
+class MetadataEmitter {
+public:
+    explicit MetadataEmitter(uint32_t version) : version_(version) {}
+
+    void emit();
+
+private:
+    enum Section {
+        Strings, Properties, Methods, FieldDefaultValues, DefaultValueData, Parameters, Fields,
+        GenericParameters, GenericContainers, Interfaces, TypeDefinitions, Images, SectionCount
+    };
+
+    static constexpr uint32_t kHeaderFields[SectionCount] = {24, 40, 48, 64, 72, 88, 96, 104,
+                                                             120, 136, 160, 168};
+    static constexpr uint32_t kHeaderSize = 264;
+
+    template<typename T>
+    static void store(std::vector<uint8_t> &out, size_t offset, T value) {
+        memcpy(out.data() + offset, &value, sizeof(value));
+    }
+
+    // appends a zeroed record and returns its offset
+    static size_t record(std::vector<uint8_t> &out, size_t size) {
+        auto offset = out.size();
+        out.resize(offset + size);
+        return offset;
+    }
+
+    uint32_t string(const std::string &str);
+
+    // index in the registration's types, attrs -1 keeps the attributes of the type
+    int32_t type_index(const Il2CppType *type, int attrs = -1);
+
+    void add_type_definition(Il2CppClass *klass, size_t image);
+
+    // handles as il2cpp leaves them, indices before 2020.2 and pointers into the
+    // metadata once the runtime initialized them after
+    uintptr_t handle(Section section, uint32_t record, int32_t index) const;
+
+    const Il2CppType *binary_type(const Il2CppType *type);
+
+    uint32_t version_;
+    std::vector<uint8_t> sections_[SectionCount];
+    const uint8_t *mapped_ = nullptr;
+    uint32_t offsets_[SectionCount]{};
+    std::unordered_map<std::string, uint32_t> strings_;
+    std::unordered_map<const Il2CppClass *, int32_t> type_definitions_;
+    // generic parameter classes, see generic_param
+    std::unordered_map<const void *, int32_t> generic_parameters_;
+    std::map<std::pair<const Il2CppType *, int>, int32_t> type_indices_;
+    std::vector<std::pair<const Il2CppType *, int>> type_entries_;
+    std::unordered_map<const Il2CppType *, const Il2CppType *> binary_types_;
+    // every array below outlives the process, the dumper reads them through the registrations
+    std::vector<std::vector<int32_t>> field_offsets_;
+    std::vector<std::vector<void *>> method_pointers_;
+};
+
+std::deque<Il2CppType> metadata_types;
+std::deque<Il2CppArrayType> metadata_array_types;
+std::deque<Il2CppGenericClass> metadata_generic_classes;
+std::deque<Il2CppGenericInst> metadata_generic_insts;
+std::deque<std::vector<const Il2CppType *>> metadata_generic_args;
+std::vector<const Il2CppType *> metadata_type_table;
+std::deque<std::vector<int32_t>> metadata_field_offsets;
+std::vector<const int32_t *> metadata_field_offset_table;
+std::deque<std::vector<void *>> metadata_method_pointers;
+std::deque<std::array<uintptr_t, 3>> metadata_code_gen_modules;
+std::vector<const void *> metadata_code_gen_module_table;
+
+uint32_t MetadataEmitter::string(const std::string &str) {
+    auto [it, inserted] = strings_.try_emplace(str, (uint32_t) sections_[Strings].size());
+    if (inserted) {
+        auto &out = sections_[Strings];
+        out.insert(out.end(), str.begin(), str.end());
+        out.push_back(0);
+    }
+    return it->second;
+}
+
+int32_t MetadataEmitter::type_index(const Il2CppType *type, int attrs) {
+    auto [it, inserted] = type_indices_.try_emplace({type, attrs},
+                                                    (int32_t) type_entries_.size());
+    if (inserted) {
+        type_entries_.emplace_back(type, attrs);
+    }
+    return it->second;
+}
+
+uintptr_t MetadataEmitter::handle(Section section, uint32_t record, int32_t index) const {
+    if (version_ < 27) {
+        return (uintptr_t) index;
+    }
+    return (uintptr_t) (mapped_ + offsets_[section] + (size_t) index * record);
+}
+
+const Il2CppType *MetadataEmitter::binary_type(const Il2CppType *type) {
+    auto &cached = binary_types_[type];
+    if (cached) {
+        return cached;
+    }
+    auto &t = metadata_types.emplace_back(*type);
+    cached = &t;
+    // byref moved from bit 30 to bit 29 of the second word in 2021.1
+    t.num_mods = type->byref && version_ >= 29 ? 0x20 : 0;
+    t.byref = type->byref && version_ < 29;
+    switch (type->type) {
+        case IL2CPP_TYPE_SZARRAY:
+        case IL2CPP_TYPE_PTR:
+            t.data.type = binary_type(type->data.type);
+            break;
+        case IL2CPP_TYPE_ARRAY: {
+            auto &array = metadata_array_types.emplace_back(*type->data.array);
+            array.etype = binary_type(array.etype);
+            t.data.array = &array;
+            break;
+        }
+        case IL2CPP_TYPE_GENERICINST: {
+            auto source = type->data.generic_class;
+            auto &generic = metadata_generic_classes.emplace_back();
+            if (version_ < 27) {
+                generic.typeDefinitionIndex =
+                        type_definitions_[(Il2CppClass *) source->type->data.dummy];
+            } else {
+                generic.type = binary_type(source->type);
+            }
+            auto &args = metadata_generic_args.emplace_back();
+            auto inst = source->context.class_inst;
+            for (uint32_t i = 0; i < inst->type_argc; ++i) {
+                args.push_back(binary_type(inst->type_argv[i]));
+            }
+            auto &binaryInst = metadata_generic_insts.emplace_back();
+            binaryInst.type_argc = args.size();
+            binaryInst.type_argv = args.data();
+            generic.context.class_inst = &binaryInst;
+            t.data.generic_class = &generic;
+            break;
+        }
+        case IL2CPP_TYPE_VAR:
+        case IL2CPP_TYPE_MVAR:
+            t.data.dummy = (void *) handle(GenericParameters, 16,
+                                           generic_parameters_[type->data.dummy]);
+            break;
+        default: {
+            uint32_t size = version_ < 27 ? 92 : 88;
+            t.data.dummy = (void *) handle(TypeDefinitions, size,
+                                           type_definitions_[(Il2CppClass *) type->data.dummy]);
+            break;
+        }
+    }
+    return &t;
+}
+
+void MetadataEmitter::add_type_definition(Il2CppClass *klass, size_t image) {
+    auto index = type_definitions_[klass];
+    auto v24 = version_ < 27;
+    // offsets of declaringTypeIndex and of the counts, everything between moves with them
+    uint32_t shift = v24 ? 4 : 0;
+    auto &out = sections_[TypeDefinitions];
+    auto def = record(out, v24 ? 92 : 88);
+    store<uint32_t>(out, def, string(klass->name));
+    store<uint32_t>(out, def + 4, string(klass->namespaze));
+    store<int32_t>(out, def + 8, type_index(&klass->byval_arg));
+    store<int32_t>(out, def + 12 + shift,
+                   klass->declaring ? type_index(&klass->declaring->byval_arg) : -1);
+    store<int32_t>(out, def + 16 + shift,
+                   klass->parent ? type_index(&klass->parent->byval_arg) : -1);
+    int32_t container = -1;
+    if (!klass->generic_params.empty()) {
+        auto &containers = sections_[GenericContainers];
+        auto &parameters = sections_[GenericParameters];
+        container = (int32_t) (containers.size() / 16);
+        auto start = (int32_t) (parameters.size() / 16);
+        auto rec = record(containers, 16);
+        store<int32_t>(containers, rec, index);
+        store<int32_t>(containers, rec + 4, (int32_t) klass->generic_params.size());
+        store<int32_t>(containers, rec + 12, start);
+        for (size_t i = 0; i < klass->generic_params.size(); ++i) {
+            auto param = record(parameters, 16);
+            store<int32_t>(parameters, param, container);
+            store<uint32_t>(parameters, param + 4, string(klass->generic_params[i]));
+            store<uint16_t>(parameters, param + 12, (uint16_t) i);
+            auto it = param_cache.find({klass, i});
+            if (it != param_cache.end()) {
+                generic_parameters_[it->second->data.dummy] = start + (int32_t) i;
+            }
+        }
+    }
+    store<int32_t>(out, def + 24 + shift, container);
+    store<uint32_t>(out, def + 28 + shift, klass->flags);
+    // fields and their constants
+    auto &fields = sections_[Fields];
+    auto fieldStart = (int32_t) (fields.size() / 12);
+    auto &offsets = field_offsets_[index];
+    for (size_t i = 0; i < klass->fields.size(); ++i) {
+        auto &field = klass->fields[i];
+        auto rec = record(fields, 12);
+        store<uint32_t>(fields, rec, string(field.name));
+        store<int32_t>(fields, rec + 4, type_index(field.type, field.flags));
+        offsets.push_back((int32_t) field.offset);
+        if (field.flags & FIELD_ATTRIBUTE_LITERAL) {
+            auto &values = sections_[FieldDefaultValues];
+            auto &data = sections_[DefaultValueData];
+            auto value = record(values, 12);
+            store<int32_t>(values, value, fieldStart + (int32_t) i);
+            store<int32_t>(values, value + 4, type_index(&corlib.int32->byval_arg));
+            store<int32_t>(values, value + 8, (int32_t) data.size());
+            auto number = (int32_t) field.value;
+            if (version_ >= 29) {
+                // signed compressed: the magnitude shifted left, the sign in bit 0
+                auto encoded = number >= 0 ? (uint32_t) number << 1
+                                           : (uint32_t) (-(number + 1)) << 1 | 1;
+                if (encoded < 0x80) {
+                    data.push_back(encoded);
+                } else if (encoded < 0x4000) {
+                    data.push_back(0x80 | encoded >> 8);
+                    data.push_back(encoded);
+                } else if (encoded < 0x20000000) {
+                    data.push_back(0xc0 | encoded >> 24);
+                    data.push_back(encoded >> 16);
+                    data.push_back(encoded >> 8);
+                    data.push_back(encoded);
+                } else {
+                    data.push_back(0xf0);
+                    store(data, record(data, 4), encoded);
+                }
+            } else {
+                store(data, record(data, 4), number);
+            }
+        }
+    }
+    store<int32_t>(out, def + 32 + shift, fieldStart);
+    // methods, numbered per image like the tokens of the code gen module
+    auto &methods = sections_[Methods];
+    auto &parameters = sections_[Parameters];
+    auto &pointers = method_pointers_[image];
+    auto methodRecord = version_ >= 31 ? 36 : 32;
+    auto methodStart = (int32_t) (methods.size() / methodRecord);
+    for (auto &method: klass->methods) {
+        auto rec = record(methods, methodRecord);
+        auto token = version_ >= 31 ? 24 : 20;
+        pointers.push_back((void *) method.info.methodPointer);
+        store<uint32_t>(methods, rec, string(method.name));
+        store<int32_t>(methods, rec + 4, index);
+        store<int32_t>(methods, rec + 8, type_index(method.return_type));
+        store<int32_t>(methods, rec + token - 8, (int32_t) (parameters.size() / 12));
+        store<int32_t>(methods, rec + token - 4, -1);
+        store<uint32_t>(methods, rec + token, 0x06000000 | (uint32_t) pointers.size());
+        store<uint16_t>(methods, rec + token + 4, (uint16_t) method.flags);
+        store<uint16_t>(methods, rec + token + 6, (uint16_t) method.iflags);
+        store<uint16_t>(methods, rec + token + 8, 0xffff);
+        store<uint16_t>(methods, rec + token + 10, (uint16_t) method.params.size());
+        for (auto &param: method.params) {
+            auto p = record(parameters, 12);
+            store<uint32_t>(parameters, p, string(param.name));
+            store<int32_t>(parameters, p + 8, type_index(param.type));
+        }
+    }
+    store<int32_t>(out, def + 36 + shift, methodStart);
+    store<int32_t>(out, def + 40 + shift, -1);
+    auto &properties = sections_[Properties];
+    store<int32_t>(out, def + 44 + shift, (int32_t) (properties.size() / 20));
+    auto method_index = [klass](const MethodInfo *info) {
+        for (size_t i = 0; i < klass->methods.size(); ++i) {
+            if (&klass->methods[i].info == info) {
+                return (int32_t) i;
+            }
+        }
+        return -1;
+    };
+    for (auto &prop: klass->properties) {
+        auto rec = record(properties, 20);
+        store<uint32_t>(properties, rec, string(prop.name));
+        store<int32_t>(properties, rec + 4, method_index(prop.get));
+        store<int32_t>(properties, rec + 8, method_index(prop.set));
+        store<uint32_t>(properties, rec + 12, prop.flags);
+    }
+    auto &interfaces = sections_[Interfaces];
+    store<int32_t>(out, def + 48 + shift, -1);
+    store<int32_t>(out, def + 52 + shift, (int32_t) (interfaces.size() / 4));
+    for (auto itf: klass->interfaces) {
+        store(interfaces, record(interfaces, 4), type_index(&itf->byval_arg));
+    }
+    store<int32_t>(out, def + 56 + shift, -1);
+    store<int32_t>(out, def + 60 + shift, -1);
+    store<uint16_t>(out, def + 64 + shift, (uint16_t) klass->methods.size());
+    store<uint16_t>(out, def + 66 + shift, (uint16_t) klass->properties.size());
+    store<uint16_t>(out, def + 68 + shift, (uint16_t) klass->fields.size());
+    store<uint16_t>(out, def + 76 + shift, (uint16_t) klass->interfaces.size());
+    store<uint32_t>(out, def + 80 + shift, (klass->valuetype ? 1 : 0) | (klass->enumtype ? 2 : 0));
+    store<uint32_t>(out, def + 84 + shift, klass->token);
+}
+
+void MetadataEmitter::emit() {
+    int32_t typeCount = 0;
+    for (auto &image: images) {
+        for (auto klass: image.classes) {
+            type_definitions_[klass] = typeCount++;
+        }
+    }
+    field_offsets_.resize(typeCount);
+    method_pointers_.resize(images.size());
+    size_t imageIndex = 0;
+    int32_t typeStart = 0;
+    for (auto &image: images) {
+        auto rec = record(sections_[Images], 40);
+        store<uint32_t>(sections_[Images], rec, string(image.name));
+        store<int32_t>(sections_[Images], rec + 4, (int32_t) imageIndex);
+        store<int32_t>(sections_[Images], rec + 8, typeStart);
+        store<uint32_t>(sections_[Images], rec + 12, (uint32_t) image.classes.size());
+        typeStart += (int32_t) image.classes.size();
+        for (auto klass: image.classes) {
+            add_type_definition(klass, imageIndex);
+        }
+        ++imageIndex;
+    }
+    std::vector<uint8_t> file(kHeaderSize);
+    store<uint32_t>(file, 0, 0xFAB11BAF);
+    store<uint32_t>(file, 4, version_);
+    // stringLiteralOffset, which tells 24.2 and later apart from 24.0 and 24.1
+    store<uint32_t>(file, 8, kHeaderSize);
+    for (int i = 0; i < SectionCount; ++i) {
+        file.resize((file.size() + 3) & ~size_t(3));
+        offsets_[i] = file.size();
+        store<uint32_t>(file, kHeaderFields[i], offsets_[i]);
+        store<uint32_t>(file, kHeaderFields[i] + 4, (uint32_t) sections_[i].size());
+        file.insert(file.end(), sections_[i].begin(), sections_[i].end());
+    }
+    int fd = memfd_create("global-metadata.dat", MFD_CLOEXEC);
+    if (fd == -1 || write(fd, file.data(), file.size()) != (ssize_t) file.size()) {
+        abort();
+    }
+    // il2cpp maps the file during il2cpp_init, with deferred_init it stays unreadable
+    // until then
+    mapped_ = (const uint8_t *) mmap(nullptr, file.size(),
+                                     config.deferred_init ? PROT_NONE : PROT_READ,
+                                     MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_ == MAP_FAILED) {
+        abort();
+    }
+    metadata_mapping = {mapped_, file.size()};
+    // the registrations, built last since handles point into the mapping
+    for (auto [type, attrs]: type_entries_) {
+        auto binary = binary_type(type);
+        if (attrs >= 0 && attrs != binary->attrs) {
+            auto &copy = metadata_types.emplace_back(*binary);
+            copy.attrs = attrs;
+            binary = &copy;
+        }
+        metadata_type_table.push_back(binary);
+    }
+    for (auto &offsets: field_offsets_) {
+        metadata_field_offset_table.push_back(
+                metadata_field_offsets.emplace_back(std::move(offsets)).data());
+    }
+    imageIndex = 0;
+    for (auto &image: images) {
+        auto &pointers = metadata_method_pointers.emplace_back(
+                std::move(method_pointers_[imageIndex++]));
+        auto &module = metadata_code_gen_modules.emplace_back();
+        module = {(uintptr_t) image.name.data(), pointers.size(), (uintptr_t) pointers.data()};
+        metadata_code_gen_module_table.push_back(module.data());
+    }
+    g_MetadataRegistration[6] = metadata_type_table.size();
+    g_MetadataRegistration[7] = (uintptr_t) metadata_type_table.data();
+    g_MetadataRegistration[10] = typeCount;
+    g_MetadataRegistration[11] = (uintptr_t) metadata_field_offset_table.data();
+    g_MetadataRegistration[12] = typeCount;
+    g_CodeRegistrationModules[0] = images.size();
+    g_CodeRegistrationModules[1] = (uintptr_t) metadata_code_gen_module_table.data();
+}
+
+void build() {
+    Dl_info info{};
+    dladdr((void *) &build, &info);
+    code_base = (uintptr_t) info.dli_fbase;
+    build_corlib();
+    for (uint32_t i = 0; i < config.assemblies; ++i) {
+        build_assembly(i);
+    }
+    // method tokens are per image like the runtime's, so the metadata tables and the api
+    // report the same ones. The method pointers were derived from the global counter and
+    // are kept.
+    for (auto &image: images) {
+        uint32_t rid = 0;
+        for (auto klass: image.classes) {
+            for (auto &method: klass->methods) {
+                method.token = 0x06000000 | ++rid;
+            }
+        }
+    }
+    if (config.metadata_version) {
+        MetadataEmitter(config.metadata_version).emit();
+    }
+}
+
+const Il2CppDomain *get_domain() {
+    std::call_once(build_once, build);
+    return &domain;
+}
+
+}
+
+MOCK_API void mock_il2cpp_configure(const MockIl2CppConfig *value) {
+    std::call_once(build_once, [value] {
+        config = *value;
+        build();
+    });
+    if (value->deferred_init) {
+        vm_ready = false;
+    }
+}
+
+// domain, assembly, image
+
+MOCK_API Il2CppDomain *il2cpp_domain_get() {
+    return const_cast<Il2CppDomain *>(get_domain());
+}
+
+MOCK_API const Il2CppAssembly **il2cpp_domain_get_assemblies(const Il2CppDomain *d,
+                                                             size_t *size) {
+    *size = d->assemblies.size();
+    return const_cast<const Il2CppAssembly **>(d->assemblies.data());
+}
+
+MOCK_API const Il2CppImage *il2cpp_assembly_get_image(const Il2CppAssembly *assembly) {
+    return assembly->image;
+}
+
+MOCK_API const char *il2cpp_image_get_name(const Il2CppImage *image) {
+    return image->name.data();
+}
+
+MOCK_API size_t il2cpp_image_get_class_count(const Il2CppImage *image) {
+    return image->classes.size();
+}
+
+MOCK_API const Il2CppClass *il2cpp_image_get_class(const Il2CppImage *image, size_t index) {
+    return index < image->classes.size() ? image->classes[index] : nullptr;
+}
+
+MOCK_API const Il2CppImage *il2cpp_get_corlib() {
+    get_domain();
+    return &images.front();
+}
+
+// threads
+
+MOCK_API int il2cpp_init(const char *) {
+    get_domain();
+    if (metadata_mapping.first) {
+        mprotect(const_cast<void *>(metadata_mapping.first), metadata_mapping.second, PROT_READ);
+    }
+    vm_ready = true;
+    return 1;
+}
+
+MOCK_API bool il2cpp_is_vm_thread(Il2CppThread *) {
+    return vm_ready;
+}
+
+MOCK_API Il2CppThread *il2cpp_thread_attach(Il2CppDomain *) {
+    static int thread;
+    return reinterpret_cast<Il2CppThread *>(&thread);
+}
+
+MOCK_API void il2cpp_thread_detach(Il2CppThread *) {}
+
+// memory
+
+MOCK_API void *il2cpp_alloc(size_t size) {
+    return malloc(size);
+}
+
+MOCK_API void il2cpp_free(void *ptr) {
+    free(ptr);
+}
+
+// types
+
+MOCK_API Il2CppClass *il2cpp_class_from_type(const Il2CppType *type) {
+    switch (type->type) {
+        case IL2CPP_TYPE_GENERICINST:
+            return type->data.generic_class->cached_class;
+        case IL2CPP_TYPE_SZARRAY:
+        case IL2CPP_TYPE_ARRAY:
+        case IL2CPP_TYPE_PTR: {
+            auto it = type_classes.find(type);
+            return it == type_classes.end() ? nullptr : it->second;
+        }
+        default:
+            return static_cast<Il2CppClass *>(type->data.dummy);
+    }
+}
+
+MOCK_API bool il2cpp_type_is_byref(const Il2CppType *type) {
+    return type->byref;
+}
+
+MOCK_API int il2cpp_type_get_type(const Il2CppType *type) {
+    return type->type;
+}
+
+MOCK_API char *il2cpp_type_get_name(const Il2CppType *type) {
+    auto klass = il2cpp_class_from_type(type);
+    if (!klass) {
+        return nullptr;
+    }
+    std::string name;
+    if (type->type == IL2CPP_TYPE_VAR || type->type == IL2CPP_TYPE_MVAR) {
+        name = klass->name;
+    } else {
+        if (!klass->namespaze.empty()) {
+            name.append(klass->namespaze).append(1, '.');
+        }
+        for (auto declaring = klass->declaring; declaring; declaring = declaring->declaring) {
+            name.insert(klass->namespaze.empty() ? 0 : klass->namespaze.size() + 1,
+                        declaring->name + "/");
+        }
+        name.append(klass->name);
+        if (!klass->generic_params.empty()) {
+            name.append(1, '<');
+            for (size_t i = 0; i < klass->generic_params.size(); ++i) {
+                if (i > 0) {
+                    name.append(1, ',');
+                }
+                name.append(klass->generic_params[i]);
+            }
+            name.append(1, '>');
+        }
+    }
+    return strdup(name.data());
+}
+
+// classes
+
+MOCK_API const Il2CppType *il2cpp_class_get_type(Il2CppClass *klass) {
+    return &klass->byval_arg;
+}
+
+MOCK_API const char *il2cpp_class_get_name(Il2CppClass *klass) {
+    return klass->name.data();
+}
+
+MOCK_API const char *il2cpp_class_get_namespace(Il2CppClass *klass) {
+    return klass->namespaze.data();
+}
+
+MOCK_API int il2cpp_class_get_flags(const Il2CppClass *klass) {
+    return (int) klass->flags;
+}
+
+MOCK_API bool il2cpp_class_is_valuetype(const Il2CppClass *klass) {
+    return klass->valuetype;
+}
+
+MOCK_API bool il2cpp_class_is_enum(const Il2CppClass *klass) {
+    return klass->enumtype;
+}
+
+MOCK_API bool il2cpp_class_is_generic(const Il2CppClass *klass) {
+    return !klass->generic_params.empty();
+}
+
+MOCK_API Il2CppClass *il2cpp_class_get_parent(Il2CppClass *klass) {
+    return klass->parent;
+}
+
+MOCK_API Il2CppClass *il2cpp_class_get_declaring_type(Il2CppClass *klass) {
+    return klass->declaring;
+}
+
+MOCK_API const Il2CppImage *il2cpp_class_get_image(Il2CppClass *klass) {
+    return klass->image;
+}
+
+MOCK_API uint32_t il2cpp_class_get_type_token(Il2CppClass *klass) {
+    return klass->token;
+}
+
+template<typename T, typename Items>
+T *next_item(Items &items, void **iter) {
+    auto index = reinterpret_cast<uintptr_t>(*iter);
+    if (index >= items.size()) {
+        return nullptr;
+    }
+    *iter = reinterpret_cast<void *>(index + 1);
+    return &items[index];
+}
+
+MOCK_API Il2CppClass *il2cpp_class_get_interfaces(Il2CppClass *klass, void **iter) {
+    auto index = reinterpret_cast<uintptr_t>(*iter);
+    if (index >= klass->interfaces.size()) {
+        return nullptr;
+    }
+    *iter = reinterpret_cast<void *>(index + 1);
+    return klass->interfaces[index];
+}
+
+MOCK_API FieldInfo *il2cpp_class_get_fields(Il2CppClass *klass, void **iter) {
+    return next_item<FieldInfo>(klass->fields, iter);
+}
+
+MOCK_API const PropertyInfo *il2cpp_class_get_properties(Il2CppClass *klass, void **iter) {
+    return next_item<PropertyInfo>(klass->properties, iter);
+}
+
+MOCK_API const MethodInfo *il2cpp_class_get_methods(Il2CppClass *klass, void **iter) {
+    auto method = next_item<MockMethod>(klass->methods, iter);
+    return method ? &method->info : nullptr;
+}
+
+MOCK_API Il2CppClass *il2cpp_class_from_name(const Il2CppImage *image, const char *namespaze,
+                                             const char *name) {
+    for (auto klass: image->classes) {
+        if (klass->namespaze == namespaze && klass->name == name) {
+            return klass;
+        }
+    }
+    return nullptr;
+}
+
+// fields
+
+MOCK_API const char *il2cpp_field_get_name(FieldInfo *field) {
+    return field->name.data();
+}
+
+MOCK_API int il2cpp_field_get_flags(FieldInfo *field) {
+    return field->flags;
+}
+
+MOCK_API const Il2CppType *il2cpp_field_get_type(FieldInfo *field) {
+    return field->type;
+}
+
+MOCK_API size_t il2cpp_field_get_offset(FieldInfo *field) {
+    return field->offset;
+}
+
+MOCK_API void il2cpp_field_static_get_value(FieldInfo *field, void *value) {
+    memcpy(value, &field->value, sizeof(field->value));
+}
+
+// methods
+
+static const MockMethod *mock_method(const MethodInfo *method) {
+    return reinterpret_cast<const MockMethod *>(method);
+}
+
+MOCK_API const char *il2cpp_method_get_name(const MethodInfo *method) {
+    return mock_method(method)->name.data();
+}
+
+MOCK_API uint32_t il2cpp_method_get_flags(const MethodInfo *method, uint32_t *iflags) {
+    if (iflags) {
+        *iflags = mock_method(method)->iflags;
+    }
+    return mock_method(method)->flags;
+}
+
+MOCK_API uint32_t il2cpp_method_get_token(const MethodInfo *method) {
+    return mock_method(method)->token;
+}
+
+MOCK_API const Il2CppType *il2cpp_method_get_return_type(const MethodInfo *method) {
+    return mock_method(method)->return_type;
+}
+
+MOCK_API uint32_t il2cpp_method_get_param_count(const MethodInfo *method) {
+    return mock_method(method)->params.size();
+}
+
+MOCK_API const Il2CppType *il2cpp_method_get_param(const MethodInfo *method, uint32_t index) {
+    auto &params = mock_method(method)->params;
+    return index < params.size() ? params[index].type : nullptr;
+}
+
+MOCK_API const char *il2cpp_method_get_param_name(const MethodInfo *method, uint32_t index) {
+    auto &params = mock_method(method)->params;
+    return index < params.size() ? params[index].name.data() : nullptr;
+}
+
+// properties
+
+MOCK_API const char *il2cpp_property_get_name(PropertyInfo *prop) {
+    return prop->name.data();
+}
+
+MOCK_API uint32_t il2cpp_property_get_flags(PropertyInfo *prop) {
+    return prop->flags;
+}
+
+MOCK_API const MethodInfo *il2cpp_property_get_get_method(PropertyInfo *prop) {
+    return prop->get;
+}
+
+MOCK_API const MethodInfo *il2cpp_property_get_set_method(PropertyInfo *prop) {
+    return prop->set;
+}
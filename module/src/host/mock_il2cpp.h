@@ -0,0 +1,41 @@
+//
+// Synthetic metadata served by the host stand-in for libil2cpp.so.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_MOCK_IL2CPP_H
+#define ZYGISK_IL2CPPDUMPER_MOCK_IL2CPP_H
+
+#include <stdint.h>
+
+typedef struct MockIl2CppConfig {
+    // assemblies besides mscorlib.dll
+    uint32_t assemblies;
+    uint32_t classes_per_assembly;
+    uint32_t methods_per_class;
+    uint32_t fields_per_class;
+    uint32_t properties_per_class;
+    // every n-th class is a generic definition, 0 disables generics
+    uint32_t generic_every;
+    // length of the chains of nested types, 0 disables nesting
+    uint32_t nesting_depth;
+    // il2cpp_is_vm_thread stays false until il2cpp_init is called, see mock_unity.c
+    uint32_t deferred_init;
+    // also map a global-metadata.dat of this version (24, 27, 29 or 31) and place the
+    // registrations in .bss, 0 leaves the api as the only way in
+    uint32_t metadata_version;
+} MockIl2CppConfig;
+
+#define MOCK_IL2CPP_DEFAULT_CONFIG {4, 250, 12, 8, 4, 5, 2, 0, 29}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// must be called before the first il2cpp api call, later calls are ignored
+void mock_il2cpp_configure(const MockIl2CppConfig *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //ZYGISK_IL2CPPDUMPER_MOCK_IL2CPP_H
@@ -0,0 +1,23 @@
+//
+// Weak no-op definitions for the rest of the il2cpp api, so the dumper resolves
+// every symbol it looks up. mock_il2cpp.cpp overrides the ones it implements.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "il2cpp-class.h"
+
+template<typename T>
+static T mock_default() {
+    if constexpr (!std::is_void_v<T>) {
+        return T{};
+    }
+}
+
+#define DO_API(r, n, p) extern "C" __attribute__((weak, visibility("default"))) \
+    r n p { return mock_default<r>(); }
+
+#include "il2cpp-api-functions.h"
+
+#undef DO_API
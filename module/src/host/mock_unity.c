@@ -0,0 +1,30 @@
+//
+// Host stand-in for libunity.so: looks up il2cpp_init with dlsym like the engine
+// does and calls it through the stored pointer after a delay, which is what the
+// il2cpp_init hook patches.
+//
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+static int (*il2cpp_init_ptr)(const char *);
+static unsigned int init_delay_ms;
+
+static void *unity_main(void *arg) {
+  (void) arg;
+  usleep(init_delay_ms * 1000);
+  il2cpp_init_ptr("IL2CPP Root Domain");
+  return NULL;
+}
+
+__attribute__((visibility("default"))) int mock_unity_start(void *il2cpp, unsigned int delay_ms) {
+  il2cpp_init_ptr = (int (*)(const char *)) dlsym(il2cpp, "il2cpp_init");
+  if (!il2cpp_init_ptr) return -1;
+  init_delay_ms = delay_ms;
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, unity_main, NULL) != 0) return -1;
+  return pthread_detach(thread);
+}
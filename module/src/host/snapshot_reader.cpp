@@ -0,0 +1,435 @@
+//
+// Reads dump.bin back the way a host tool would and checks it against dump.cs.
+//
+
+#include "snapshot_reader.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "snapshot_format.h"
+
+namespace {
+
+class MappedFile {
+public:
+    explicit MappedFile(const char *path) {
+        auto fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = (const uint8_t *) data;
+                size_ = st.st_size;
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            munmap((void *) data_, size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// dump.cs spells these corlib types with their C# keyword, see primitive_name
+constexpr std::pair<std::string_view, std::string_view> kKeywordTypes[] = {
+        {"void", "Void"}, {"bool", "Boolean"}, {"char", "Char"}, {"sbyte", "SByte"},
+        {"byte", "Byte"}, {"short", "Int16"}, {"ushort", "UInt16"}, {"int", "Int32"},
+        {"uint", "UInt32"}, {"long", "Int64"}, {"ulong", "UInt64"}, {"float", "Single"},
+        {"double", "Double"}, {"string", "String"}, {"object", "Object"},
+};
+
+template<typename T>
+struct Records {
+    const T *data = nullptr;
+    size_t count = 0;
+
+    const T &operator[](size_t index) const { return data[index]; }
+
+    bool contains(uint64_t first, uint64_t n) const {
+        return first <= count && n <= count - first;
+    }
+};
+
+class SnapshotChecker {
+public:
+    SnapshotChecker(const MappedFile &file, SnapshotSummary &summary)
+            : file_(file), summary_(summary) {}
+
+    bool check_layout();
+
+    void check_records();
+
+    void check_dump(const MappedFile &dump);
+
+    bool failed() const { return errors_ != 0; }
+
+private:
+    // the first few problems are enough to see what went wrong
+    static constexpr size_t kMaxReported = 16;
+
+    __attribute__((format(printf, 2, 3)))
+    void error(const char *fmt, ...) {
+        if (errors_++ >= kMaxReported) {
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        fputs("dump.bin: ", stderr);
+        vfprintf(stderr, fmt, args);
+        fputc('\n', stderr);
+        va_end(args);
+    }
+
+    template<typename T>
+    bool section(uint32_t id, Records<T> &out);
+
+    bool string(uint32_t offset) const {
+        return offset < string_starts_.size() && string_starts_[offset];
+    }
+
+    std::string_view string_at(uint32_t offset) const {
+        return (const char *) strings_.data + offset;
+    }
+
+    void check_string(uint32_t offset, const char *what, size_t index) {
+        if (!string(offset)) {
+            error("%s %zu: string offset %u is not the start of a string", what, index, offset);
+        }
+    }
+
+    // a resolved link must point at the type its name was written for
+    void check_link(int32_t target, uint32_t name, const char *what, size_t index);
+
+    const MappedFile &file_;
+    SnapshotSummary &summary_;
+    size_t errors_ = 0;
+    const SnapshotSection *sections_ = nullptr;
+    uint32_t section_count_ = 0;
+    std::vector<bool> string_starts_;
+    Records<char> strings_;
+    Records<SnapshotImage> images_;
+    Records<SnapshotType> types_;
+    Records<SnapshotInterface> interfaces_;
+    Records<SnapshotField> fields_;
+    Records<SnapshotProperty> properties_;
+    Records<SnapshotMethod> methods_;
+    Records<SnapshotParameter> parameters_;
+};
+
+bool SnapshotChecker::check_layout() {
+    auto data = file_.data();
+    auto size = file_.size();
+    if (size < sizeof(SnapshotHeader)) {
+        error("%zu bytes, too short for the header", size);
+        return false;
+    }
+    auto header = (const SnapshotHeader *) data;
+    if (header->magic != SNAPSHOT_MAGIC) {
+        error("bad magic 0x%x", header->magic);
+        return false;
+    }
+    if (header->version_major != SNAPSHOT_VERSION_MAJOR) {
+        error("version %u.%u, expected %u.x", header->version_major, header->version_minor,
+              SNAPSHOT_VERSION_MAJOR);
+        return false;
+    }
+    if (header->header_size < sizeof(SnapshotHeader) || header->header_size % 8 != 0) {
+        error("header size %u", header->header_size);
+        return false;
+    }
+    uint64_t tableEnd = header->header_size + (uint64_t) header->section_count *
+                                              sizeof(SnapshotSection);
+    if (tableEnd > size) {
+        error("%u sections do not fit in %zu bytes", header->section_count, size);
+        return false;
+    }
+    sections_ = (const SnapshotSection *) (data + header->header_size);
+    section_count_ = header->section_count;
+
+    //按偏移排序后检查区段不重叠, 且间隙只有不足8字节的零填充
+    std::vector<const SnapshotSection *> sorted;
+    for (uint32_t i = 0; i < section_count_; ++i) {
+        auto &s = sections_[i];
+        if (s.offset % 8 != 0) {
+            error("section %u at unaligned offset %llu", s.id, (unsigned long long) s.offset);
+        }
+        if (s.record_size == 0 || s.offset < tableEnd || s.offset > size ||
+            s.count > (size - s.offset) / s.record_size) {
+            error("section %u (%llu x %u bytes at %llu) outside the file", s.id,
+                  (unsigned long long) s.count, s.record_size, (unsigned long long) s.offset);
+            return false;
+        }
+        for (uint32_t j = 0; j < i; ++j) {
+            if (sections_[j].id == s.id) {
+                error("section %u appears twice", s.id);
+            }
+        }
+        sorted.push_back(&s);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) {
+        return a->offset < b->offset;
+    });
+    auto end = tableEnd;
+    for (auto s: sorted) {
+        if (s->offset < end) {
+            error("section %u overlaps the one before it", s->id);
+            return false;
+        }
+        if (s->offset - end >= 8) {
+            error("%llu bytes of padding before section %u",
+                  (unsigned long long) (s->offset - end), s->id);
+        }
+        for (auto p = end; p < s->offset; ++p) {
+            if (data[p]) {
+                error("non-zero padding byte at %llu", (unsigned long long) p);
+                break;
+            }
+        }
+        end = s->offset + s->count * s->record_size;
+    }
+    if (end != size) {
+        error("%llu trailing bytes", (unsigned long long) (size - end));
+    }
+
+    if (!section(SNAPSHOT_SECTION_STRINGS, strings_) ||
+        !section(SNAPSHOT_SECTION_IMAGES, images_) ||
+        !section(SNAPSHOT_SECTION_TYPES, types_) ||
+        !section(SNAPSHOT_SECTION_INTERFACES, interfaces_) ||
+        !section(SNAPSHOT_SECTION_FIELDS, fields_) ||
+        !section(SNAPSHOT_SECTION_PROPERTIES, properties_) ||
+        !section(SNAPSHOT_SECTION_METHODS, methods_) ||
+        !section(SNAPSHOT_SECTION_PARAMETERS, parameters_)) {
+        return false;
+    }
+    if (strings_.count == 0 || strings_[0] != '\0' || strings_[strings_.count - 1] != '\0') {
+        error("the string table must start with the empty string and end with a NUL");
+        return false;
+    }
+    string_starts_.assign(strings_.count, false);
+    string_starts_[0] = true;
+    for (size_t i = 1; i < strings_.count; ++i) {
+        string_starts_[i] = strings_[i - 1] == '\0';
+    }
+    summary_.images = images_.count;
+    summary_.types = types_.count;
+    summary_.interfaces = interfaces_.count;
+    summary_.fields = fields_.count;
+    summary_.properties = properties_.count;
+    summary_.methods = methods_.count;
+    summary_.parameters = parameters_.count;
+    summary_.string_bytes = strings_.count;
+    return !failed();
+}
+
+template<typename T>
+bool SnapshotChecker::section(uint32_t id, Records<T> &out) {
+    for (uint32_t i = 0; i < section_count_; ++i) {
+        auto &s = sections_[i];
+        if (s.id != id) {
+            continue;
+        }
+        if (s.record_size != sizeof(T)) {
+            error("section %u has %u byte records, expected %zu", id, s.record_size, sizeof(T));
+            return false;
+        }
+        out.data = (const T *) (file_.data() + s.offset);
+        out.count = s.count;
+        return true;
+    }
+    error("section %u is missing", id);
+    return false;
+}
+
+void SnapshotChecker::check_link(int32_t target, uint32_t name, const char *what,
+                                 size_t index) {
+    if (target == SNAPSHOT_NONE) {
+        return;
+    }
+    if (target < 0 || (size_t) target >= types_.count) {
+        error("%s %zu links to type %d of %zu", what, index, target, types_.count);
+        return;
+    }
+    //嵌套类型的完整名以其声明名结尾
+    auto full = string_at(name);
+    auto declared = string_at(types_[target].name);
+    for (auto [keyword, type]: kKeywordTypes) {
+        if (full == keyword) {
+            full = type;
+            break;
+        }
+    }
+    if (!string(types_[target].name) || !full.ends_with(declared)) {
+        error("%s %zu names %s but links to type %d %s", what, index, string_at(name).data(),
+              target, declared.data());
+    }
+}
+
+void SnapshotChecker::check_records() {
+    uint64_t nextType = 0;
+    for (size_t i = 0; i < images_.count; ++i) {
+        auto &image = images_[i];
+        check_string(image.name, "image", i);
+        if (image.first_type != nextType || !types_.contains(image.first_type, image.type_count)) {
+            error("image %zu: types %u+%u do not follow the previous image", i, image.first_type,
+                  image.type_count);
+        }
+        nextType = (uint64_t) image.first_type + image.type_count;
+    }
+    if (nextType != types_.count) {
+        error("images cover %llu of %zu types", (unsigned long long) nextType, types_.count);
+    }
+
+    for (size_t i = 0; i < types_.count; ++i) {
+        auto &type = types_[i];
+        check_string(type.name, "type", i);
+        check_string(type.namespaze, "type", i);
+        check_string(type.parent_name, "type", i);
+        if (type.image >= images_.count || i < images_[type.image].first_type ||
+            i - images_[type.image].first_type >= images_[type.image].type_count) {
+            error("type %zu: image %u does not hold it", i, type.image);
+        }
+        if (!interfaces_.contains(type.first_interface, type.interface_count) ||
+            !fields_.contains(type.first_field, type.field_count) ||
+            !properties_.contains(type.first_property, type.property_count) ||
+            !methods_.contains(type.first_method, type.method_count)) {
+            error("type %zu: member ranges outside their sections", i);
+            continue;
+        }
+        if (type.parent != SNAPSHOT_NONE && !type.parent_name) {
+            error("type %zu: parent %d without a name", i, type.parent);
+        }
+        if (string(type.parent_name)) {
+            check_link(type.parent, type.parent_name, "type", i);
+        }
+        for (auto j = type.first_property; j < type.first_property + type.property_count; ++j) {
+            auto &prop = properties_[j];
+            for (auto method: {prop.get_method, prop.set_method}) {
+                if (method != SNAPSHOT_NONE &&
+                    (method < (int32_t) type.first_method ||
+                     method >= (int32_t) (type.first_method + type.method_count))) {
+                    error("property %u: accessor %d outside the methods of type %zu", j, method,
+                          i);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < interfaces_.count; ++i) {
+        check_string(interfaces_[i].type_name, "interface", i);
+        if (string(interfaces_[i].type_name)) {
+            check_link(interfaces_[i].type, interfaces_[i].type_name, "interface", i);
+        }
+    }
+    for (size_t i = 0; i < fields_.count; ++i) {
+        check_string(fields_[i].name, "field", i);
+        check_string(fields_[i].type_name, "field", i);
+    }
+    for (size_t i = 0; i < properties_.count; ++i) {
+        check_string(properties_[i].name, "property", i);
+        check_string(properties_[i].type_name, "property", i);
+    }
+    for (size_t i = 0; i < methods_.count; ++i) {
+        auto &method = methods_[i];
+        check_string(method.name, "method", i);
+        check_string(method.return_type, "method", i);
+        if (!parameters_.contains(method.first_parameter, method.parameter_count)) {
+            error("method %zu: parameters %u+%u outside their section", i,
+                  method.first_parameter, method.parameter_count);
+        }
+    }
+    for (size_t i = 0; i < parameters_.count; ++i) {
+        check_string(parameters_[i].name, "parameter", i);
+        check_string(parameters_[i].type_name, "parameter", i);
+    }
+}
+
+void SnapshotChecker::check_dump(const MappedFile &dump) {
+    constexpr std::string_view imagePrefix = "// Image ";
+    constexpr std::string_view typePrefix = "// Namespace: ";
+    constexpr std::string_view methodPrefix = "\t// RVA: ";
+    constexpr std::string_view fieldMarker = "; // 0x";
+    size_t imageLines = 0, typeLines = 0, methodLines = 0, fieldLines = 0;
+    std::string_view text((const char *) dump.data(), dump.size());
+    while (!text.empty()) {
+        auto newline = text.find('\n');
+        auto line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        if (line.starts_with(typePrefix)) {
+            ++typeLines;
+        } else if (line.starts_with(methodPrefix)) {
+            ++methodLines;
+        } else if (line.starts_with('\t') && line.find(fieldMarker) != std::string_view::npos) {
+            ++fieldLines;
+        } else if (line.starts_with(imagePrefix)) {
+            //"// Image N: name", 只在文件开头出现
+            auto colon = line.find(": ");
+            auto name = colon == std::string_view::npos ? line.substr(0, 0)
+                                                        : line.substr(colon + 2);
+            if (imageLines >= images_.count) {
+                error("dump.cs lists image %.*s beyond the %zu in dump.bin", (int) name.size(),
+                      name.data(), images_.count);
+            } else if (name != string_at(images_[imageLines].name)) {
+                error("image %zu is %s in dump.bin and %.*s in dump.cs", imageLines,
+                      string_at(images_[imageLines].name).data(), (int) name.size(),
+                      name.data());
+            }
+            ++imageLines;
+        }
+    }
+    auto compare = [&](const char *what, size_t lines, size_t records) {
+        if (lines != records) {
+            error("%zu %s in dump.cs, %zu in dump.bin", lines, what, records);
+        }
+    };
+    compare("images", imageLines, images_.count);
+    compare("types", typeLines, types_.count);
+    compare("methods", methodLines, methods_.count);
+    compare("fields", fieldLines, fields_.count);
+}
+
+}
+
+bool verify_snapshot(const char *snapshotPath, const char *dumpPath, SnapshotSummary &summary) {
+    MappedFile file(snapshotPath);
+    if (!file.data()) {
+        fprintf(stderr, "cannot map %s\n", snapshotPath);
+        return false;
+    }
+    MappedFile dump(dumpPath);
+    if (!dump.data()) {
+        fprintf(stderr, "cannot map %s\n", dumpPath);
+        return false;
+    }
+    SnapshotChecker checker(file, summary);
+    if (checker.check_layout()) {
+        checker.check_records();
+        checker.check_dump(dump);
+    }
+    return !checker.failed();
+}
@@ -0,0 +1,26 @@
+//
+// Reads dump.bin back the way a host tool would and checks it against dump.cs.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_SNAPSHOT_READER_H
+#define ZYGISK_IL2CPPDUMPER_SNAPSHOT_READER_H
+
+#include <cstddef>
+
+struct SnapshotSummary {
+    size_t images = 0;
+    size_t types = 0;
+    size_t interfaces = 0;
+    size_t fields = 0;
+    size_t properties = 0;
+    size_t methods = 0;
+    size_t parameters = 0;
+    size_t string_bytes = 0;
+};
+
+// mmaps snapshotPath and validates the header, the section table and its padding, every
+// string offset and every index between records, then compares the image names and the
+// type, method and field counts with the dump.cs at dumpPath. Problems go to stderr.
+bool verify_snapshot(const char *snapshotPath, const char *dumpPath, SnapshotSummary &summary);
+
+#endif //ZYGISK_IL2CPPDUMPER_SNAPSHOT_READER_H
@@ -0,0 +1,29 @@
+//
+// Force-included into the xDL sources on the host. Bionic gets these from <elf.h>,
+// <string.h> and the api level macros from <sys/cdefs.h>.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_XDL_HOST_COMPAT_H
+#define ZYGISK_IL2CPPDUMPER_XDL_HOST_COMPAT_H
+
+#include <elf.h>
+#include <string.h>
+#include <android/api-level.h>
+
+#ifndef ELF_ST_TYPE
+#define ELF_ST_TYPE(x) (((unsigned int) (x)) & 0xf)
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+static inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+#endif //ZYGISK_IL2CPPDUMPER_XDL_HOST_COMPAT_H
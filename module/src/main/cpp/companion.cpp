@@ -0,0 +1,416 @@
+//
+// Root companion that keeps targets.txt and the arm payload loaded between spawns, and
+// compiles targets.txt into targets.bin for the spawns to probe.
+//
+
+#include "companion.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "game.h"
+#include "targets.h"
+#include "log.h"
+
+// nice_name is a package or process name, anything longer is not a real request
+#define MaxPackageName 1024
+
+#if defined(__i386__) || defined(__x86_64__)
+
+// The module dir is only readable before specialization, so the arm library is copied
+// into a sealed memfd here and loaded through /proc/self/fd later. sendfile keeps the
+// copy inside the kernel, plain read/write is the fallback for kernels that refuse it.
+static int CopyToMemfd(int fd) {
+    struct stat sb{};
+    if (fstat(fd, &sb) != 0) {
+        LOGW("fstat arm file failed: %s", strerror(errno));
+        return -1;
+    }
+    int memfd = (int) syscall(__NR_memfd_create, "anon", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd == -1) {
+        LOGW("memfd_create failed: %s", strerror(errno));
+        return -1;
+    }
+    auto remaining = (size_t) sb.st_size;
+    while (remaining > 0) {
+        auto n = sendfile(memfd, fd, nullptr, remaining);
+        if (n > 0) {
+            remaining -= n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    //sendfile推进了fd的偏移, 从中断处继续
+    char buf[64 * 1024];
+    while (remaining > 0) {
+        auto n = read(fd, buf, std::min(remaining, sizeof(buf)));
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        for (ssize_t written = 0; written < n;) {
+            auto w = write(memfd, buf + written, n - written);
+            if (w == -1 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                LOGW("write memfd failed: %s", strerror(errno));
+                close(memfd);
+                return -1;
+            }
+            written += w;
+        }
+        remaining -= n;
+    }
+    if (remaining > 0) {
+        LOGW("copy arm file failed: %s", strerror(errno));
+        close(memfd);
+        return -1;
+    }
+    fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return memfd;
+}
+
+#endif
+
+int open_dumper(int module_dir) {
+#if defined(__arm__)
+    auto path = "dumper/armeabi-v7a.so";
+#elif defined(__aarch64__)
+    auto path = "dumper/arm64-v8a.so";
+#elif defined(__i386__)
+    auto path = "dumper/x86.so";
+#else
+    auto path = "dumper/x86_64.so";
+#endif
+    int fd = openat(module_dir, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        LOGW("Unable to open %s: %s", path, strerror(errno));
+    }
+    return fd;
+}
+
+int load_payload(int module_dir) {
+#if defined(__i386__)
+    auto path = "dumper/armeabi-v7a.so";
+#endif
+#if defined(__x86_64__)
+    auto path = "dumper/arm64-v8a.so";
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+    int fd = openat(module_dir, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        LOGW("Unable to open arm file");
+        return -1;
+    }
+    int memfd = CopyToMemfd(fd);
+    close(fd);
+    return memfd;
+#else
+    (void) module_dir;
+    return -1;
+#endif
+}
+
+static void fill_reply(const TargetOptions *target, CompanionReply &reply) {
+    reply = {};
+    if (target) {
+        reply.target = 1;
+        reply.threads = target->threads;
+        reply.snapshot = target->snapshot;
+        reply.metadata = target->metadata;
+    }
+}
+
+static const TargetOptions kDefaults{DumpThreads, DumpSnapshot, DumpMetadata};
+
+//没有targets.txt或其中没有包名时使用game.h中的GamePackageName
+static const TargetOptions *match_target(const TargetTable &targets, bool has_file,
+                                         std::string_view package_name) {
+    if (has_file && !targets.empty()) {
+        return targets.find(package_name);
+    }
+    return package_name == GamePackageName ? &kDefaults : nullptr;
+}
+
+bool probe_target(int module_dir, const char *package_name, CompanionReply &reply) {
+    TargetOptions options{};
+    switch (probe_targets(module_dir, package_name, options)) {
+        case TargetProbe::Hit:
+            fill_reply(&options, reply);
+            return true;
+        case TargetProbe::Miss:
+            fill_reply(nullptr, reply);
+            return true;
+        case TargetProbe::NoTargets:
+            fill_reply(std::string_view(package_name) == GamePackageName ? &kDefaults : nullptr,
+                       reply);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool lookup_target(int module_dir, const char *package_name, CompanionReply &reply) {
+    TargetTable targets;
+    bool has_file = load_targets(module_dir, kDefaults, targets);
+    auto target = match_target(targets, has_file, package_name);
+    fill_reply(target, reply);
+    return target != nullptr;
+}
+
+static bool read_fully(int fd, void *data, size_t size) {
+    auto p = (char *) data;
+    while (size > 0) {
+        auto n = read(fd, p, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool write_fully(int fd, const void *data, size_t size) {
+    auto p = (const char *) data;
+    while (size > 0) {
+        auto n = write(fd, p, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// The most descriptors sent with one message, the dumper library and the arm payload
+#define MaxMessageFds 2
+
+// Sends the iovecs with fds attached to the first byte
+static bool send_with_fds(int sock, iovec *iov, int iovcnt, const int *fds, int count) {
+    char control[CMSG_SPACE(sizeof(int) * MaxMessageFds)]{};
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    if (count > 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    }
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n == -1 && errno == EINTR);
+    if (n == -1) {
+        return false;
+    }
+    //短写时剩余部分不再携带fd
+    for (int i = 0; i < iovcnt; ++i) {
+        auto sent = std::min((size_t) n, iov[i].iov_len);
+        n -= (ssize_t) sent;
+        if (!write_fully(sock, (char *) iov[i].iov_base + sent, iov[i].iov_len - sent)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void close_fds(int *fds, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (fds[i] != -1) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+// Reads exactly size bytes, fds receives the descriptors attached to them and the rest
+// of the MaxMessageFds entries are -1. Returns the number of descriptors or -1.
+static int recv_with_fds(int sock, void *data, size_t size, int *fds) {
+    std::fill(fds, fds + MaxMessageFds, -1);
+    char control[CMSG_SPACE(sizeof(int) * MaxMessageFds)]{};
+    iovec iov{data, size};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n == -1 && errno == EINTR);
+    if (n <= 0) {
+        return -1;
+    }
+    int count = 0;
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            auto received = (int) ((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            received = std::min(received, MaxMessageFds - count);
+            memcpy(fds + count, CMSG_DATA(cmsg), sizeof(int) * received);
+            count += received;
+        }
+    }
+    if (!read_fully(sock, (char *) data + n, size - n)) {
+        close_fds(fds, count);
+        return -1;
+    }
+    return count;
+}
+
+// Everything the companion keeps between requests. targets.txt is stat'ed on each
+// request and parsed again, and targets.bin rewritten, only when it changed. The dumper
+// library is opened and the payload copied once, every target gets its own dup of the
+// same descriptors.
+static struct {
+    std::mutex lock;
+    int module_dir = -1;
+    TargetTable targets;
+    bool has_file = false;
+    struct stat file{};
+    // targets.bin as last written
+    struct stat stored{};
+    int dumper_fd = -1;
+    int payload_fd = -1;
+} companion;
+
+static bool same_file(const struct stat &a, const struct stat &b) {
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size &&
+           a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+static void refresh_targets() {
+    struct stat sb{};
+    if (fstatat(companion.module_dir, "targets.txt", &sb, 0) != 0) {
+        if (companion.has_file) {
+            companion.targets.parse({}, {});
+            companion.has_file = false;
+            unlinkat(companion.module_dir, "targets.bin", 0);
+        }
+        return;
+    }
+    struct stat stored{};
+    if (companion.has_file && same_file(sb, companion.file)) {
+        //spawn读不到targets.bin时也会来问, targets.txt没变但文件被删或被替换时重写
+        if (fstatat(companion.module_dir, "targets.bin", &stored, 0) == 0 &&
+            stored.st_dev == companion.stored.st_dev && stored.st_ino == companion.stored.st_ino) {
+            return;
+        }
+    } else {
+        companion.has_file = load_targets(companion.module_dir, kDefaults, companion.targets);
+        companion.file = sb;
+        LOGI("companion: loaded %zu targets", companion.targets.size());
+    }
+    if (companion.has_file && store_targets(companion.module_dir, companion.targets) &&
+        fstatat(companion.module_dir, "targets.bin", &stored, 0) == 0) {
+        companion.stored = stored;
+    }
+}
+
+void companion_handler(int client) {
+    uint32_t length;
+    int fds[MaxMessageFds];
+    if (recv_with_fds(client, &length, sizeof(length), fds) < 0) {
+        return;
+    }
+    //只接收模块目录一个fd
+    int module_dir = fds[0];
+    close_fds(fds + 1, MaxMessageFds - 1);
+    std::string package_name;
+    if (length <= MaxPackageName) {
+        package_name.resize(length);
+    }
+    if (length > MaxPackageName || !read_fully(client, package_name.data(), length)) {
+        close_fds(&module_dir, 1);
+        return;
+    }
+
+    CompanionReply reply{};
+    int count = 0;
+    {
+        std::lock_guard<std::mutex> guard(companion.lock);
+        if (companion.module_dir == -1) {
+            companion.module_dir = module_dir;
+            module_dir = -1;
+        }
+        if (companion.module_dir != -1) {
+            refresh_targets();
+            auto target = match_target(companion.targets, companion.has_file, package_name);
+            fill_reply(target, reply);
+            //打开失败时下次再试; arm上load_payload不做任何事
+            if (target && companion.dumper_fd == -1) {
+                companion.dumper_fd = open_dumper(companion.module_dir);
+            }
+            if (target && companion.payload_fd == -1) {
+                companion.payload_fd = load_payload(companion.module_dir);
+            }
+            if (target && companion.dumper_fd != -1) {
+                reply.has_dumper = 1;
+                fds[count++] = companion.dumper_fd;
+            }
+            if (target && companion.payload_fd != -1) {
+                reply.has_payload = 1;
+                fds[count++] = companion.payload_fd;
+            }
+        }
+    }
+    close_fds(&module_dir, 1);
+    iovec iov{&reply, sizeof(reply)};
+    send_with_fds(client, &iov, 1, fds, count);
+}
+
+bool companion_query(int client, int module_dir, const char *package_name,
+                     CompanionReply &reply, int &dumper_fd, int &payload_fd) {
+    dumper_fd = -1;
+    payload_fd = -1;
+    auto length = (uint32_t) strlen(package_name);
+    iovec iov[2]{{&length, sizeof(length)},
+                 {(void *) package_name, length}};
+    if (!send_with_fds(client, iov, 2, &module_dir, module_dir != -1)) {
+        return false;
+    }
+    int fds[MaxMessageFds];
+    int count = recv_with_fds(client, &reply, sizeof(reply), fds);
+    if (count < 0) {
+        return false;
+    }
+    if ((int) reply.has_dumper + (int) reply.has_payload != count) {
+        LOGW("companion sent %d fds for %u+%u", count, reply.has_dumper, reply.has_payload);
+        close_fds(fds, count);
+        return false;
+    }
+    int next = 0;
+    if (reply.has_dumper) {
+        dumper_fd = fds[next++];
+    }
+    if (reply.has_payload) {
+        payload_fd = fds[next++];
+    }
+    return true;
+}
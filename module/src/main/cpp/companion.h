@@ -0,0 +1,48 @@
+//
+// Root companion that keeps targets.txt and the arm payload loaded between spawns. It
+// also compiles targets.txt into targets.bin, which preAppSpecialize maps and probes
+// itself, so only a target, or a spawn that finds targets.bin missing or stale, does a
+// round trip over the companion socket.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_COMPANION_H
+#define ZYGISK_IL2CPPDUMPER_COMPANION_H
+
+#include <cstdint>
+
+// Sent back for every request. The dumper library fd and then the payload memfd ride
+// along as SCM_RIGHTS for the flags that are set.
+struct CompanionReply {
+    uint32_t target;
+    uint32_t threads;
+    uint32_t snapshot;
+    uint32_t metadata;
+    uint32_t has_dumper;
+    uint32_t has_payload;
+};
+
+// Runs in the companion process for each connection. Zygisk may call it from several
+// threads at once, the shared state is locked.
+void companion_handler(int client);
+
+// Called in the spawning app. module_dir is passed to the companion, which has no other
+// way to find the module. Returns false if the companion could not be asked, dumper_fd
+// and payload_fd are -1 unless the reply carried them.
+bool companion_query(int client, int module_dir, const char *package_name,
+                     CompanionReply &reply, int &dumper_fd, int &payload_fd);
+
+// Decides from targets.bin without the companion. Returns false if the file is missing,
+// damaged or older than targets.txt, the companion has to be asked then and rewrites it.
+bool probe_target(int module_dir, const char *package_name, CompanionReply &reply);
+
+// Target lookup and payload copy done directly in the module dir, for the companion and
+// for the spawn itself when the companion is unavailable
+bool lookup_target(int module_dir, const char *package_name, CompanionReply &reply);
+
+// dumper/<abi>.so, the library with everything past the package check, -1 on failure
+int open_dumper(int module_dir);
+
+// Sealed memfd with the arm library for the native bridge, -1 if this abi does not need one
+int load_payload(int module_dir);
+
+#endif //ZYGISK_IL2CPPDUMPER_COMPANION_H
@@ -0,0 +1,177 @@
+//
+// Append-only output buffer backed by recycled fixed-size blocks.
+//
+
+#include "dump_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+std::mutex pool_mutex;
+std::vector<char *> pool_free;
+size_t pool_used = 0;
+size_t pool_max = 0;
+
+// Keep a handful of blocks around for the next chunk, release the rest so a
+// finished dump does not pin memory in the game process.
+constexpr size_t kPoolKeep = 64;
+
+char *pool_acquire() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pool_used += DumpBuffer::kBlockSize;
+    pool_max = std::max(pool_max, pool_used);
+    if (!pool_free.empty()) {
+        auto block = pool_free.back();
+        pool_free.pop_back();
+        return block;
+    }
+    return new char[DumpBuffer::kBlockSize];
+}
+
+void pool_release(const std::vector<DumpBuffer::Block> &blocks) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    for (auto &block: blocks) {
+        pool_used -= DumpBuffer::kBlockSize;
+        if (pool_free.size() < kPoolKeep) {
+            pool_free.push_back(block.data);
+        } else {
+            delete[] block.data;
+        }
+    }
+}
+
+constexpr char kDigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+int dec_digits(uint64_t value) {
+    int digits = 1;
+    while (value >= 10000) {
+        value /= 10000;
+        digits += 4;
+    }
+    if (value >= 1000) return digits + 3;
+    if (value >= 100) return digits + 2;
+    if (value >= 10) return digits + 1;
+    return digits;
+}
+
+}
+
+DumpBuffer::~DumpBuffer() {
+    clear();
+}
+
+DumpBuffer::DumpBuffer(DumpBuffer &&other) noexcept
+        : blocks_(std::move(other.blocks_)), size_(other.size_) {
+    other.blocks_.clear();
+    other.size_ = 0;
+}
+
+DumpBuffer &DumpBuffer::operator=(DumpBuffer &&other) noexcept {
+    if (this != &other) {
+        clear();
+        blocks_ = std::move(other.blocks_);
+        size_ = other.size_;
+        other.blocks_.clear();
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void DumpBuffer::clear() {
+    if (!blocks_.empty()) {
+        pool_release(blocks_);
+        blocks_.clear();
+    }
+    size_ = 0;
+}
+
+char *DumpBuffer::reserve(size_t n) {
+    if (blocks_.empty() || kBlockSize - blocks_.back().used < n) {
+        blocks_.push_back({pool_acquire(), 0});
+    }
+    auto &block = blocks_.back();
+    return block.data + block.used;
+}
+
+DumpBuffer &DumpBuffer::append(std::string_view str) {
+    while (!str.empty()) {
+        if (blocks_.empty() || blocks_.back().used == kBlockSize) {
+            blocks_.push_back({pool_acquire(), 0});
+        }
+        auto &block = blocks_.back();
+        auto n = std::min(str.size(), kBlockSize - block.used);
+        memcpy(block.data + block.used, str.data(), n);
+        commit(n);
+        str.remove_prefix(n);
+    }
+    return *this;
+}
+
+DumpBuffer &DumpBuffer::append_dec(uint64_t value) {
+    auto digits = dec_digits(value);
+    auto out = reserve(digits) + digits;
+    while (value >= 100) {
+        auto pair = (value % 100) * 2;
+        value /= 100;
+        *--out = kDigitPairs[pair + 1];
+        *--out = kDigitPairs[pair];
+    }
+    if (value >= 10) {
+        *--out = kDigitPairs[value * 2 + 1];
+        *--out = kDigitPairs[value * 2];
+    } else {
+        *--out = (char) ('0' + value);
+    }
+    commit(digits);
+    return *this;
+}
+
+DumpBuffer &DumpBuffer::append_dec(int64_t value) {
+    if (value < 0) {
+        append('-');
+        return append_dec(~(uint64_t) value + 1);
+    }
+    return append_dec((uint64_t) value);
+}
+
+DumpBuffer &DumpBuffer::append_hex(uint64_t value) {
+    int digits = value ? (64 - __builtin_clzll(value) + 3) / 4 : 1;
+    auto out = reserve(digits) + digits;
+    do {
+        *--out = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    } while (value);
+    commit(digits);
+    return *this;
+}
+
+size_t DumpBuffer::pool_in_use() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return pool_used;
+}
+
+size_t DumpBuffer::pool_peak() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return pool_max;
+}
+
+void DumpBuffer::pool_trim() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    for (auto block: pool_free) {
+        delete[] block;
+    }
+    pool_free.clear();
+    pool_free.shrink_to_fit();
+}
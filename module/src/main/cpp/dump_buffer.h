@@ -0,0 +1,85 @@
+//
+// Append-only output buffer backed by recycled fixed-size blocks. Formatters write
+// straight into the blocks and DumpWriter hands them to the kernel with writev(),
+// so every byte is copied once between formatting and the file.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_BUFFER_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class DumpBuffer {
+public:
+    static constexpr size_t kBlockSize = 16 * 1024;
+
+    struct Block {
+        char *data;
+        size_t used;
+    };
+
+    DumpBuffer() = default;
+
+    ~DumpBuffer();
+
+    DumpBuffer(DumpBuffer &&other) noexcept;
+
+    DumpBuffer &operator=(DumpBuffer &&other) noexcept;
+
+    DumpBuffer(const DumpBuffer &) = delete;
+
+    DumpBuffer &operator=(const DumpBuffer &) = delete;
+
+    DumpBuffer &append(std::string_view str);
+
+    DumpBuffer &append(const char *str) {
+        return append(std::string_view(str ? str : ""));
+    }
+
+    DumpBuffer &append(char c) {
+        *reserve(1) = c;
+        commit(1);
+        return *this;
+    }
+
+    DumpBuffer &append_dec(uint64_t value);
+
+    DumpBuffer &append_dec(int64_t value);
+
+    // lowercase, no prefix and no padding, same as std::hex
+    DumpBuffer &append_hex(uint64_t value);
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    const std::vector<Block> &blocks() const { return blocks_; }
+
+    // returns every block to the pool
+    void clear();
+
+    // bytes currently held by all buffers, and the highest value seen
+    static size_t pool_in_use();
+
+    static size_t pool_peak();
+
+    // frees the blocks kept for reuse, call once a dump is finished
+    static void pool_trim();
+
+private:
+    // pointer to at least n contiguous free bytes, n must not exceed kBlockSize
+    char *reserve(size_t n);
+
+    void commit(size_t n) {
+        blocks_.back().used += n;
+        size_ += n;
+    }
+
+    std::vector<Block> blocks_;
+    size_t size_ = 0;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_BUFFER_H
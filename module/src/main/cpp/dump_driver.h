@@ -0,0 +1,160 @@
+//
+// The part of a dump both backends share: formatting types into dump.cs in order,
+// serially or on worker threads, with the flushing and metrics that go with it.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_DRIVER_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_DRIVER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "log.h"
+#include "dump_buffer.h"
+#include "dump_writer.h"
+#include "dump_scheduler.h"
+#include "dump_metrics.h"
+
+// types [begin, end) of one image, in whatever numbering the backend uses
+struct DumpChunk {
+    size_t image;
+    size_t begin;
+    size_t end;
+};
+
+constexpr size_t kClassesPerChunk = 64;
+
+// Formats types into outPut and writes it out once it passes DumpWriter::kFlushThreshold.
+// Enumeration is interleaved with formatting, so it is timed as the rest of the wall time.
+class SerialDump {
+public:
+    SerialDump(DumpWriter &writer, DumpBuffer &outPut)
+            : writer_(writer), outPut_(outPut), start_(metrics_now_ns()) {}
+
+    template<typename Format>
+    void write_type(std::string_view imageStr, Format format) {
+        auto formatStart = metrics_now_ns();
+        outPut_.append(imageStr);
+        auto start = outPut_.size();
+        format(outPut_);
+        max_type_size_ = std::max(max_type_size_, outPut_.size() - start);
+        auto formatEnd = metrics_now_ns();
+        format_ns_ += formatEnd - formatStart;
+        if (outPut_.size() >= DumpWriter::kFlushThreshold) {
+            writer_.write(outPut_);
+            write_ns_ += metrics_now_ns() - formatEnd;
+        }
+    }
+
+    // adds the phase times, what is left in outPut is written by the caller
+    void finish() {
+        metrics_add_time(DumpPhase::Enumerate, metrics_now_ns() - start_ - format_ns_ - write_ns_);
+        metrics_add_time(DumpPhase::Format, format_ns_);
+        metrics_add_time(DumpPhase::Write, write_ns_);
+    }
+
+    size_t max_type_size() const { return max_type_size_; }
+
+private:
+    DumpWriter &writer_;
+    DumpBuffer &outPut_;
+    uint64_t start_;
+    uint64_t format_ns_ = 0;
+    uint64_t write_ns_ = 0;
+    size_t max_type_size_ = 0;
+};
+
+// Dumps every chunk in order, on threads workers when threads > 1. outPut holds what
+// comes before the types and, after a serial dump, the tail that is not written yet.
+//
+// make_worker(spawned) is called once on each thread that formats, spawned is false for
+// the calling thread. The worker it returns provides
+//   resolve(const DumpChunk &, size_t index)      the type at index, timed as enumeration
+//   format(type, const DumpChunk &, DumpBuffer &)  dump_type
+//   hits() and misses()                           of its type name cache
+// Returns the size of the largest type.
+template<typename MakeWorker>
+size_t dump_chunks(const std::vector<DumpChunk> &chunks,
+                   const std::vector<std::string> &imageStrs, unsigned int threads,
+                   DumpWriter &writer, DumpBuffer &outPut, size_t &nameHits,
+                   size_t &nameMisses, MakeWorker make_worker) {
+    if (threads <= 1) {
+        auto worker = make_worker(false);
+        SerialDump serial(writer, outPut);
+        for (auto &chunk: chunks) {
+            auto &imageStr = imageStrs[chunk.image];
+            for (auto j = chunk.begin; j < chunk.end; ++j) {
+                auto type = worker.resolve(chunk, j);
+                serial.write_type(imageStr, [&](DumpBuffer &out) {
+                    worker.format(type, chunk, out);
+                });
+            }
+        }
+        serial.finish();
+        nameHits += worker.hits();
+        nameMisses += worker.misses();
+        return serial.max_type_size();
+    }
+    {
+        PhaseTimer timer(DumpPhase::Write);
+        writer.write(outPut);
+    }
+    LOGI("dumping %zu chunks with %u threads", chunks.size(), threads);
+    DumpScheduler scheduler(chunks.size(), threads, threads * 4);
+    std::vector<size_t> maxTypeSizes(threads);
+    std::vector<size_t> hits(threads);
+    std::vector<size_t> misses(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            //每个线程独立的worker和类型名缓存, 避免加锁
+            auto worker = make_worker(true);
+            size_t index;
+            uint64_t enumerateNs = 0;
+            uint64_t formatNs = 0;
+            while (scheduler.pop(w, &index)) {
+                auto &chunk = chunks[index];
+                auto &imageStr = imageStrs[chunk.image];
+                DumpBuffer chunkOut;
+                for (auto j = chunk.begin; j < chunk.end; ++j) {
+                    auto t0 = metrics_now_ns();
+                    auto type = worker.resolve(chunk, j);
+                    auto t1 = metrics_now_ns();
+                    chunkOut.append(imageStr);
+                    auto start = chunkOut.size();
+                    worker.format(type, chunk, chunkOut);
+                    maxTypeSizes[w] = std::max(maxTypeSizes[w], chunkOut.size() - start);
+                    enumerateNs += t1 - t0;
+                    formatNs += metrics_now_ns() - t1;
+                }
+                scheduler.complete(index, std::move(chunkOut));
+            }
+            metrics_add_time(DumpPhase::Enumerate, enumerateNs);
+            metrics_add_time(DumpPhase::Format, formatNs);
+            metrics_flush_counters();
+            hits[w] = worker.hits();
+            misses[w] = worker.misses();
+        });
+    }
+    while (scheduler.next(&outPut)) {
+        PhaseTimer timer(DumpPhase::Write);
+        writer.write(outPut);
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    size_t maxTypeSize = 0;
+    for (unsigned int w = 0; w < threads; ++w) {
+        nameHits += hits[w];
+        nameMisses += misses[w];
+        maxTypeSize = std::max(maxTypeSize, maxTypeSizes[w]);
+    }
+    LOGI("parallel dump done, %zu steals", scheduler.steal_count());
+    return maxTypeSize;
+}
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_DRIVER_H
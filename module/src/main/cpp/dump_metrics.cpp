@@ -0,0 +1,110 @@
+//
+// Phase timings and counters of a dump.
+//
+
+#include "dump_metrics.h"
+#include <atomic>
+#include <iterator>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include "dump_writer.h"
+#include "log.h"
+
+namespace {
+
+constexpr const char *kPhaseNames[] = {
+        "lib_wait", "vm_wait", "symbols", "enumerate", "format", "write", "snapshot", "total"};
+static_assert(std::size(kPhaseNames) == static_cast<size_t>(DumpPhase::Count));
+
+// worker threads add their times and counters when they finish
+std::atomic<uint64_t> phase_ns[static_cast<size_t>(DumpPhase::Count)];
+std::atomic<uint64_t> classes;
+std::atomic<uint64_t> methods;
+std::atomic<uint64_t> fields;
+std::atomic<uint64_t> properties;
+unsigned int dump_threads;
+size_t dump_images;
+size_t dump_bytes;
+
+double phase_ms(DumpPhase phase) {
+    return phase_ns[static_cast<size_t>(phase)].load(std::memory_order_relaxed) / 1e6;
+}
+
+}
+
+thread_local DumpCounters dump_counters;
+
+uint64_t metrics_now_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void metrics_add_time(DumpPhase phase, uint64_t ns) {
+    phase_ns[static_cast<size_t>(phase)].fetch_add(ns, std::memory_order_relaxed);
+}
+
+void metrics_flush_counters() {
+    classes.fetch_add(dump_counters.classes, std::memory_order_relaxed);
+    methods.fetch_add(dump_counters.methods, std::memory_order_relaxed);
+    fields.fetch_add(dump_counters.fields, std::memory_order_relaxed);
+    properties.fetch_add(dump_counters.properties, std::memory_order_relaxed);
+    dump_counters = {};
+}
+
+void metrics_begin_dump(unsigned int threads, size_t images) {
+    for (auto phase = static_cast<size_t>(DumpPhase::Enumerate);
+         phase < static_cast<size_t>(DumpPhase::Count); ++phase) {
+        phase_ns[phase].store(0, std::memory_order_relaxed);
+    }
+    classes = 0;
+    methods = 0;
+    fields = 0;
+    properties = 0;
+    dump_counters = {};
+    dump_threads = threads;
+    dump_images = images;
+    dump_bytes = 0;
+}
+
+void metrics_end_dump(size_t bytes) {
+    dump_bytes = bytes;
+}
+
+void metrics_log() {
+    LOGI("metrics: lib_wait %.1fms vm_wait %.1fms symbols %.1fms enumerate %.1fms "
+         "format %.1fms write %.1fms snapshot %.1fms total %.1fms, threads %u, images %zu, "
+         "classes %" PRIu64 ", methods %" PRIu64 ", fields %" PRIu64 ", properties %" PRIu64
+         ", bytes %zu",
+         phase_ms(DumpPhase::LibWait), phase_ms(DumpPhase::VmWait), phase_ms(DumpPhase::Symbols),
+         phase_ms(DumpPhase::Enumerate), phase_ms(DumpPhase::Format), phase_ms(DumpPhase::Write),
+         phase_ms(DumpPhase::Snapshot), phase_ms(DumpPhase::Total), dump_threads, dump_images,
+         classes.load(), methods.load(), fields.load(), properties.load(), dump_bytes);
+}
+
+bool metrics_write(const char *path) {
+    DumpBuffer json;
+    char number[32];
+    json.append("{\n  \"version\": 1,\n  \"phases_ms\": {");
+    for (size_t i = 0; i < std::size(kPhaseNames); ++i) {
+        snprintf(number, sizeof(number), "%.3f", phase_ms(static_cast<DumpPhase>(i)));
+        json.append(i ? ",\n    \"" : "\n    \"").append(kPhaseNames[i]).append("\": ")
+                .append(number);
+    }
+    json.append("\n  },\n  \"threads\": ").append_dec((uint64_t) dump_threads);
+    json.append(",\n  \"images\": ").append_dec((uint64_t) dump_images);
+    json.append(",\n  \"classes\": ").append_dec(classes.load());
+    json.append(",\n  \"methods\": ").append_dec(methods.load());
+    json.append(",\n  \"fields\": ").append_dec(fields.load());
+    json.append(",\n  \"properties\": ").append_dec(properties.load());
+    json.append(",\n  \"bytes\": ").append_dec((uint64_t) dump_bytes);
+    json.append("\n}\n");
+    DumpWriter writer;
+    if (!writer.open(path)) {
+        return false;
+    }
+    writer.write(json);
+    writer.close();
+    return !writer.failed();
+}
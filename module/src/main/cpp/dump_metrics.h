@@ -0,0 +1,72 @@
+//
+// Phase timings and counters of a dump, logged as one line and written to
+// files/dump_metrics.json next to dump.cs.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_METRICS_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum class DumpPhase {
+    // hack_start waiting for libil2cpp.so to be loaded
+    LibWait,
+    // il2cpp_api_init waiting for il2cpp_init to finish
+    VmWait,
+    // resolving the il2cpp api
+    Symbols,
+    // walking assemblies, images and classes, summed over worker threads
+    Enumerate,
+    // dump_type, summed over worker threads
+    Format,
+    // writing dump.cs
+    Write,
+    Snapshot,
+    // wall time of il2cpp_dump
+    Total,
+    Count
+};
+
+struct DumpCounters {
+    uint64_t classes = 0;
+    uint64_t methods = 0;
+    uint64_t fields = 0;
+    uint64_t properties = 0;
+};
+
+// bumped by the formatters on the thread that runs them
+extern thread_local DumpCounters dump_counters;
+
+uint64_t metrics_now_ns();
+
+void metrics_add_time(DumpPhase phase, uint64_t ns);
+
+// adds dump_counters of the calling thread to the dump and clears them
+void metrics_flush_counters();
+
+// clears everything il2cpp_dump measures, keeping the waits that happened before it
+void metrics_begin_dump(unsigned int threads, size_t images);
+
+void metrics_end_dump(size_t bytes);
+
+void metrics_log();
+
+bool metrics_write(const char *path);
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(DumpPhase phase) : phase_(phase), start_(metrics_now_ns()) {}
+
+    ~PhaseTimer() { metrics_add_time(phase_, metrics_now_ns() - start_); }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    DumpPhase phase_;
+    uint64_t start_;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_METRICS_H
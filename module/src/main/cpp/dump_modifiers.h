@@ -0,0 +1,231 @@
+//
+// Modifier keywords for methods, fields, types and parameters, precomputed at compile time.
+// Each table is indexed by the attribute bits that affect the output, so formatting
+// a declaration is a single lookup instead of a switch plus several appends.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_MODIFIERS_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_MODIFIERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "il2cpp-tabledefs.h"
+
+template<size_t Capacity>
+struct ModifierString {
+    char data[Capacity]{};
+    size_t size = 0;
+
+    constexpr void append(std::string_view str) {
+        for (char c: str) {
+            data[size++] = c;
+        }
+    }
+
+    constexpr std::string_view view() const { return {data, size}; }
+};
+
+constexpr std::string_view member_access_name(uint32_t access) {
+    // METHOD_ATTRIBUTE_* and FIELD_ATTRIBUTE_* share the same access encoding
+    switch (access) {
+        case METHOD_ATTRIBUTE_PRIVATE:
+            return "private ";
+        case METHOD_ATTRIBUTE_PUBLIC:
+            return "public ";
+        case METHOD_ATTRIBUTE_FAMILY:
+            return "protected ";
+        case METHOD_ATTRIBUTE_ASSEM:
+        case METHOD_ATTRIBUTE_FAM_AND_ASSEM:
+            return "internal ";
+        case METHOD_ATTRIBUTE_FAM_OR_ASSEM:
+            return "protected internal ";
+        default:
+            return "";
+    }
+}
+
+// bit layout: access(3) | static | final | virtual | new_slot | abstract | pinvoke
+constexpr size_t method_modifier_index(uint32_t flags) {
+    return (flags & METHOD_ATTRIBUTE_MEMBER_ACCESS_MASK) |
+           (flags & METHOD_ATTRIBUTE_STATIC ? 1 << 3 : 0) |
+           (flags & METHOD_ATTRIBUTE_FINAL ? 1 << 4 : 0) |
+           (flags & METHOD_ATTRIBUTE_VIRTUAL ? 1 << 5 : 0) |
+           (flags & METHOD_ATTRIBUTE_NEW_SLOT ? 1 << 6 : 0) |
+           (flags & METHOD_ATTRIBUTE_ABSTRACT ? 1 << 7 : 0) |
+           (flags & METHOD_ATTRIBUTE_PINVOKE_IMPL ? 1 << 8 : 0);
+}
+
+inline constexpr auto kMethodModifiers = [] {
+    std::array<ModifierString<56>, 1 << 9> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        auto &str = table[i];
+        bool reuse_slot = !(i & 1 << 6);
+        str.append(member_access_name(i & METHOD_ATTRIBUTE_MEMBER_ACCESS_MASK));
+        if (i & 1 << 3) {
+            str.append("static ");
+        }
+        if (i & 1 << 7) {
+            str.append(reuse_slot ? "abstract override " : "abstract ");
+        } else if (i & 1 << 4) {
+            if (reuse_slot) {
+                str.append("sealed override ");
+            }
+        } else if (i & 1 << 5) {
+            str.append(reuse_slot ? "override " : "virtual ");
+        }
+        if (i & 1 << 8) {
+            str.append("extern ");
+        }
+    }
+    return table;
+}();
+
+constexpr std::string_view get_method_modifier(uint32_t flags) {
+    return kMethodModifiers[method_modifier_index(flags)].view();
+}
+
+// bit layout: access(3) | static | init_only | literal
+constexpr size_t field_modifier_index(uint32_t attrs) {
+    return (attrs & FIELD_ATTRIBUTE_FIELD_ACCESS_MASK) |
+           (attrs & FIELD_ATTRIBUTE_STATIC ? 1 << 3 : 0) |
+           (attrs & FIELD_ATTRIBUTE_INIT_ONLY ? 1 << 4 : 0) |
+           (attrs & FIELD_ATTRIBUTE_LITERAL ? 1 << 5 : 0);
+}
+
+inline constexpr auto kFieldModifiers = [] {
+    std::array<ModifierString<40>, 1 << 6> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        auto &str = table[i];
+        str.append(member_access_name(i & FIELD_ATTRIBUTE_FIELD_ACCESS_MASK));
+        if (i & 1 << 5) {
+            str.append("const ");
+        } else {
+            if (i & 1 << 3) {
+                str.append("static ");
+            }
+            if (i & 1 << 4) {
+                str.append("readonly ");
+            }
+        }
+    }
+    return table;
+}();
+
+constexpr std::string_view get_field_modifier(uint32_t attrs) {
+    return kFieldModifiers[field_modifier_index(attrs)].view();
+}
+
+// bit layout: visibility(3) | abstract | sealed | interface | valuetype | enum
+constexpr size_t type_modifier_index(uint32_t flags, bool is_valuetype, bool is_enum) {
+    return (flags & TYPE_ATTRIBUTE_VISIBILITY_MASK) |
+           (flags & TYPE_ATTRIBUTE_ABSTRACT ? 1 << 3 : 0) |
+           (flags & TYPE_ATTRIBUTE_SEALED ? 1 << 4 : 0) |
+           (flags & TYPE_ATTRIBUTE_INTERFACE ? 1 << 5 : 0) |
+           (is_valuetype ? 1 << 6 : 0) |
+           (is_enum ? 1 << 7 : 0);
+}
+
+inline constexpr auto kTypeModifiers = [] {
+    std::array<ModifierString<40>, 1 << 8> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        auto &str = table[i];
+        bool is_abstract = i & 1 << 3;
+        bool is_sealed = i & 1 << 4;
+        bool is_interface = i & 1 << 5;
+        bool is_valuetype = i & 1 << 6;
+        bool is_enum = i & 1 << 7;
+        switch (i & TYPE_ATTRIBUTE_VISIBILITY_MASK) {
+            case TYPE_ATTRIBUTE_PUBLIC:
+            case TYPE_ATTRIBUTE_NESTED_PUBLIC:
+                str.append("public ");
+                break;
+            case TYPE_ATTRIBUTE_NOT_PUBLIC:
+            case TYPE_ATTRIBUTE_NESTED_FAM_AND_ASSEM:
+            case TYPE_ATTRIBUTE_NESTED_ASSEMBLY:
+                str.append("internal ");
+                break;
+            case TYPE_ATTRIBUTE_NESTED_PRIVATE:
+                str.append("private ");
+                break;
+            case TYPE_ATTRIBUTE_NESTED_FAMILY:
+                str.append("protected ");
+                break;
+            case TYPE_ATTRIBUTE_NESTED_FAM_OR_ASSEM:
+                str.append("protected internal ");
+                break;
+        }
+        if (is_abstract && is_sealed) {
+            str.append("static ");
+        } else if (!is_interface && is_abstract) {
+            str.append("abstract ");
+        } else if (!is_valuetype && !is_enum && is_sealed) {
+            str.append("sealed ");
+        }
+        if (is_interface) {
+            str.append("interface ");
+        } else if (is_enum) {
+            str.append("enum ");
+        } else if (is_valuetype) {
+            str.append("struct ");
+        } else {
+            str.append("class ");
+        }
+    }
+    return table;
+}();
+
+constexpr std::string_view get_type_modifier(uint32_t flags, bool is_valuetype, bool is_enum) {
+    return kTypeModifiers[type_modifier_index(flags, is_valuetype, is_enum)].view();
+}
+
+// bit layout: in | out | byref
+constexpr size_t param_modifier_index(uint32_t attrs, bool is_byref) {
+    return (attrs & PARAM_ATTRIBUTE_IN ? 1 : 0) |
+           (attrs & PARAM_ATTRIBUTE_OUT ? 1 << 1 : 0) |
+           (is_byref ? 1 << 2 : 0);
+}
+
+inline constexpr auto kParamModifiers = [] {
+    std::array<ModifierString<16>, 1 << 3> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        auto &str = table[i];
+        bool is_in = i & 1;
+        bool is_out = i & 1 << 1;
+        if (i & 1 << 2) {
+            if (is_out && !is_in) {
+                str.append("out ");
+            } else if (is_in && !is_out) {
+                str.append("in ");
+            } else {
+                str.append("ref ");
+            }
+        } else {
+            if (is_in) {
+                str.append("[In] ");
+            }
+            if (is_out) {
+                str.append("[Out] ");
+            }
+        }
+    }
+    return table;
+}();
+
+constexpr std::string_view get_param_modifier(uint32_t attrs, bool is_byref) {
+    return kParamModifiers[param_modifier_index(attrs, is_byref)].view();
+}
+
+static_assert(get_method_modifier(METHOD_ATTRIBUTE_PUBLIC | METHOD_ATTRIBUTE_VIRTUAL |
+                                  METHOD_ATTRIBUTE_NEW_SLOT) == "public virtual ");
+static_assert(get_method_modifier(METHOD_ATTRIBUTE_FAMILY | METHOD_ATTRIBUTE_VIRTUAL |
+                                  METHOD_ATTRIBUTE_FINAL) == "protected sealed override ");
+static_assert(get_field_modifier(FIELD_ATTRIBUTE_PUBLIC | FIELD_ATTRIBUTE_STATIC |
+                                 FIELD_ATTRIBUTE_INIT_ONLY) == "public static readonly ");
+static_assert(get_type_modifier(TYPE_ATTRIBUTE_PUBLIC | TYPE_ATTRIBUTE_ABSTRACT |
+                                TYPE_ATTRIBUTE_SEALED, false, false) == "public static class ");
+static_assert(get_param_modifier(PARAM_ATTRIBUTE_OUT, true) == "out ");
+static_assert(get_param_modifier(PARAM_ATTRIBUTE_IN | PARAM_ATTRIBUTE_OUT, false) == "[In] [Out] ");
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_MODIFIERS_H
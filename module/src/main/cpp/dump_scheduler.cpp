@@ -0,0 +1,76 @@
+//
+// Work-stealing scheduler that hands out dump chunks to worker threads and
+// gives the formatted results back in their original order.
+//
+
+#include "dump_scheduler.h"
+
+DumpScheduler::DumpScheduler(size_t chunk_count, unsigned int workers, size_t window)
+        : queues_(workers), results_(chunk_count), done_(chunk_count), chunk_count_(chunk_count),
+          window_(window), remaining_(chunk_count) {
+    // Chunks are dealt round-robin so that every worker starts near the front of the
+    // output; this keeps the set of finished-but-unwritten chunks small.
+    for (size_t i = 0; i < chunk_count; ++i) {
+        queues_[i % workers].push_back(i);
+    }
+}
+
+bool DumpScheduler::take(unsigned int worker, size_t limit, size_t *chunk) {
+    auto &own = queues_[worker];
+    if (!own.empty() && own.front() < limit) {
+        *chunk = own.front();
+        own.pop_front();
+        return true;
+    }
+    // Steal the lowest pending chunk from the others. Taking from the front rather than
+    // the back unblocks the consumer sooner, which matters more than locality here.
+    std::deque<size_t> *victim = nullptr;
+    for (auto &queue: queues_) {
+        if (!queue.empty() && queue.front() < limit &&
+            (!victim || queue.front() < victim->front())) {
+            victim = &queue;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    *chunk = victim->front();
+    victim->pop_front();
+    ++steals_;
+    return true;
+}
+
+bool DumpScheduler::pop(unsigned int worker, size_t *chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (remaining_ > 0) {
+        if (take(worker, next_ + window_, chunk)) {
+            if (--remaining_ == 0) {
+                worker_cv_.notify_all();
+            }
+            return true;
+        }
+        worker_cv_.wait(lock);
+    }
+    return false;
+}
+
+void DumpScheduler::complete(size_t chunk, DumpBuffer output) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_[chunk] = std::move(output);
+    done_[chunk] = true;
+    if (chunk == next_) {
+        consumer_cv_.notify_one();
+    }
+}
+
+bool DumpScheduler::next(DumpBuffer *output) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (next_ == chunk_count_) {
+        return false;
+    }
+    consumer_cv_.wait(lock, [this] { return done_[next_]; });
+    *output = std::move(results_[next_]);
+    ++next_;
+    worker_cv_.notify_all();
+    return true;
+}
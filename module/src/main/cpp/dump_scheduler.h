@@ -0,0 +1,50 @@
+//
+// Work-stealing scheduler that hands out dump chunks to worker threads and
+// gives the formatted results back in their original order.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_SCHEDULER_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "dump_buffer.h"
+
+class DumpScheduler {
+public:
+    // window limits how far workers may run ahead of the consumer, which bounds the
+    // number of finished chunks waiting in memory
+    DumpScheduler(size_t chunk_count, unsigned int workers, size_t window);
+
+    // Worker side: take the next chunk, from the own queue first, stealing otherwise.
+    // Returns false once every chunk has been handed out.
+    bool pop(unsigned int worker, size_t *chunk);
+
+    void complete(size_t chunk, DumpBuffer output);
+
+    // Consumer side: blocks until the next chunk in order is done.
+    // Returns false after the last chunk.
+    bool next(DumpBuffer *output);
+
+    size_t steal_count() const { return steals_; }
+
+private:
+    bool take(unsigned int worker, size_t limit, size_t *chunk);
+
+    std::mutex mutex_;
+    std::condition_variable worker_cv_;
+    std::condition_variable consumer_cv_;
+    std::vector<std::deque<size_t>> queues_;
+    std::vector<DumpBuffer> results_;
+    std::vector<bool> done_;
+    size_t chunk_count_;
+    size_t window_;
+    size_t remaining_;
+    size_t next_ = 0;
+    size_t steals_ = 0;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_SCHEDULER_H
@@ -0,0 +1,91 @@
+//
+// Writes DumpBuffer blocks to dump.cs, keeps memory flat regardless of the dump size.
+//
+
+#include "dump_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "log.h"
+
+DumpWriter::~DumpWriter() {
+    close();
+}
+
+bool DumpWriter::open(const char *path) {
+    close();
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        LOGE("open %s failed: %s", path, strerror(errno));
+        failed_ = true;
+        return false;
+    }
+    failed_ = false;
+    written_ = 0;
+    return true;
+}
+
+void DumpWriter::write(DumpBuffer &buffer) {
+    if (fd_ == -1 || failed_) {
+        buffer.clear();
+        return;
+    }
+    auto &blocks = buffer.blocks();
+    iovec iov[IOV_MAX < 64 ? IOV_MAX : 64];
+    size_t next = 0;
+    size_t offset = 0;
+    while (next < blocks.size()) {
+        size_t count = 0;
+        for (auto i = next; i < blocks.size() && count < std::size(iov); ++i, ++count) {
+            auto skip = i == next ? offset : 0;
+            iov[count].iov_base = blocks[i].data + skip;
+            iov[count].iov_len = blocks[i].used - skip;
+        }
+        auto n = ::writev(fd_, iov, (int) count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("write dump file failed: %s", strerror(errno));
+            failed_ = true;
+            break;
+        }
+        written_ += n;
+        //部分写入时从中断处继续
+        offset += n;
+        while (next < blocks.size() && offset >= blocks[next].used) {
+            offset -= blocks[next].used;
+            ++next;
+        }
+    }
+    buffer.clear();
+}
+
+void DumpWriter::write(const void *data, size_t size) {
+    auto bytes = static_cast<const char *>(data);
+    while (fd_ != -1 && !failed_ && size > 0) {
+        auto n = ::write(fd_, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("write dump file failed: %s", strerror(errno));
+            failed_ = true;
+            break;
+        }
+        written_ += n;
+        bytes += n;
+        size -= n;
+    }
+}
+
+void DumpWriter::close() {
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
@@ -0,0 +1,43 @@
+//
+// Writes DumpBuffer blocks to dump.cs, keeps memory flat regardless of the dump size.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_DUMP_WRITER_H
+#define ZYGISK_IL2CPPDUMPER_DUMP_WRITER_H
+
+#include <cstddef>
+#include "dump_buffer.h"
+
+class DumpWriter {
+public:
+    // serial dumps flush their buffer once it grows past this
+    static constexpr size_t kFlushThreshold = 64 * 1024;
+
+    DumpWriter() = default;
+
+    ~DumpWriter();
+
+    DumpWriter(const DumpWriter &) = delete;
+
+    DumpWriter &operator=(const DumpWriter &) = delete;
+
+    bool open(const char *path);
+
+    // writes every block of buffer and clears it
+    void write(DumpBuffer &buffer);
+
+    void write(const void *data, size_t size);
+
+    void close();
+
+    bool failed() const { return failed_; }
+
+    size_t bytes_written() const { return written_; }
+
+private:
+    int fd_ = -1;
+    size_t written_ = 0;
+    bool failed_ = false;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_DUMP_WRITER_H
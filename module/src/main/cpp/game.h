@@ -7,4 +7,17 @@
 
 #define GamePackageName "com.game.packagename"
 
+// Threads used to format classes, 0 uses every core, 1 dumps serially
+#define DumpThreads 1
+
+// Also write files/dump.bin, a binary snapshot for tools, see snapshot_format.h
+#define DumpSnapshot false
+
+// Read the classes straight from global-metadata.dat instead of the il2cpp api,
+// falls back to the api when the metadata version is not supported
+#define DumpMetadata false
+
+// Milliseconds to wait for libil2cpp.so to be loaded before giving up
+#define Il2CppWaitTimeout 60000
+
 #endif //ZYGISK_IL2CPPDUMPER_GAME_H
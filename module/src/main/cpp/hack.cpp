@@ -4,35 +4,83 @@
 
 #include "hack.h"
 #include "il2cpp_dump.h"
+#include "dump_metrics.h"
+#include "game.h"
 #include "log.h"
 #include "xdl.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
 #include <cstring>
 #include <cstdio>
 #include <unistd.h>
 #include <sys/system_properties.h>
 #include <dlfcn.h>
+#include <link.h>
 #include <jni.h>
 #include <thread>
 #include <sys/mman.h>
 #include <linux/unistd.h>
 #include <array>
 
-void hack_start(const char *game_data_dir) {
-    bool load = false;
-    for (int i = 0; i < 10; i++) {
-        void *handle = xdl_open("libil2cpp.so", 0);
-        if (handle) {
-            load = true;
-            il2cpp_api_init(handle);
-            il2cpp_dump(game_data_dir);
-            break;
-        } else {
-            sleep(1);
+static constexpr unsigned int kMaxLibWaitBackoffMs = 50;
+
+// dlpi_adds only grows when the linker maps a new library, so it is enough to look
+// for libil2cpp.so again when it changed
+static uint64_t loaded_library_generation() {
+    uint64_t generation = 0;
+    dl_iterate_phdr([](dl_phdr_info *info, size_t size, void *data) {
+        auto generation = static_cast<uint64_t *>(data);
+        if (size >= offsetof(dl_phdr_info, dlpi_subs)) {
+            *generation = info->dlpi_adds;
+            return 1;
+        }
+        //旧版linker没有dlpi_adds, 用已加载的库数量代替
+        ++*generation;
+        return 0;
+    }, &generation);
+    return generation;
+}
+
+static void *wait_for_il2cpp(unsigned int timeout_ms) {
+    auto start = metrics_now_ns();
+    auto generation = UINT64_MAX;
+    unsigned int backoff = 1;
+    while (true) {
+        auto current = loaded_library_generation();
+        if (current != generation) {
+            generation = current;
+            if (auto handle = xdl_open("libil2cpp.so", 0)) {
+                return handle;
+            }
+            //有新库加载时游戏正在启动, 缩短间隔
+            backoff = 1;
+        }
+        if (metrics_now_ns() - start >= (uint64_t) timeout_ms * 1000000) {
+            return nullptr;
         }
+        usleep(backoff * 1000);
+        backoff = std::min(backoff * 2, kMaxLibWaitBackoffMs);
     }
-    if (!load) {
-        LOGI("libil2cpp.so not found in thread %d", gettid());
+}
+
+void hack_start(const HackArgs *args) {
+    auto waitStart = metrics_now_ns();
+    auto handle = wait_for_il2cpp(Il2CppWaitTimeout);
+    auto waitNs = metrics_now_ns() - waitStart;
+    if (!handle) {
+        LOGI("libil2cpp.so not found in thread %d after %" PRIu64 " ms", gettid(),
+             waitNs / 1000000);
+        return;
     }
+    LOGI("libil2cpp.so loaded after %" PRIu64 " ms", waitNs / 1000000);
+    metrics_add_time(DumpPhase::LibWait, waitNs);
+    il2cpp_api_init(handle);
+    DumpOptions options;
+    options.threads = args->threads;
+    options.snapshot = args->snapshot != 0;
+    options.metadata = args->metadata != 0;
+    il2cpp_dump(args->game_data_dir, options);
 }
 
 std::string GetLibDir(JavaVM *vms) {
@@ -111,24 +159,129 @@ struct NativeBridgeCallbacks {
     void *(*loadLibraryExt)(const char *libpath, int flag, void *ns);
 };
 
-bool NativeBridgeLoad(const char *game_data_dir, int api_level, void *data, size_t length) {
-    //TODO 等待houdini初始化
-    sleep(5);
+static constexpr unsigned int kNativeBridgeTimeoutMs = 15000;
+static constexpr unsigned int kMaxNativeBridgeBackoffMs = 200;
+
+// Polls probe with a backoff from 1 ms up to kMaxNativeBridgeBackoffMs until it
+// returns true or deadline_ns passes.
+template<typename Probe>
+static bool WaitUntil(uint64_t deadline_ns, Probe probe) {
+    unsigned int backoff = 1;
+    while (!probe()) {
+        if (metrics_now_ns() >= deadline_ns) {
+            return false;
+        }
+        usleep(backoff * 1000);
+        backoff = std::min(backoff * 2, kMaxNativeBridgeBackoffMs);
+    }
+    return true;
+}
 
+// GetLibDir needs the Application, which is only bound some time after specialization
+static bool HasApplication(JavaVM *vms) {
+    JNIEnv *env = nullptr;
+    if (vms->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+        return false;
+    }
+    auto activity_thread_clz = env->FindClass("android/app/ActivityThread");
+    if (!activity_thread_clz) {
+        env->ExceptionClear();
+        return false;
+    }
+    auto currentApplicationId = env->GetStaticMethodID(activity_thread_clz, "currentApplication",
+                                                       "()Landroid/app/Application;");
+    if (!currentApplicationId) {
+        env->ExceptionClear();
+        env->DeleteLocalRef(activity_thread_clz);
+        return false;
+    }
+    auto application = env->CallStaticObjectMethod(activity_thread_clz, currentApplicationId);
+    env->DeleteLocalRef(activity_thread_clz);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    if (!application) {
+        return false;
+    }
+    env->DeleteLocalRef(application);
+    return true;
+}
+
+static JavaVM *WaitForJavaVM(uint64_t deadline_ns) {
     auto libart = dlopen("libart.so", RTLD_NOW);
     auto JNI_GetCreatedJavaVMs = (jint (*)(JavaVM **, jsize, jsize *)) dlsym(libart,
                                                                              "JNI_GetCreatedJavaVMs");
     LOGI("JNI_GetCreatedJavaVMs %p", JNI_GetCreatedJavaVMs);
-    JavaVM *vms_buf[1];
-    JavaVM *vms;
-    jsize num_vms;
-    jint status = JNI_GetCreatedJavaVMs(vms_buf, 1, &num_vms);
-    if (status == JNI_OK && num_vms > 0) {
+    if (!JNI_GetCreatedJavaVMs) {
+        return nullptr;
+    }
+    JavaVM *vms = nullptr;
+    auto ready = WaitUntil(deadline_ns, [&] {
+        JavaVM *vms_buf[1];
+        jsize num_vms = 0;
+        if (JNI_GetCreatedJavaVMs(vms_buf, 1, &num_vms) != JNI_OK || num_vms == 0) {
+            return false;
+        }
         vms = vms_buf[0];
-    } else {
+        return HasApplication(vms);
+    });
+    return ready ? vms : nullptr;
+}
+
+// libnativebridge exports C names since Android 10, mangled ones before
+static bool (*GetNativeBridgeInitialized())() {
+    auto handle = xdl_open("libnativebridge.so", XDL_DEFAULT);
+    if (!handle) {
+        return nullptr;
+    }
+    auto initialized = xdl_sym(handle, "NativeBridgeInitialized", nullptr);
+    if (!initialized) {
+        initialized = xdl_sym(handle, "_ZN7android23NativeBridgeInitializedEv", nullptr);
+    }
+    xdl_close(handle);
+    return (bool (*)()) initialized;
+}
+
+// The bridge is usable once the runtime initialized it for this app and the
+// callbacks NativeBridgeLoad uses are filled in
+static bool WaitForNativeBridge(NativeBridgeCallbacks *callbacks, int api_level,
+                                uint64_t deadline_ns) {
+    auto initialized = GetNativeBridgeInitialized();
+    LOGI("NativeBridgeInitialized %p", initialized);
+    return WaitUntil(deadline_ns, [&] {
+        if (initialized && !initialized()) {
+            return false;
+        }
+        auto load = api_level >= 26 ? (void *) callbacks->loadLibraryExt
+                                    : (void *) callbacks->loadLibrary;
+        return load && callbacks->getTrampoline;
+    });
+}
+
+// Closes the payload memfd on every path where NativeBridge did not load the library from it
+struct PayloadFd {
+    int fd;
+
+    ~PayloadFd() {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    void release() { fd = -1; }
+};
+
+bool NativeBridgeLoad(const HackArgs *args, int api_level, int payload_fd) {
+    PayloadFd payload{payload_fd};
+    auto waitStart = metrics_now_ns();
+    auto deadline = waitStart + (uint64_t) kNativeBridgeTimeoutMs * 1000000;
+    auto vms = WaitForJavaVM(deadline);
+    if (!vms) {
         LOGE("GetCreatedJavaVMs error");
         return false;
     }
+    LOGI("JavaVM ready after %" PRIu64 " ms", (metrics_now_ns() - waitStart) / 1000000);
 
     auto lib_dir = GetLibDir(vms);
     if (lib_dir.empty()) {
@@ -137,7 +290,10 @@ bool NativeBridgeLoad(const char *game_data_dir, int api_level, void *data, size
     }
     if (lib_dir.find("/lib/x86") != std::string::npos) {
         LOGI("no need NativeBridge");
-        munmap(data, length);
+        return false;
+    }
+    if (payload_fd == -1) {
+        LOGE("arm payload not available");
         return false;
     }
 
@@ -151,18 +307,19 @@ bool NativeBridgeLoad(const char *game_data_dir, int api_level, void *data, size
         LOGI("nb %p", nb);
         auto callbacks = (NativeBridgeCallbacks *) dlsym(nb, "NativeBridgeItf");
         if (callbacks) {
+            if (!WaitForNativeBridge(callbacks, api_level, deadline)) {
+                LOGE("native bridge not ready after %u ms", kNativeBridgeTimeoutMs);
+                return false;
+            }
+            LOGI("native bridge ready after %" PRIu64 " ms",
+                 (metrics_now_ns() - waitStart) / 1000000);
             LOGI("NativeBridgeLoadLibrary %p", callbacks->loadLibrary);
             LOGI("NativeBridgeLoadLibraryExt %p", callbacks->loadLibraryExt);
             LOGI("NativeBridgeGetTrampoline %p", callbacks->getTrampoline);
 
-            int fd = syscall(__NR_memfd_create, "anon", MFD_CLOEXEC);
-            ftruncate(fd, (off_t) length);
-            void *mem = mmap(nullptr, length, PROT_WRITE, MAP_SHARED, fd, 0);
-            memcpy(mem, data, length);
-            munmap(mem, length);
-            munmap(data, length);
+            //payload_fd是preSpecialize中已写好的memfd, 直接交给NativeBridge加载
             char path[PATH_MAX];
-            snprintf(path, PATH_MAX, "/proc/self/fd/%d", fd);
+            snprintf(path, PATH_MAX, "/proc/self/fd/%d", payload_fd);
             LOGI("arm path %s", path);
 
             void *arm_handle;
@@ -172,29 +329,29 @@ bool NativeBridgeLoad(const char *game_data_dir, int api_level, void *data, size
                 arm_handle = callbacks->loadLibrary(path, RTLD_NOW);
             }
             if (arm_handle) {
+                payload.release();
                 LOGI("arm handle %p", arm_handle);
                 auto init = (void (*)(JavaVM *, void *)) callbacks->getTrampoline(arm_handle,
                                                                                   "JNI_OnLoad",
                                                                                   nullptr, 0);
                 LOGI("JNI_OnLoad %p", init);
-                init(vms, (void *) game_data_dir);
+                init(vms, (void *) args);
                 return true;
             }
-            close(fd);
         }
     }
     return false;
 }
 
-void hack_prepare(const char *game_data_dir, void *data, size_t length) {
+void hack_prepare(const HackArgs *args, int payload_fd) {
     LOGI("hack thread: %d", gettid());
     int api_level = android_get_device_api_level();
     LOGI("api level: %d", api_level);
 
 #if defined(__i386__) || defined(__x86_64__)
-    if (!NativeBridgeLoad(game_data_dir, api_level, data, length)) {
+    if (!NativeBridgeLoad(args, api_level, payload_fd)) {
 #endif
-        hack_start(game_data_dir);
+        hack_start(args);
 #if defined(__i386__) || defined(__x86_64__)
     }
 #endif
@@ -203,8 +360,8 @@ void hack_prepare(const char *game_data_dir, void *data, size_t length) {
 #if defined(__arm__) || defined(__aarch64__)
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
-    auto game_data_dir = (const char *) reserved;
-    std::thread hack_thread(hack_start, game_data_dir);
+    auto args = (const HackArgs *) reserved;
+    std::thread hack_thread(hack_start, args);
     hack_thread.detach();
     return JNI_VERSION_1_6;
 }
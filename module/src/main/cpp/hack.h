@@ -6,7 +6,22 @@
 #define ZYGISK_IL2CPPDUMPER_HACK_H
 
 #include <stddef.h>
+#include <stdint.h>
 
-void hack_prepare(const char *game_data_dir, void *data, size_t length);
+// Reaches the arm payload through the reserved argument of JNI_OnLoad, so it only
+// holds pointers and 32-bit fields to keep the same layout on both sides of the bridge.
+struct HackArgs {
+    const char *game_data_dir;
+    uint32_t threads;
+    uint32_t snapshot;
+    uint32_t metadata;
+};
+
+// Entry of the dumper library, looked up with dlsym by the zygisk stub in main.cpp.
+// payload_fd is a memfd holding the arm library for the native bridge, -1 if there is none
+extern "C" __attribute__((visibility("default")))
+void hack_prepare(const HackArgs *args, int payload_fd);
+
+using HackPrepareFn = void (*)(const HackArgs *args, int payload_fd);
 
 #endif //ZYGISK_IL2CPPDUMPER_HACK_H
@@ -1,3 +1,5 @@
+#pragma once
+
 typedef uint16_t Il2CppChar;
 typedef uintptr_t il2cpp_array_size_t;
 typedef int32_t TypeDefinitionIndex;
@@ -123,6 +125,35 @@ typedef struct Il2CppType {
     unsigned int pinned: 1;
 } Il2CppType;
 
+typedef struct Il2CppArrayType {
+    const Il2CppType *etype;
+    uint8_t rank;
+    uint8_t numsizes;
+    uint8_t numlobounds;
+    int *sizes;
+    int *lobounds;
+} Il2CppArrayType;
+
+typedef struct Il2CppGenericInst {
+    uint32_t type_argc;
+    const Il2CppType **type_argv;
+} Il2CppGenericInst;
+
+typedef struct Il2CppGenericContext {
+    const Il2CppGenericInst *class_inst;
+    const Il2CppGenericInst *method_inst;
+} Il2CppGenericContext;
+
+typedef struct Il2CppGenericClass {
+    // TypeDefinitionIndex before 2021.2, the padding keeps context at the same offset
+    union {
+        TypeDefinitionIndex typeDefinitionIndex;
+        const Il2CppType *type;
+    };
+    Il2CppGenericContext context;
+    Il2CppClass *cached_class;
+} Il2CppGenericClass;
+
 typedef struct MethodInfo {
     Il2CppMethodPointer methodPointer;
 } MethodInfo;
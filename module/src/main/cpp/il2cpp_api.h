@@ -0,0 +1,59 @@
+//
+// il2cpp api function pointers, resolved by il2cpp_api_init().
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_IL2CPP_API_H
+#define ZYGISK_IL2CPPDUMPER_IL2CPP_API_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "il2cpp-class.h"
+
+#define DO_API(r, n, p) extern r (*n) p
+
+#include "il2cpp-api-functions.h"
+
+#undef DO_API
+
+// Hash used by .gnu.hash, so the api names can be hashed at compile time
+constexpr uint32_t elf_gnu_hash(const char *name) {
+    uint32_t hash = 5381;
+    while (*name) {
+        hash += (hash << 5) + (uint8_t) *name++;
+    }
+    return hash;
+}
+
+// Every DO_API name in declaration order. The api list ends each entry with a ';', so
+// the arrays are filled by statements instead of an initializer list.
+inline constexpr size_t kIl2CppApiCount = [] {
+    size_t count = 0;
+#define DO_API(r, n, p) ++count
+
+#include "il2cpp-api-functions.h"
+
+#undef DO_API
+    return count;
+}();
+
+inline constexpr auto kIl2CppApiNames = [] {
+    std::array<const char *, kIl2CppApiCount> names{};
+    size_t index = 0;
+#define DO_API(r, n, p) names[index++] = #n
+
+#include "il2cpp-api-functions.h"
+
+#undef DO_API
+    return names;
+}();
+
+inline constexpr auto kIl2CppApiHashes = [] {
+    std::array<uint32_t, kIl2CppApiCount> hashes{};
+    for (size_t i = 0; i < kIl2CppApiCount; ++i) {
+        hashes[i] = elf_gnu_hash(kIl2CppApiNames[i]);
+    }
+    return hashes;
+}();
+
+#endif //ZYGISK_IL2CPPDUMPER_IL2CPP_API_H
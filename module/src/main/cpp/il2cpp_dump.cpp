@@ -3,19 +3,29 @@
 //
 
 #include "il2cpp_dump.h"
-#include <dlfcn.h>
 #include <cstdlib>
 #include <cstring>
 #include <cinttypes>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <fstream>
+#include <thread>
+#include <algorithm>
 #include <unistd.h>
+#include <sys/resource.h>
 #include "xdl.h"
 #include "log.h"
 #include "il2cpp-tabledefs.h"
-#include "il2cpp-class.h"
+#include "il2cpp_api.h"
+#include "dump_modifiers.h"
+#include "dump_buffer.h"
+#include "dump_writer.h"
+#include "dump_driver.h"
+#include "type_name_cache.h"
+#include "il2cpp_snapshot.h"
+#include "dump_metrics.h"
+#include "il2cpp_init_hook.h"
+#include "il2cpp_metadata.h"
+#include "metadata_dump.h"
 
 #define DO_API(r, n, p) r (*n) p
 
@@ -24,10 +34,25 @@
 #undef DO_API
 
 static uint64_t il2cpp_base = 0;
+//metadata导出需要从libil2cpp.so的数据段中查找registration
+static void *il2cpp_handle = nullptr;
+//导出被裁剪时api不可用, 只能从global-metadata.dat导出
+static bool il2cpp_api_ready = false;
+
+// How long a dump without the il2cpp api polls for global-metadata.dat to be mapped, it
+// cannot wait for il2cpp_init
+static constexpr unsigned int kMetadataWaitSeconds = 60;
 
 void init_il2cpp_api(void *handle) {
+    //一次遍历.gnu.hash解析全部api, 名字的hash在编译期算好
+    xdl_sym_req_t reqs[kIl2CppApiCount];
+    for (size_t i = 0; i < kIl2CppApiCount; ++i) {
+        reqs[i] = {kIl2CppApiNames[i], kIl2CppApiHashes[i], nullptr};
+    }
+    xdl_sym_batch(handle, reqs, kIl2CppApiCount);
+    size_t index = 0;
 #define DO_API(r, n, p) {                      \
-    n = (r (*) p)xdl_sym(handle, #n, nullptr); \
+    n = (r (*) p)reqs[index++].addr;           \
     if(!n) {                                   \
         LOGW("api not found %s", #n);          \
     }                                          \
@@ -38,52 +63,6 @@ void init_il2cpp_api(void *handle) {
 #undef DO_API
 }
 
-std::string get_method_modifier(uint32_t flags) {
-    std::stringstream outPut;
-    auto access = flags & METHOD_ATTRIBUTE_MEMBER_ACCESS_MASK;
-    switch (access) {
-        case METHOD_ATTRIBUTE_PRIVATE:
-            outPut << "private ";
-            break;
-        case METHOD_ATTRIBUTE_PUBLIC:
-            outPut << "public ";
-            break;
-        case METHOD_ATTRIBUTE_FAMILY:
-            outPut << "protected ";
-            break;
-        case METHOD_ATTRIBUTE_ASSEM:
-        case METHOD_ATTRIBUTE_FAM_AND_ASSEM:
-            outPut << "internal ";
-            break;
-        case METHOD_ATTRIBUTE_FAM_OR_ASSEM:
-            outPut << "protected internal ";
-            break;
-    }
-    if (flags & METHOD_ATTRIBUTE_STATIC) {
-        outPut << "static ";
-    }
-    if (flags & METHOD_ATTRIBUTE_ABSTRACT) {
-        outPut << "abstract ";
-        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_REUSE_SLOT) {
-            outPut << "override ";
-        }
-    } else if (flags & METHOD_ATTRIBUTE_FINAL) {
-        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_REUSE_SLOT) {
-            outPut << "sealed override ";
-        }
-    } else if (flags & METHOD_ATTRIBUTE_VIRTUAL) {
-        if ((flags & METHOD_ATTRIBUTE_VTABLE_LAYOUT_MASK) == METHOD_ATTRIBUTE_NEW_SLOT) {
-            outPut << "virtual ";
-        } else {
-            outPut << "override ";
-        }
-    }
-    if (flags & METHOD_ATTRIBUTE_PINVOKE_IMPL) {
-        outPut << "extern ";
-    }
-    return outPut.str();
-}
-
 bool _il2cpp_type_is_byref(const Il2CppType *type) {
     auto byref = type->byref;
     if (il2cpp_type_is_byref) {
@@ -92,284 +71,320 @@ bool _il2cpp_type_is_byref(const Il2CppType *type) {
     return byref;
 }
 
-std::string dump_method(Il2CppClass *klass) {
-    std::stringstream outPut;
-    outPut << "\n\t// Methods\n";
+void dump_method(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names) {
+    outPut.append("\n\t// Methods\n");
     void *iter = nullptr;
     while (auto method = il2cpp_class_get_methods(klass, &iter)) {
+        ++dump_counters.methods;
         //TODO attribute
         if (method->methodPointer) {
-            outPut << "\t// RVA: 0x";
-            outPut << std::hex << (uint64_t) method->methodPointer - il2cpp_base;
-            outPut << " VA: 0x";
-            outPut << std::hex << (uint64_t) method->methodPointer;
+            outPut.append("\t// RVA: 0x");
+            outPut.append_hex((uint64_t) method->methodPointer - il2cpp_base);
+            outPut.append(" VA: 0x");
+            outPut.append_hex((uint64_t) method->methodPointer);
         } else {
-            outPut << "\t// RVA: 0x VA: 0x0";
+            outPut.append("\t// RVA: 0x VA: 0x0");
         }
         /*if (method->slot != 65535) {
-            outPut << " Slot: " << std::dec << method->slot;
+            outPut.append(" Slot: ").append_dec((uint64_t) method->slot);
         }*/
-        outPut << "\n\t";
+        outPut.append("\n\t");
         uint32_t iflags = 0;
         auto flags = il2cpp_method_get_flags(method, &iflags);
-        outPut << get_method_modifier(flags);
+        outPut.append(get_method_modifier(flags));
         //TODO genericContainerIndex
         auto return_type = il2cpp_method_get_return_type(method);
         if (_il2cpp_type_is_byref(return_type)) {
-            outPut << "ref ";
+            outPut.append("ref ");
         }
-        auto return_class = il2cpp_class_from_type(return_type);
-        outPut << il2cpp_class_get_name(return_class) << " " << il2cpp_method_get_name(method)
-               << "(";
+        outPut.append(names.type_name(return_type)).append(' ')
+                .append(il2cpp_method_get_name(method)).append('(');
         auto param_count = il2cpp_method_get_param_count(method);
         for (int i = 0; i < param_count; ++i) {
-            auto param = il2cpp_method_get_param(method, i);
-            auto attrs = param->attrs;
-            if (_il2cpp_type_is_byref(param)) {
-                if (attrs & PARAM_ATTRIBUTE_OUT && !(attrs & PARAM_ATTRIBUTE_IN)) {
-                    outPut << "out ";
-                } else if (attrs & PARAM_ATTRIBUTE_IN && !(attrs & PARAM_ATTRIBUTE_OUT)) {
-                    outPut << "in ";
-                } else {
-                    outPut << "ref ";
-                }
-            } else {
-                if (attrs & PARAM_ATTRIBUTE_IN) {
-                    outPut << "[In] ";
-                }
-                if (attrs & PARAM_ATTRIBUTE_OUT) {
-                    outPut << "[Out] ";
-                }
+            if (i > 0) {
+                outPut.append(", ");
             }
-            auto parameter_class = il2cpp_class_from_type(param);
-            outPut << il2cpp_class_get_name(parameter_class) << " "
-                   << il2cpp_method_get_param_name(method, i);
-            outPut << ", ";
-        }
-        if (param_count > 0) {
-            outPut.seekp(-2, outPut.cur);
+            auto param = il2cpp_method_get_param(method, i);
+            outPut.append(get_param_modifier(param->attrs, _il2cpp_type_is_byref(param)));
+            outPut.append(names.type_name(param)).append(' ')
+                    .append(il2cpp_method_get_param_name(method, i));
         }
-        outPut << ") { }\n";
+        outPut.append(") { }\n");
         //TODO GenericInstMethod
     }
-    return outPut.str();
 }
 
-std::string dump_property(Il2CppClass *klass) {
-    std::stringstream outPut;
-    outPut << "\n\t// Properties\n";
+void dump_property(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names) {
+    outPut.append("\n\t// Properties\n");
     void *iter = nullptr;
     while (auto prop_const = il2cpp_class_get_properties(klass, &iter)) {
+        ++dump_counters.properties;
         //TODO attribute
         auto prop = const_cast<PropertyInfo *>(prop_const);
         auto get = il2cpp_property_get_get_method(prop);
         auto set = il2cpp_property_get_set_method(prop);
         auto prop_name = il2cpp_property_get_name(prop);
-        outPut << "\t";
-        Il2CppClass *prop_class = nullptr;
+        outPut.append('\t');
+        const Il2CppType *prop_type = nullptr;
         uint32_t iflags = 0;
         if (get) {
-            outPut << get_method_modifier(il2cpp_method_get_flags(get, &iflags));
-            prop_class = il2cpp_class_from_type(il2cpp_method_get_return_type(get));
+            outPut.append(get_method_modifier(il2cpp_method_get_flags(get, &iflags)));
+            prop_type = il2cpp_method_get_return_type(get);
         } else if (set) {
-            outPut << get_method_modifier(il2cpp_method_get_flags(set, &iflags));
-            auto param = il2cpp_method_get_param(set, 0);
-            prop_class = il2cpp_class_from_type(param);
+            outPut.append(get_method_modifier(il2cpp_method_get_flags(set, &iflags)));
+            prop_type = il2cpp_method_get_param(set, 0);
         }
-        if (prop_class) {
-            outPut << il2cpp_class_get_name(prop_class) << " " << prop_name << " { ";
+        if (prop_type) {
+            outPut.append(names.type_name(prop_type)).append(' ').append(prop_name)
+                    .append(" { ");
             if (get) {
-                outPut << "get; ";
+                outPut.append("get; ");
             }
             if (set) {
-                outPut << "set; ";
+                outPut.append("set; ");
             }
-            outPut << "}\n";
+            outPut.append("}\n");
         } else {
             if (prop_name) {
-                outPut << " // unknown property " << prop_name;
+                outPut.append(" // unknown property ").append(prop_name);
             }
         }
     }
-    return outPut.str();
 }
 
-std::string dump_field(Il2CppClass *klass) {
-    std::stringstream outPut;
-    outPut << "\n\t// Fields\n";
+void dump_field(Il2CppClass *klass, DumpBuffer &outPut, TypeNameCache &names) {
+    outPut.append("\n\t// Fields\n");
     auto is_enum = il2cpp_class_is_enum(klass);
     void *iter = nullptr;
     while (auto field = il2cpp_class_get_fields(klass, &iter)) {
+        ++dump_counters.fields;
         //TODO attribute
-        outPut << "\t";
+        outPut.append('\t');
         auto attrs = il2cpp_field_get_flags(field);
-        auto access = attrs & FIELD_ATTRIBUTE_FIELD_ACCESS_MASK;
-        switch (access) {
-            case FIELD_ATTRIBUTE_PRIVATE:
-                outPut << "private ";
-                break;
-            case FIELD_ATTRIBUTE_PUBLIC:
-                outPut << "public ";
-                break;
-            case FIELD_ATTRIBUTE_FAMILY:
-                outPut << "protected ";
-                break;
-            case FIELD_ATTRIBUTE_ASSEMBLY:
-            case FIELD_ATTRIBUTE_FAM_AND_ASSEM:
-                outPut << "internal ";
-                break;
-            case FIELD_ATTRIBUTE_FAM_OR_ASSEM:
-                outPut << "protected internal ";
-                break;
-        }
-        if (attrs & FIELD_ATTRIBUTE_LITERAL) {
-            outPut << "const ";
-        } else {
-            if (attrs & FIELD_ATTRIBUTE_STATIC) {
-                outPut << "static ";
-            }
-            if (attrs & FIELD_ATTRIBUTE_INIT_ONLY) {
-                outPut << "readonly ";
-            }
-        }
+        outPut.append(get_field_modifier(attrs));
         auto field_type = il2cpp_field_get_type(field);
-        auto field_class = il2cpp_class_from_type(field_type);
-        outPut << il2cpp_class_get_name(field_class) << " " << il2cpp_field_get_name(field);
+        outPut.append(names.type_name(field_type)).append(' ')
+                .append(il2cpp_field_get_name(field));
         //TODO 获取构造函数初始化后的字段值
         if (attrs & FIELD_ATTRIBUTE_LITERAL && is_enum) {
             uint64_t val = 0;
             il2cpp_field_static_get_value(field, &val);
-            outPut << " = " << std::dec << val;
+            outPut.append(" = ").append_dec(val);
         }
-        outPut << "; // 0x" << std::hex << il2cpp_field_get_offset(field) << "\n";
+        outPut.append("; // 0x").append_hex(il2cpp_field_get_offset(field)).append('\n');
     }
-    return outPut.str();
 }
 
-std::string dump_type(const Il2CppType *type) {
-    std::stringstream outPut;
+void dump_type(const Il2CppType *type, DumpBuffer &outPut, TypeNameCache &names) {
     auto *klass = il2cpp_class_from_type(type);
-    outPut << "\n// Namespace: " << il2cpp_class_get_namespace(klass) << "\n";
+    ++dump_counters.classes;
+    outPut.append("\n// Namespace: ").append(il2cpp_class_get_namespace(klass)).append('\n');
     auto flags = il2cpp_class_get_flags(klass);
     if (flags & TYPE_ATTRIBUTE_SERIALIZABLE) {
-        outPut << "[Serializable]\n";
+        outPut.append("[Serializable]\n");
     }
     //TODO attribute
     auto is_valuetype = il2cpp_class_is_valuetype(klass);
     auto is_enum = il2cpp_class_is_enum(klass);
-    auto visibility = flags & TYPE_ATTRIBUTE_VISIBILITY_MASK;
-    switch (visibility) {
-        case TYPE_ATTRIBUTE_PUBLIC:
-        case TYPE_ATTRIBUTE_NESTED_PUBLIC:
-            outPut << "public ";
-            break;
-        case TYPE_ATTRIBUTE_NOT_PUBLIC:
-        case TYPE_ATTRIBUTE_NESTED_FAM_AND_ASSEM:
-        case TYPE_ATTRIBUTE_NESTED_ASSEMBLY:
-            outPut << "internal ";
-            break;
-        case TYPE_ATTRIBUTE_NESTED_PRIVATE:
-            outPut << "private ";
-            break;
-        case TYPE_ATTRIBUTE_NESTED_FAMILY:
-            outPut << "protected ";
-            break;
-        case TYPE_ATTRIBUTE_NESTED_FAM_OR_ASSEM:
-            outPut << "protected internal ";
-            break;
-    }
-    if (flags & TYPE_ATTRIBUTE_ABSTRACT && flags & TYPE_ATTRIBUTE_SEALED) {
-        outPut << "static ";
-    } else if (!(flags & TYPE_ATTRIBUTE_INTERFACE) && flags & TYPE_ATTRIBUTE_ABSTRACT) {
-        outPut << "abstract ";
-    } else if (!is_valuetype && !is_enum && flags & TYPE_ATTRIBUTE_SEALED) {
-        outPut << "sealed ";
-    }
-    if (flags & TYPE_ATTRIBUTE_INTERFACE) {
-        outPut << "interface ";
-    } else if (is_enum) {
-        outPut << "enum ";
-    } else if (is_valuetype) {
-        outPut << "struct ";
-    } else {
-        outPut << "class ";
-    }
-    outPut << il2cpp_class_get_name(klass); //TODO genericContainerIndex
-    std::vector<std::string> extends;
+    outPut.append(get_type_modifier(flags, is_valuetype, is_enum));
+    outPut.append(names.declaration_name(klass));
+    std::vector<std::string_view> extends;
     auto parent = il2cpp_class_get_parent(klass);
     if (!is_valuetype && !is_enum && parent) {
         auto parent_type = il2cpp_class_get_type(parent);
         if (parent_type->type != IL2CPP_TYPE_OBJECT) {
-            extends.emplace_back(il2cpp_class_get_name(parent));
+            extends.emplace_back(names.type_name(parent_type));
         }
     }
     void *iter = nullptr;
     while (auto itf = il2cpp_class_get_interfaces(klass, &iter)) {
-        extends.emplace_back(il2cpp_class_get_name(itf));
+        extends.emplace_back(names.type_name(il2cpp_class_get_type(itf)));
     }
     if (!extends.empty()) {
-        outPut << " : " << extends[0];
+        outPut.append(" : ").append(extends[0]);
         for (int i = 1; i < extends.size(); ++i) {
-            outPut << ", " << extends[i];
+            outPut.append(", ").append(extends[i]);
         }
     }
-    outPut << "\n{";
-    outPut << dump_field(klass);
-    outPut << dump_property(klass);
-    outPut << dump_method(klass);
+    outPut.append("\n{");
+    dump_field(klass, outPut, names);
+    dump_property(klass, outPut, names);
+    dump_method(klass, outPut, names);
     //TODO EventInfo
-    outPut << "}\n";
-    return outPut.str();
+    outPut.append("}\n");
 }
 
 void il2cpp_api_init(void *handle) {
     LOGI("il2cpp_handle: %p", handle);
-    init_il2cpp_api(handle);
-    if (il2cpp_domain_get_assemblies) {
-        Dl_info dlInfo;
-        if (dladdr((void *) il2cpp_domain_get_assemblies, &dlInfo)) {
-            il2cpp_base = reinterpret_cast<uint64_t>(dlInfo.dli_fbase);
-        }
-        LOGI("il2cpp_base: %" PRIx64"", il2cpp_base);
-    } else {
+    il2cpp_handle = handle;
+    {
+        PhaseTimer timer(DumpPhase::Symbols);
+        init_il2cpp_api(handle);
+    }
+    //基址不依赖导出, api被裁剪时metadata导出仍然需要它
+    xdl_info_t info{};
+    if (xdl_info(handle, XDL_DI_DLINFO, &info) == 0) {
+        il2cpp_base = reinterpret_cast<uint64_t>(info.dli_fbase);
+    }
+    LOGI("il2cpp_base: %" PRIx64"", il2cpp_base);
+    if (!il2cpp_domain_get_assemblies) {
         LOGE("Failed to initialize il2cpp api.");
         return;
     }
-    while (!il2cpp_is_vm_thread(nullptr)) {
-        LOGI("Waiting for il2cpp_init...");
-        sleep(1);
+    {
+        PhaseTimer timer(DumpPhase::VmWait);
+        //优先在il2cpp_init返回时唤醒, 无法hook时退回轮询
+        auto hooked = !il2cpp_is_vm_thread(nullptr) &&
+                      il2cpp_init_hook_install((void *) il2cpp_init);
+        while (!il2cpp_is_vm_thread(nullptr)) {
+            LOGI("Waiting for il2cpp_init...");
+            if (hooked) {
+                //返回后只需再检查一次, 之后的等待都靠轮询
+                hooked = !il2cpp_init_hook_wait(1000);
+            } else {
+                sleep(1);
+            }
+        }
     }
     auto domain = il2cpp_domain_get();
     il2cpp_thread_attach(domain);
+    il2cpp_api_ready = true;
 }
 
-void il2cpp_dump(const char *outDir) {
+// Without the api nothing tells when il2cpp_init has mapped global-metadata.dat, so
+// open() is retried until it succeeds
+static bool wait_for_metadata(Il2CppMetadata &metadata) {
+    PhaseTimer timer(DumpPhase::VmWait);
+    for (unsigned int i = 0;; ++i) {
+        if (metadata.open(il2cpp_handle)) {
+            return true;
+        }
+        if (i == kMetadataWaitSeconds) {
+            return false;
+        }
+        LOGI("Waiting for global-metadata.dat...");
+        sleep(1);
+    }
+}
+
+// il2cpp api side of dump_chunks, chunks index the classes of an image
+class ApiDumpWorker {
+public:
+    ApiDumpWorker(const std::vector<const Il2CppImage *> &images, bool spawned)
+            : images_(images) {
+        //工作线程必须附加到il2cpp才能调用api
+        if (spawned) {
+            thread_ = il2cpp_thread_attach(il2cpp_domain_get());
+        }
+    }
+
+    ~ApiDumpWorker() {
+        if (thread_) {
+            il2cpp_thread_detach(thread_);
+        }
+    }
+
+    ApiDumpWorker(const ApiDumpWorker &) = delete;
+
+    ApiDumpWorker &operator=(const ApiDumpWorker &) = delete;
+
+    const Il2CppType *resolve(const DumpChunk &chunk, size_t index) {
+        auto klass = il2cpp_image_get_class(images_[chunk.image], index);
+        return il2cpp_class_get_type(const_cast<Il2CppClass *>(klass));
+    }
+
+    void format(const Il2CppType *type, const DumpChunk &, DumpBuffer &outPut) {
+        dump_type(type, outPut, names_);
+    }
+
+    size_t hits() const { return names_.hits(); }
+
+    size_t misses() const { return names_.misses(); }
+
+private:
+    const std::vector<const Il2CppImage *> &images_;
+    Il2CppThread *thread_ = nullptr;
+    TypeNameCache names_;
+};
+
+void il2cpp_dump(const char *outDir, const DumpOptions &options) {
     LOGI("dumping...");
-    size_t size;
-    auto domain = il2cpp_domain_get();
-    auto assemblies = il2cpp_domain_get_assemblies(domain, &size);
-    std::stringstream imageOutput;
-    for (int i = 0; i < size; ++i) {
+    auto dumpStart = metrics_now_ns();
+    auto threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (!il2cpp_api_ready && !options.metadata) {
+        LOGE("il2cpp api not available, metadata=1 dumps from global-metadata.dat instead");
+        return;
+    }
+    //直接读取global-metadata.dat, 不可用时退回il2cpp api
+    Il2CppMetadata metadata;
+    auto useMetadata = false;
+    uint64_t metadataNs = 0;
+    if (options.metadata && !il2cpp_api_ready) {
+        useMetadata = wait_for_metadata(metadata);
+        if (!useMetadata) {
+            LOGE("global-metadata.dat not usable and the il2cpp api is not available");
+            return;
+        }
+    } else if (options.metadata) {
+        auto openStart = metrics_now_ns();
+        useMetadata = metadata.open(il2cpp_handle);
+        metadataNs = metrics_now_ns() - openStart;
+        if (!useMetadata) {
+            LOGW("global-metadata.dat not usable, dumping through the il2cpp api");
+        }
+    }
+    size_t size = 0;
+    const Il2CppAssembly **assemblies = nullptr;
+    if (useMetadata) {
+        size = metadata.image_count();
+    } else {
+        auto domain = il2cpp_domain_get();
+        assemblies = il2cpp_domain_get_assemblies(domain, &size);
+    }
+    metrics_begin_dump(threads, size);
+    metrics_add_time(DumpPhase::Enumerate, metadataNs);
+    auto outPath = std::string(outDir).append("/files/dump.cs");
+    DumpWriter writer;
+    if (!writer.open(outPath.data())) {
+        return;
+    }
+    DumpBuffer outPut;
+    for (int i = 0; !useMetadata && i < size; ++i) {
         auto image = il2cpp_assembly_get_image(assemblies[i]);
-        imageOutput << "// Image " << i << ": " << il2cpp_image_get_name(image) << "\n";
+        outPut.append("// Image ").append_dec((uint64_t) i).append(": ")
+                .append(il2cpp_image_get_name(image)).append('\n');
     }
-    std::vector<std::string> outPuts;
-    if (il2cpp_image_get_class) {
+    //每个类型格式化后立即写出, 内存占用不随类型数量增长
+    size_t maxTypeSize = 0;
+    size_t nameHits = 0;
+    size_t nameMisses = 0;
+    if (useMetadata) {
+        //只遍历metadata中的表, 不调用il2cpp api
+        maxTypeSize = metadata_dump(metadata, il2cpp_base, threads, writer, outPut, nameHits,
+                                    nameMisses);
+    } else if (il2cpp_image_get_class) {
         LOGI("Version greater than 2018.3");
-        //使用il2cpp_image_get_class
-        for (int i = 0; i < size; ++i) {
-            auto image = il2cpp_assembly_get_image(assemblies[i]);
-            std::stringstream imageStr;
-            imageStr << "\n// Dll : " << il2cpp_image_get_name(image);
-            auto classCount = il2cpp_image_get_class_count(image);
-            for (int j = 0; j < classCount; ++j) {
-                auto klass = il2cpp_image_get_class(image, j);
-                auto type = il2cpp_class_get_type(const_cast<Il2CppClass *>(klass));
-                //LOGD("type name : %s", il2cpp_type_get_name(type));
-                auto outPut = imageStr.str() + dump_type(type);
-                outPuts.push_back(outPut);
+        //使用il2cpp_image_get_class, 多线程时按原顺序写出
+        auto enumerateStart = metrics_now_ns();
+        std::vector<const Il2CppImage *> images(size);
+        std::vector<std::string> imageStrs(size);
+        std::vector<DumpChunk> chunks;
+        for (size_t i = 0; i < size; ++i) {
+            images[i] = il2cpp_assembly_get_image(assemblies[i]);
+            imageStrs[i] = std::string("\n// Dll : ").append(il2cpp_image_get_name(images[i]));
+            size_t classCount = il2cpp_image_get_class_count(images[i]);
+            for (size_t j = 0; j < classCount; j += kClassesPerChunk) {
+                chunks.push_back({i, j, std::min(j + kClassesPerChunk, classCount)});
             }
         }
+        metrics_add_time(DumpPhase::Enumerate, metrics_now_ns() - enumerateStart);
+        maxTypeSize = dump_chunks(chunks, imageStrs, threads, writer, outPut, nameHits,
+                                  nameMisses, [&](bool spawned) {
+                    return ApiDumpWorker(images, spawned);
+                });
     } else {
         LOGI("Version less than 2018.3");
         //使用反射
@@ -389,13 +404,15 @@ void il2cpp_dump(const char *outDir) {
             LOGI("miss Assembly::GetTypes");
             return;
         }
+        //串行路径中枚举与格式化交错进行
+        SerialDump serial(writer, outPut);
+        TypeNameCache names;
         typedef void *(*Assembly_Load_ftn)(void *, Il2CppString *, void *);
         typedef Il2CppArray *(*Assembly_GetTypes_ftn)(void *, void *);
         for (int i = 0; i < size; ++i) {
             auto image = il2cpp_assembly_get_image(assemblies[i]);
-            std::stringstream imageStr;
             auto image_name = il2cpp_image_get_name(image);
-            imageStr << "\n// Dll : " << image_name;
+            auto imageStr = std::string("\n// Dll : ").append(image_name);
             //LOGD("image name : %s", image->name);
             auto imageName = std::string(image_name);
             auto pos = imageName.rfind('.');
@@ -411,19 +428,49 @@ void il2cpp_dump(const char *outDir) {
                 auto klass = il2cpp_class_from_system_type((Il2CppReflectionType *) items[j]);
                 auto type = il2cpp_class_get_type(klass);
                 //LOGD("type name : %s", il2cpp_type_get_name(type));
-                auto outPut = imageStr.str() + dump_type(type);
-                outPuts.push_back(outPut);
+                serial.write_type(imageStr, [&](DumpBuffer &out) {
+                    dump_type(type, out, names);
+                });
             }
         }
+        serial.finish();
+        maxTypeSize = serial.max_type_size();
+        nameHits += names.hits();
+        nameMisses += names.misses();
     }
-    LOGI("write dump file");
-    auto outPath = std::string(outDir).append("/files/dump.cs");
-    std::ofstream outStream(outPath);
-    outStream << imageOutput.str();
-    auto count = outPuts.size();
-    for (int i = 0; i < count; ++i) {
-        outStream << outPuts[i];
+    {
+        PhaseTimer timer(DumpPhase::Write);
+        writer.write(outPut);
+        writer.close();
+    }
+    metrics_flush_counters();
+    metrics_end_dump(writer.bytes_written());
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    LOGI("dump memory: largest type %zu bytes, buffer peak %zu bytes, process peak rss %ld kB",
+         maxTypeSize, DumpBuffer::pool_peak(), usage.ru_maxrss);
+    DumpBuffer::pool_trim();
+    LOGI("type name cache: %zu hits, %zu misses", nameHits, nameMisses);
+    if (writer.failed()) {
+        LOGE("dump failed, %zu bytes written to %s", writer.bytes_written(), outPath.data());
+        return;
+    }
+    LOGI("dump done! %zu bytes", writer.bytes_written());
+    if (options.snapshot && !useMetadata && !il2cpp_api_ready) {
+        LOGW("snapshot needs the il2cpp api or metadata=1, skipped");
+    } else if (options.snapshot) {
+        PhaseTimer timer(DumpPhase::Snapshot);
+        auto snapshotPath = std::string(outDir).append("/files/dump.bin");
+        //快照与dump.cs来自同一后端
+        auto written = useMetadata
+                       ? metadata_dump_snapshot(metadata, il2cpp_base, snapshotPath.data())
+                       : il2cpp_dump_snapshot(snapshotPath.data(), il2cpp_base);
+        if (written) {
+            LOGI("snapshot done!");
+        }
     }
-    outStream.close();
-    LOGI("dump done!");
+    metrics_add_time(DumpPhase::Total, metrics_now_ns() - dumpStart);
+    metrics_log();
+    auto metricsPath = std::string(outDir).append("/files/dump_metrics.json");
+    metrics_write(metricsPath.data());
 }
\ No newline at end of file
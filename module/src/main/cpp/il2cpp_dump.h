@@ -7,6 +7,18 @@
 
 void il2cpp_api_init(void *handle);
 
-void il2cpp_dump(const char *outDir);
+struct DumpOptions {
+    // number of formatting threads, 0 uses every core, 1 dumps serially
+    unsigned int threads = 1;
+    // also write the binary snapshot files/dump.bin
+    bool snapshot = false;
+    // walk global-metadata.dat instead of calling the il2cpp api, falls back to the api
+    // when the metadata or the registrations cannot be found. Also the only way to dump
+    // a libil2cpp.so with stripped exports, the dump then waits for the metadata to be
+    // mapped instead of for il2cpp_init.
+    bool metadata = false;
+};
+
+void il2cpp_dump(const char *outDir, const DumpOptions &options);
 
 #endif //ZYGISK_IL2CPPDUMPER_IL2CPP_DUMP_H
@@ -0,0 +1,104 @@
+//
+// Wakes the dump thread as soon as il2cpp_init returns.
+//
+
+#include "il2cpp_init_hook.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <link.h>
+#include "log.h"
+
+namespace {
+
+using il2cpp_init_t = int (*)(const char *);
+
+il2cpp_init_t orig_init;
+std::mutex init_mutex;
+std::condition_variable init_cv;
+bool init_done = false;
+
+int il2cpp_init_wrapper(const char *domain_name) {
+    auto result = orig_init(domain_name);
+    {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        init_done = true;
+    }
+    init_cv.notify_all();
+    return result;
+}
+
+struct PatchState {
+    uintptr_t target;
+    uintptr_t replacement;
+    size_t patched;
+};
+
+bool is_libunity(const char *name) {
+    auto slash = name ? strrchr(name, '/') : nullptr;
+    return strcmp(slash ? slash + 1 : (name ? name : ""), "libunity.so") == 0;
+}
+
+// only writable PT_LOAD segments outside of PT_GNU_RELRO are patched, the pointers
+// filled in by dlsym live in .data/.bss, everything else is read only after relocation
+int patch_libunity(dl_phdr_info *info, size_t, void *data) {
+    if (!is_libunity(info->dlpi_name)) {
+        return 0;
+    }
+    auto state = static_cast<PatchState *>(data);
+    uintptr_t relroStart = 0;
+    uintptr_t relroEnd = 0;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        auto &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_GNU_RELRO) {
+            relroStart = info->dlpi_addr + phdr.p_vaddr;
+            relroEnd = relroStart + phdr.p_memsz;
+        }
+    }
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        auto &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD || !(phdr.p_flags & PF_W)) {
+            continue;
+        }
+        auto start = (info->dlpi_addr + phdr.p_vaddr + sizeof(uintptr_t) - 1) &
+                     ~(sizeof(uintptr_t) - 1);
+        auto end = info->dlpi_addr + phdr.p_vaddr + phdr.p_memsz;
+        for (auto addr = start; addr + sizeof(uintptr_t) <= end; addr += sizeof(uintptr_t)) {
+            if (addr >= relroStart && addr < relroEnd) {
+                addr = relroEnd - sizeof(uintptr_t);
+                continue;
+            }
+            auto slot = reinterpret_cast<uintptr_t *>(addr);
+            if (__atomic_load_n(slot, __ATOMIC_RELAXED) == state->target) {
+                __atomic_store_n(slot, state->replacement, __ATOMIC_RELEASE);
+                ++state->patched;
+            }
+        }
+    }
+    return 1;
+}
+
+}
+
+bool il2cpp_init_hook_install(void *init) {
+    if (!init) {
+        return false;
+    }
+    orig_init = reinterpret_cast<il2cpp_init_t>(init);
+    PatchState state{reinterpret_cast<uintptr_t>(init),
+                     reinterpret_cast<uintptr_t>(&il2cpp_init_wrapper), 0};
+    dl_iterate_phdr(patch_libunity, &state);
+    if (state.patched == 0) {
+        LOGI("il2cpp_init pointer not found in libunity.so");
+        return false;
+    }
+    LOGI("il2cpp_init hooked, %zu pointers patched", state.patched);
+    return true;
+}
+
+bool il2cpp_init_hook_wait(unsigned int timeout_ms) {
+    std::unique_lock<std::mutex> lock(init_mutex);
+    return init_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [] { return init_done; });
+}
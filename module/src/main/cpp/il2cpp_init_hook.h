@@ -0,0 +1,17 @@
+//
+// Wakes the dump thread as soon as il2cpp_init returns instead of polling for it.
+// libunity.so looks up the il2cpp api with dlsym and keeps the pointers in its data
+// segment, so the pointer to il2cpp_init is swapped for a wrapper that signals on return.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_IL2CPP_INIT_HOOK_H
+#define ZYGISK_IL2CPPDUMPER_IL2CPP_INIT_HOOK_H
+
+// Returns false if libunity.so is not loaded or holds no pointer to init,
+// e.g. because it already called it. The caller has to poll in that case.
+bool il2cpp_init_hook_install(void *init);
+
+// Returns true once the wrapped il2cpp_init returned, false after timeout_ms.
+bool il2cpp_init_hook_wait(unsigned int timeout_ms);
+
+#endif //ZYGISK_IL2CPPDUMPER_IL2CPP_INIT_HOOK_H
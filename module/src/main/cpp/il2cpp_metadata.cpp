@@ -0,0 +1,707 @@
+//
+// global-metadata.dat and the registrations in libil2cpp.so, read straight from memory.
+//
+
+#include "il2cpp_metadata.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include "xdl.h"
+#include "log.h"
+
+namespace {
+
+// Il2CppGlobalMetadataHeader fields as {offset, size} pairs. 24.0 and 24.1 have a
+// rgctxEntries pair before images, from 24.2 on the fields used here never moved.
+constexpr uint32_t kHeaderStrings = 24;
+constexpr uint32_t kHeaderProperties = 40;
+constexpr uint32_t kHeaderMethods = 48;
+constexpr uint32_t kHeaderFieldDefaultValues = 64;
+constexpr uint32_t kHeaderDefaultValueData = 72;
+constexpr uint32_t kHeaderParameters = 88;
+constexpr uint32_t kHeaderFields = 96;
+constexpr uint32_t kHeaderGenericParameters = 104;
+constexpr uint32_t kHeaderGenericContainers = 120;
+constexpr uint32_t kHeaderInterfaces = 136;
+constexpr uint32_t kHeaderTypeDefinitions = 160;
+constexpr uint32_t kHeaderImages = 168;
+// sizeof(Il2CppGlobalMetadataHeader) of 24.2 to 24.5, the first section follows it
+constexpr uint32_t kHeaderSizeV24_2 = 264;
+
+// Il2CppMetadataRegistration as pointer sized slots, the counts are padded
+constexpr size_t kRegistrationTypesCount = 6;
+constexpr size_t kRegistrationTypes = 7;
+constexpr size_t kRegistrationFieldOffsetsCount = 10;
+constexpr size_t kRegistrationFieldOffsets = 11;
+constexpr size_t kRegistrationTypeDefinitionsSizesCount = 12;
+
+// more would only show up in memory that is not a registration
+constexpr uintptr_t kMaxTypes = 1 << 24;
+constexpr uint32_t kMaxGenericArguments = 256;
+constexpr size_t kMaxModuleName = 1024;
+
+template<typename T>
+T load(const uint8_t *record, uint32_t offset) {
+    T value;
+    memcpy(&value, record + offset, sizeof(value));
+    return value;
+}
+
+// ReadCompressedUInt32 of the 29+ default value blob, 0 if it runs past the end
+size_t read_compressed(const uint8_t *data, size_t size, uint32_t *value) {
+    if (size < 1) {
+        return 0;
+    }
+    uint32_t first = data[0];
+    if ((first & 0x80) == 0) {
+        *value = first;
+        return 1;
+    }
+    if ((first & 0xc0) == 0x80) {
+        if (size < 2) {
+            return 0;
+        }
+        *value = (first & ~0x80u) << 8 | data[1];
+        return 2;
+    }
+    if ((first & 0xe0) == 0xc0) {
+        if (size < 4) {
+            return 0;
+        }
+        *value = (first & ~0xc0u) << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 |
+                 data[3];
+        return 4;
+    }
+    if (first == 0xf0) {
+        if (size < 5) {
+            return 0;
+        }
+        memcpy(value, data + 1, sizeof(*value));
+        return 5;
+    }
+    if (first == 0xfe || first == 0xff) {
+        *value = first == 0xfe ? UINT32_MAX - 1 : UINT32_MAX;
+        return 1;
+    }
+    return 0;
+}
+
+bool read_file(const char *path, std::string &out) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    char buf[16 * 1024];
+    while (true) {
+        auto n = read(fd, buf, sizeof(buf));
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            return n == 0;
+        }
+        out.append(buf, n);
+    }
+}
+
+}
+
+bool Il2CppMetadata::readable(const void *ptr, size_t size) const {
+    auto start = (uintptr_t) ptr;
+    if (start + size < start) {
+        return false;
+    }
+    auto it = std::upper_bound(readable_.begin(), readable_.end(), start,
+                               [](uintptr_t addr, const std::pair<uintptr_t, uintptr_t> &range) {
+                                   return addr < range.first;
+                               });
+    return it != readable_.begin() && start + size <= std::prev(it)->second;
+}
+
+ptrdiff_t Il2CppMetadata::readable_string(const char *str, size_t max) const {
+    auto start = (uintptr_t) str;
+    auto it = std::upper_bound(readable_.begin(), readable_.end(), start,
+                               [](uintptr_t addr, const std::pair<uintptr_t, uintptr_t> &range) {
+                                   return addr < range.first;
+                               });
+    if (it == readable_.begin() || start >= std::prev(it)->second) {
+        return -1;
+    }
+    auto end = memchr(str, 0, std::min(max, (size_t) (std::prev(it)->second - start)));
+    return end ? (const char *) end - str : -1;
+}
+
+bool Il2CppMetadata::load_maps(std::vector<const uint8_t *> &candidates) {
+    std::string maps;
+    if (!read_file("/proc/self/maps", maps)) {
+        LOGW("metadata: read /proc/self/maps failed: %s", strerror(errno));
+        return false;
+    }
+    std::vector<const uint8_t *> anonymous;
+    size_t pos = 0;
+    while (pos < maps.size()) {
+        auto newline = maps.find('\n', pos);
+        if (newline == std::string::npos) {
+            newline = maps.size();
+        }
+        maps[newline] = '\0';
+        auto line = maps.data() + pos;
+        pos = newline + 1;
+        uintptr_t start, end;
+        char perms[5];
+        uint64_t offset;
+        int path = 0;
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " %4s %" SCNx64 " %*s %*s %n", &start, &end,
+                   perms, &offset, &path) < 4 || perms[0] != 'r' || path == 0) {
+            continue;
+        }
+        if (!readable_.empty() && readable_.back().second == start) {
+            readable_.back().second = end;
+        } else {
+            readable_.emplace_back(start, end);
+        }
+        std::string_view name = line + path;
+        if (offset != 0) {
+            continue;
+        }
+        if (name.find("global-metadata.dat") != std::string_view::npos) {
+            candidates.push_back((const uint8_t *) start);
+        } else if (name.empty() || name.starts_with("[anon:")) {
+            // never backed by a file, so reading the start of it cannot fault
+            anonymous.push_back((const uint8_t *) start);
+        }
+    }
+    candidates.insert(candidates.end(), anonymous.begin(), anonymous.end());
+    return !readable_.empty();
+}
+
+bool Il2CppMetadata::section(const uint8_t *header, uint32_t field, uint32_t record,
+                             Section &out) const {
+    auto offset = load<uint32_t>(header, field);
+    auto size = load<uint32_t>(header, field + 4);
+    if (size % record != 0 || !readable(header + offset, size)) {
+        return false;
+    }
+    out = {header + offset, size, record};
+    return true;
+}
+
+bool Il2CppMetadata::parse_header(const uint8_t *header) {
+    version_ = load<uint32_t>(header, 4);
+    if (version_ == 24) {
+        // 24.0 and 24.1 report 24 too, but have a larger header and other records
+        if (load<uint32_t>(header, 8) != kHeaderSizeV24_2) {
+            return false;
+        }
+    } else if (version_ != 27 && version_ != 29 && version_ != 31) {
+        return false;
+    }
+    uint32_t typeRecord;
+    if (version_ >= 27) {
+        // byrefTypeIndex is gone
+        type_layout_ = {12, 16, 24, 28, 32, 36, 44, 52, 64, 80};
+        typeRecord = 88;
+    } else {
+        type_layout_ = {16, 20, 28, 32, 36, 40, 48, 56, 68, 84};
+        typeRecord = 92;
+    }
+    uint32_t methodRecord;
+    if (version_ >= 31) {
+        // returnParameterToken follows returnType
+        method_layout_ = {16, 24};
+        methodRecord = 36;
+    } else {
+        method_layout_ = {12, 20};
+        methodRecord = 32;
+    }
+    if (!section(header, kHeaderStrings, 1, strings_) ||
+        !section(header, kHeaderProperties, 20, properties_) ||
+        !section(header, kHeaderMethods, methodRecord, methods_) ||
+        !section(header, kHeaderFieldDefaultValues, 12, field_default_values_) ||
+        !section(header, kHeaderDefaultValueData, 1, default_value_data_) ||
+        !section(header, kHeaderParameters, 12, parameters_) ||
+        !section(header, kHeaderFields, 12, fields_) ||
+        !section(header, kHeaderGenericParameters, 16, generic_parameters_) ||
+        !section(header, kHeaderGenericContainers, 16, generic_containers_) ||
+        !section(header, kHeaderInterfaces, 4, interfaces_) ||
+        !section(header, kHeaderTypeDefinitions, typeRecord, type_definitions_) ||
+        !section(header, kHeaderImages, 40, images_)) {
+        return false;
+    }
+    // every string() is NUL-terminated once the pool is
+    if (strings_.size == 0 || strings_.data[strings_.size - 1] != 0) {
+        return false;
+    }
+    // a wrong record layout shows up as images that do not cover the type definitions
+    size_t types = 0;
+    MetadataImage image{};
+    for (size_t i = 0; i < image_count(); ++i) {
+        if (!this->image(i, image) || image.type_start != (int32_t) types) {
+            return false;
+        }
+        types += image.type_count;
+    }
+    return types == type_definitions_.count() && types > 0;
+}
+
+bool Il2CppMetadata::check_metadata_registration(const uintptr_t *slots) {
+    auto typeCount = slots[kRegistrationTypesCount];
+    auto types = (const Il2CppType *const *) slots[kRegistrationTypes];
+    auto fieldOffsets = (const int32_t *const *) slots[kRegistrationFieldOffsets];
+    // the count is checked before it is scaled, a wrapped size would pass readable()
+    if (typeCount == 0 || typeCount > kMaxTypes || typeCount > SIZE_MAX / sizeof(*types) ||
+        !readable(types, typeCount * sizeof(*types)) ||
+        !readable(fieldOffsets, type_definitions_.count() * sizeof(*fieldOffsets))) {
+        return false;
+    }
+    // checked once here, type() is called for every field, parameter and return type
+    for (size_t i = 0; i < typeCount; ++i) {
+        if (!readable(types[i], sizeof(Il2CppType))) {
+            return false;
+        }
+    }
+    types_ = types;
+    types_count_ = typeCount;
+    field_offsets_ = fieldOffsets;
+    return true;
+}
+
+bool Il2CppMetadata::check_code_gen_modules(uintptr_t count, uintptr_t array) {
+    auto entries = (const uintptr_t *const *) array;
+    if (!readable(entries, count * sizeof(*entries))) {
+        return false;
+    }
+    std::unordered_map<std::string_view, size_t> imageIndices;
+    MetadataImage image{};
+    for (size_t i = 0; i < image_count(); ++i) {
+        this->image(i, image);
+        imageIndices.emplace(string(image.name), i);
+    }
+    // Il2CppCodeGenModule starts with moduleName, methodPointerCount and methodPointers
+    std::vector<CodeGenModule> modules(image_count());
+    for (size_t i = 0; i < count; ++i) {
+        auto module = entries[i];
+        if (!readable(module, 3 * sizeof(*module))) {
+            return false;
+        }
+        auto name = (const char *) module[0];
+        auto length = readable_string(name, kMaxModuleName);
+        if (length < 0) {
+            return false;
+        }
+        auto it = imageIndices.find(std::string_view(name, length));
+        auto pointers = (void *const *) module[2];
+        // no module has more methods than the metadata, checked before it is scaled
+        if (it == imageIndices.end() || module[1] > methods_.count() ||
+            !readable(pointers, module[1] * sizeof(*pointers))) {
+            return false;
+        }
+        modules[it->second] = {pointers, (uint32_t) module[1]};
+    }
+    modules_ = std::move(modules);
+    return true;
+}
+
+// reads whole data segments, redzones between globals included
+__attribute__((no_sanitize("address")))
+bool Il2CppMetadata::find_registrations(void *handle) {
+    xdl_info_t info{};
+    if (xdl_info(handle, XDL_DI_DLINFO, &info) != 0 || !info.dlpi_phdr) {
+        return false;
+    }
+    auto bias = (uintptr_t) info.dli_fbase;
+    auto typeCount = type_definitions_.count();
+    auto imageCount = image_count();
+    bool haveTypes = false;
+    bool haveModules = false;
+    // Both live in .data.rel.ro or .data. The metadata registration is found by
+    // fieldOffsetsCount and typeDefinitionsSizesCount both being the type definition
+    // count, the code gen modules by a count equal to the image count followed by an
+    // array of modules named after the images, as the last fields of the code registration.
+    for (size_t i = 0; i < info.dlpi_phnum && !(haveTypes && haveModules); ++i) {
+        auto &phdr = info.dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD || !(phdr.p_flags & PF_W) || !(phdr.p_flags & PF_R)) {
+            continue;
+        }
+        auto start = (bias + phdr.p_vaddr + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+        auto end = bias + phdr.p_vaddr + phdr.p_memsz;
+        if (end <= start || !readable((const void *) start, end - start)) {
+            continue;
+        }
+        auto slots = (const uintptr_t *) start;
+        auto slotCount = (end - start) / sizeof(uintptr_t);
+        for (size_t j = 0; j + 1 < slotCount && !(haveTypes && haveModules); ++j) {
+            if (!haveTypes && slots[j] == typeCount && j >= kRegistrationFieldOffsetsCount &&
+                j + 2 < slotCount && slots[j + 2] == typeCount) {
+                auto registration = slots + j - kRegistrationFieldOffsetsCount;
+                static_assert(kRegistrationTypeDefinitionsSizesCount ==
+                              kRegistrationFieldOffsetsCount + 2);
+                haveTypes = check_metadata_registration(registration);
+            }
+            if (!haveModules && slots[j] == imageCount) {
+                haveModules = check_code_gen_modules(slots[j], slots[j + 1]);
+            }
+        }
+    }
+    if (!haveTypes) {
+        LOGW("metadata: metadata registration not found");
+    }
+    if (!haveModules) {
+        LOGW("metadata: code gen modules not found");
+    }
+    return haveTypes && haveModules;
+}
+
+bool Il2CppMetadata::open(void *handle) {
+    std::vector<const uint8_t *> candidates;
+    if (!handle || !load_maps(candidates)) {
+        return false;
+    }
+    const uint8_t *header = nullptr;
+    for (auto candidate: candidates) {
+        if (readable(candidate, kHeaderSizeV24_2) &&
+            load<uint32_t>(candidate, 0) == METADATA_SANITY) {
+            if (parse_header(candidate)) {
+                header = candidate;
+                break;
+            }
+            LOGW("metadata: unsupported global-metadata.dat version %u at %p", version_,
+                 candidate);
+        }
+    }
+    if (!header) {
+        LOGW("metadata: no global-metadata.dat found in memory");
+        return false;
+    }
+    if (!find_registrations(handle)) {
+        return false;
+    }
+    // il2cpp looks default values up by a linear search, the dump needs one per constant
+    for (size_t i = 0; i < field_default_values_.count(); ++i) {
+        default_values_.emplace_back(load<int32_t>(field_default_values_.at(i), 0), i);
+    }
+    std::sort(default_values_.begin(), default_values_.end());
+    LOGI("metadata: version %u at %p, %zu images, %zu type definitions, %zu types", version_,
+         header, image_count(), type_definition_count(), types_count_);
+    return true;
+}
+
+bool Il2CppMetadata::image(size_t index, MetadataImage &out) const {
+    auto record = images_.at(index);
+    if (!record) {
+        return false;
+    }
+    out = {load<uint32_t>(record, 0), load<int32_t>(record, 8), load<uint32_t>(record, 12)};
+    return true;
+}
+
+bool Il2CppMetadata::type_definition(int32_t index, MetadataTypeDefinition &out) const {
+    auto record = type_definitions_.at(index);
+    if (!record) {
+        return false;
+    }
+    auto &layout = type_layout_;
+    auto bitfield = load<uint32_t>(record, layout.bitfield);
+    out.name = load<uint32_t>(record, 0);
+    out.namespaze = load<uint32_t>(record, 4);
+    out.byval_type = load<int32_t>(record, 8);
+    out.declaring_type = load<int32_t>(record, layout.declaring_type);
+    out.parent = load<int32_t>(record, layout.parent);
+    out.generic_container = load<int32_t>(record, layout.generic_container);
+    out.flags = load<uint32_t>(record, layout.flags);
+    out.field_start = load<int32_t>(record, layout.field_start);
+    out.method_start = load<int32_t>(record, layout.method_start);
+    out.property_start = load<int32_t>(record, layout.property_start);
+    out.interfaces_start = load<int32_t>(record, layout.interfaces_start);
+    // method, property, field, event, nested type, vtable and interface counts
+    out.method_count = load<uint16_t>(record, layout.method_count);
+    out.property_count = load<uint16_t>(record, layout.method_count + 2);
+    out.field_count = load<uint16_t>(record, layout.method_count + 4);
+    out.interfaces_count = load<uint16_t>(record, layout.method_count + 12);
+    out.valuetype = bitfield & 1;
+    out.enumtype = bitfield >> 1 & 1;
+    // the token is the last field in every supported version
+    out.token = load<uint32_t>(record, layout.bitfield + 4);
+    return true;
+}
+
+bool Il2CppMetadata::method(int32_t index, MetadataMethod &out) const {
+    auto record = methods_.at(index);
+    if (!record) {
+        return false;
+    }
+    auto token = method_layout_.token;
+    out.name = load<uint32_t>(record, 0);
+    out.return_type = load<int32_t>(record, 8);
+    out.parameter_start = load<int32_t>(record, method_layout_.parameter_start);
+    out.token = load<uint32_t>(record, token);
+    // flags, iflags, slot and parameterCount follow the token
+    out.flags = load<uint16_t>(record, token + 4);
+    out.iflags = load<uint16_t>(record, token + 6);
+    out.parameter_count = load<uint16_t>(record, token + 10);
+    return true;
+}
+
+bool Il2CppMetadata::parameter(int32_t index, MetadataParameter &out) const {
+    auto record = parameters_.at(index);
+    if (!record) {
+        return false;
+    }
+    out = {load<uint32_t>(record, 0), load<int32_t>(record, 8)};
+    return true;
+}
+
+bool Il2CppMetadata::field(int32_t index, MetadataField &out) const {
+    auto record = fields_.at(index);
+    if (!record) {
+        return false;
+    }
+    out = {load<uint32_t>(record, 0), load<int32_t>(record, 4)};
+    return true;
+}
+
+bool Il2CppMetadata::property(int32_t index, MetadataProperty &out) const {
+    auto record = properties_.at(index);
+    if (!record) {
+        return false;
+    }
+    out = {load<uint32_t>(record, 0), load<int32_t>(record, 4), load<int32_t>(record, 8),
+           load<uint32_t>(record, 12)};
+    return true;
+}
+
+int32_t Il2CppMetadata::interface_type(int32_t index) const {
+    auto record = interfaces_.at(index);
+    return record ? load<int32_t>(record, 0) : kMetadataNone;
+}
+
+const char *Il2CppMetadata::string(uint32_t index) const {
+    return index < strings_.size ? (const char *) strings_.data + index : "";
+}
+
+const Il2CppType *Il2CppMetadata::type(int32_t index) const {
+    return index >= 0 && (size_t) index < types_count_ ? types_[index] : nullptr;
+}
+
+int32_t Il2CppMetadata::handle_index(uintptr_t handle, const Section &table) {
+    if (handle < table.count()) {
+        return (int32_t) handle;
+    }
+    auto base = (uintptr_t) table.data;
+    if (handle >= base && handle - base < table.size && (handle - base) % table.record == 0) {
+        return (int32_t) ((handle - base) / table.record);
+    }
+    return kMetadataNone;
+}
+
+int32_t Il2CppMetadata::type_definition_of(const Il2CppType *type) const {
+    switch (type->type) {
+        case IL2CPP_TYPE_GENERICINST: {
+            auto generic = type->data.generic_class;
+            if (!readable(generic, sizeof(*generic))) {
+                return kMetadataNone;
+            }
+            if (version_ < 27) {
+                auto index = generic->typeDefinitionIndex;
+                return type_definitions_.at(index) ? index : kMetadataNone;
+            }
+            // some 2020.2 and 2020.3 builds still keep the index there
+            auto definition = generic->type;
+            if ((uintptr_t) definition < type_definitions_.count()) {
+                return (int32_t) (uintptr_t) definition;
+            }
+            if (!readable(definition, sizeof(*definition)) ||
+                definition->type == IL2CPP_TYPE_GENERICINST) {
+                return kMetadataNone;
+            }
+            return type_definition_of(definition);
+        }
+        case IL2CPP_TYPE_VAR:
+        case IL2CPP_TYPE_MVAR:
+        case IL2CPP_TYPE_SZARRAY:
+        case IL2CPP_TYPE_ARRAY:
+        case IL2CPP_TYPE_PTR:
+        case IL2CPP_TYPE_BYREF:
+        case IL2CPP_TYPE_FNPTR:
+            return kMetadataNone;
+        default:
+            return handle_index((uintptr_t) type->data.dummy, type_definitions_);
+    }
+}
+
+const Il2CppType *Il2CppMetadata::element_type(const Il2CppType *type, uint8_t *rank) const {
+    const Il2CppType *element;
+    switch (type->type) {
+        case IL2CPP_TYPE_SZARRAY:
+        case IL2CPP_TYPE_PTR:
+            element = type->data.type;
+            break;
+        case IL2CPP_TYPE_ARRAY: {
+            auto array = type->data.array;
+            if (!readable(array, sizeof(*array))) {
+                return nullptr;
+            }
+            if (rank) {
+                *rank = array->rank;
+            }
+            element = array->etype;
+            break;
+        }
+        default:
+            return nullptr;
+    }
+    return readable(element, sizeof(*element)) ? element : nullptr;
+}
+
+bool Il2CppMetadata::generic_arguments(const Il2CppType *type, uint32_t *argc,
+                                       const Il2CppType *const **argv) const {
+    auto generic = type->data.generic_class;
+    if (type->type != IL2CPP_TYPE_GENERICINST || !readable(generic, sizeof(*generic))) {
+        return false;
+    }
+    auto inst = generic->context.class_inst;
+    if (!inst) {
+        *argc = 0;
+        return true;
+    }
+    if (!readable(inst, sizeof(*inst)) || inst->type_argc > kMaxGenericArguments ||
+        !readable(inst->type_argv, inst->type_argc * sizeof(*inst->type_argv))) {
+        return false;
+    }
+    for (uint32_t i = 0; i < inst->type_argc; ++i) {
+        if (!readable(inst->type_argv[i], sizeof(Il2CppType))) {
+            return false;
+        }
+    }
+    *argc = inst->type_argc;
+    *argv = inst->type_argv;
+    return true;
+}
+
+const char *Il2CppMetadata::generic_parameter_name(const Il2CppType *type) const {
+    auto record = generic_parameters_.at(
+            handle_index((uintptr_t) type->data.dummy, generic_parameters_));
+    return record ? string(load<uint32_t>(record, 4)) : "";
+}
+
+bool Il2CppMetadata::generic_parameter_names(int32_t container,
+                                             std::vector<const char *> &out) const {
+    auto record = generic_containers_.at(container);
+    if (!record) {
+        return false;
+    }
+    auto count = load<int32_t>(record, 4);
+    auto start = load<int32_t>(record, 12);
+    out.clear();
+    for (int32_t i = 0; i < count; ++i) {
+        auto parameter = generic_parameters_.at((int64_t) start + i);
+        if (!parameter) {
+            return false;
+        }
+        out.push_back(string(load<uint32_t>(parameter, 4)));
+    }
+    return true;
+}
+
+bool Il2CppMetadata::is_byref(const Il2CppType *type) {
+    // attrs:16 type:8, then num_mods:6 byref:1 pinned:1 before 2021.1 and
+    // num_mods:5 byref:1 pinned:1 valuetype:1 after
+    uint32_t bits;
+    memcpy(&bits, (const uint8_t *) type + sizeof(type->data), sizeof(bits));
+    return (bits >> 29 & 3) != 0;
+}
+
+uint64_t Il2CppMetadata::field_offset(int32_t type_definition, uint32_t field) const {
+    if (type_definition < 0 || (size_t) type_definition >= type_definition_count()) {
+        return 0;
+    }
+    // generic definitions have no layout
+    auto offsets = field_offsets_[type_definition];
+    if (!offsets || !readable(offsets + field, sizeof(*offsets))) {
+        return 0;
+    }
+    // the api returns the int32_t offset as size_t, thread statics are -1
+    return (uint64_t) (int64_t) offsets[field];
+}
+
+bool Il2CppMetadata::field_default_value(int32_t field, uint64_t *value) const {
+    auto it = std::lower_bound(default_values_.begin(), default_values_.end(),
+                               std::make_pair(field, 0u));
+    if (it == default_values_.end() || it->first != field) {
+        return false;
+    }
+    auto record = field_default_values_.at(it->second);
+    auto type = this->type(load<int32_t>(record, 4));
+    auto dataIndex = load<int32_t>(record, 8);
+    if (!type || dataIndex < 0 || (uint32_t) dataIndex >= default_value_data_.size) {
+        return false;
+    }
+    auto data = default_value_data_.data + dataIndex;
+    size_t available = default_value_data_.size - dataIndex;
+    size_t size;
+    switch (type->type) {
+        case IL2CPP_TYPE_BOOLEAN:
+        case IL2CPP_TYPE_I1:
+        case IL2CPP_TYPE_U1:
+            size = 1;
+            break;
+        case IL2CPP_TYPE_CHAR:
+        case IL2CPP_TYPE_I2:
+        case IL2CPP_TYPE_U2:
+            size = 2;
+            break;
+        case IL2CPP_TYPE_I4:
+        case IL2CPP_TYPE_U4:
+            if (version_ >= 29) {
+                //29起int和uint以变长编码存放
+                uint32_t encoded;
+                if (!read_compressed(data, available, &encoded)) {
+                    return false;
+                }
+                if (type->type == IL2CPP_TYPE_I4) {
+                    auto magnitude = (int32_t) (encoded >> 1);
+                    encoded = encoded == UINT32_MAX ? (uint32_t) INT32_MIN
+                                                    : (uint32_t) (encoded & 1 ? -magnitude - 1
+                                                                              : magnitude);
+                }
+                *value = encoded;
+                return true;
+            }
+            size = 4;
+            break;
+        case IL2CPP_TYPE_R4:
+            size = 4;
+            break;
+        case IL2CPP_TYPE_I8:
+        case IL2CPP_TYPE_U8:
+        case IL2CPP_TYPE_R8:
+            size = 8;
+            break;
+        default:
+            return false;
+    }
+    if (size > available) {
+        return false;
+    }
+    *value = 0;
+    memcpy(value, data, size);
+    return true;
+}
+
+void *Il2CppMetadata::method_pointer(size_t image, uint32_t token) const {
+    if (image >= modules_.size()) {
+        return nullptr;
+    }
+    auto &module = modules_[image];
+    auto rid = token & 0x00ffffff;
+    return rid >= 1 && rid <= module.method_pointer_count ? module.method_pointers[rid - 1]
+                                                          : nullptr;
+}
@@ -0,0 +1,227 @@
+//
+// Read-only view of the global-metadata.dat that libil2cpp mapped, plus the code and
+// metadata registrations libil2cpp.so keeps next to it, so classes can be dumped by
+// walking tables instead of calling the il2cpp api. Every record index and every pointer
+// taken from memory is checked before it is read; metadata this reader does not know
+// makes open() fail and the dump falls back to the api.
+//
+// Supported are metadata versions 24.2 to 24.5 (Unity 2019), 27 (2020.2 and 2021.1),
+// 29 and 31 (2021.2 and later).
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_IL2CPP_METADATA_H
+#define ZYGISK_IL2CPPDUMPER_IL2CPP_METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "il2cpp-class.h"
+
+#define METADATA_SANITY 0xFAB11BAF
+
+// index of a record that does not exist, the metadata uses the same value
+constexpr int32_t kMetadataNone = -1;
+
+struct MetadataImage {
+    uint32_t name;
+    int32_t type_start;
+    uint32_t type_count;
+};
+
+struct MetadataTypeDefinition {
+    uint32_t name;
+    uint32_t namespaze;
+    int32_t byval_type;
+    int32_t declaring_type;
+    int32_t parent;
+    int32_t generic_container;
+    // TYPE_ATTRIBUTE_*
+    uint32_t flags;
+    int32_t field_start;
+    int32_t method_start;
+    int32_t property_start;
+    int32_t interfaces_start;
+    uint16_t method_count;
+    uint16_t property_count;
+    uint16_t field_count;
+    uint16_t interfaces_count;
+    bool valuetype;
+    bool enumtype;
+    uint32_t token;
+};
+
+struct MetadataMethod {
+    uint32_t name;
+    int32_t return_type;
+    int32_t parameter_start;
+    uint32_t token;
+    // METHOD_ATTRIBUTE_* and METHOD_IMPL_ATTRIBUTE_*
+    uint16_t flags;
+    uint16_t iflags;
+    uint16_t parameter_count;
+};
+
+struct MetadataParameter {
+    uint32_t name;
+    int32_t type;
+};
+
+struct MetadataField {
+    uint32_t name;
+    int32_t type;
+};
+
+struct MetadataProperty {
+    uint32_t name;
+    // relative to the method_start of the declaring type
+    int32_t get;
+    int32_t set;
+    // PROPERTY_ATTRIBUTE_*
+    uint32_t attrs;
+};
+
+class Il2CppMetadata {
+public:
+    // handle is libil2cpp.so from xdl_open, whose data segments hold the registrations
+    bool open(void *handle);
+
+    uint32_t version() const { return version_; }
+
+    size_t image_count() const { return images_.count(); }
+
+    size_t type_definition_count() const { return type_definitions_.count(); }
+
+    // the getters return false for an index outside of its table
+
+    bool image(size_t index, MetadataImage &out) const;
+
+    bool type_definition(int32_t index, MetadataTypeDefinition &out) const;
+
+    bool method(int32_t index, MetadataMethod &out) const;
+
+    bool parameter(int32_t index, MetadataParameter &out) const;
+
+    bool field(int32_t index, MetadataField &out) const;
+
+    bool property(int32_t index, MetadataProperty &out) const;
+
+    // type index of the n-th entry in the interfaces table
+    int32_t interface_type(int32_t index) const;
+
+    // "" for an index outside of the string pool
+    const char *string(uint32_t index) const;
+
+    // Il2CppType from the metadata registration, nullptr if it is not readable
+    const Il2CppType *type(int32_t index) const;
+
+    // type definition behind CLASS, VALUETYPE, primitive and GENERICINST types
+    int32_t type_definition_of(const Il2CppType *type) const;
+
+    // element of SZARRAY and PTR types, and etype and rank of ARRAY types
+    const Il2CppType *element_type(const Il2CppType *type, uint8_t *rank = nullptr) const;
+
+    // type arguments of a GENERICINST type, false if they are not readable
+    bool generic_arguments(const Il2CppType *type, uint32_t *argc,
+                           const Il2CppType *const **argv) const;
+
+    // name of the generic parameter behind a VAR or MVAR type
+    const char *generic_parameter_name(const Il2CppType *type) const;
+
+    // names of the generic parameters of a generic type definition
+    bool generic_parameter_names(int32_t container, std::vector<const char *> &out) const;
+
+    // the byref bit moved in 2021.1, the bit next to it is never set on signatures
+    static bool is_byref(const Il2CppType *type);
+
+    // offset of the n-th field of a type definition, 0 when there is no layout
+    uint64_t field_offset(int32_t type_definition, uint32_t field) const;
+
+    // constant of a literal field zero-extended from its size, false if it has none
+    bool field_default_value(int32_t field, uint64_t *value) const;
+
+    // methodPointers of the code gen module of the image, indexed by the token's rid
+    void *method_pointer(size_t image, uint32_t token) const;
+
+private:
+    struct Section {
+        const uint8_t *data = nullptr;
+        uint32_t size = 0;
+        uint32_t record = 1;
+
+        size_t count() const { return size / record; }
+
+        const uint8_t *at(int64_t index) const {
+            return index >= 0 && (uint64_t) index < count() ? data + index * record : nullptr;
+        }
+    };
+
+    struct CodeGenModule {
+        void *const *method_pointers = nullptr;
+        uint32_t method_pointer_count = 0;
+    };
+
+    bool readable(const void *ptr, size_t size) const;
+
+    // length of a NUL-terminated string inside readable memory, -1 if it runs out
+    ptrdiff_t readable_string(const char *str, size_t max) const;
+
+    // fills readable_ and the places a metadata header may start, the mapping of
+    // global-metadata.dat first, then anonymous memory it may have been decrypted into
+    bool load_maps(std::vector<const uint8_t *> &candidates);
+
+    bool parse_header(const uint8_t *header);
+
+    bool section(const uint8_t *header, uint32_t field, uint32_t record, Section &out) const;
+
+    bool find_registrations(void *handle);
+
+    bool check_metadata_registration(const uintptr_t *slots);
+
+    bool check_code_gen_modules(uintptr_t count, uintptr_t array);
+
+    // index from a handle, which is an index in libil2cpp.so and a pointer into the
+    // table once the runtime initialized the type (2020.2 and later)
+    static int32_t handle_index(uintptr_t handle, const Section &table);
+
+    // sorted, merged readable ranges of /proc/self/maps
+    std::vector<std::pair<uintptr_t, uintptr_t>> readable_;
+    uint32_t version_ = 0;
+    Section strings_;
+    Section properties_;
+    Section methods_;
+    Section field_default_values_;
+    Section default_value_data_;
+    Section parameters_;
+    Section fields_;
+    Section generic_parameters_;
+    Section generic_containers_;
+    Section interfaces_;
+    Section type_definitions_;
+    Section images_;
+    // offsets of the records whose layout changed between the supported versions
+    struct {
+        uint32_t declaring_type;
+        uint32_t parent;
+        uint32_t generic_container;
+        uint32_t flags;
+        uint32_t field_start;
+        uint32_t method_start;
+        uint32_t property_start;
+        uint32_t interfaces_start;
+        uint32_t method_count;
+        uint32_t bitfield;
+    } type_layout_{};
+    struct {
+        uint32_t parameter_start;
+        uint32_t token;
+    } method_layout_{};
+    const Il2CppType *const *types_ = nullptr;
+    size_t types_count_ = 0;
+    const int32_t *const *field_offsets_ = nullptr;
+    // field index and default value record, sorted by field index
+    std::vector<std::pair<int32_t, uint32_t>> default_values_;
+    std::vector<CodeGenModule> modules_;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_IL2CPP_METADATA_H
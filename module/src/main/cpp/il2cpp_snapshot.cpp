@@ -0,0 +1,216 @@
+//
+// Writes the binary snapshot described in snapshot_format.h.
+//
+
+#include "il2cpp_snapshot.h"
+#include "il2cpp_api.h"
+#include "dump_writer.h"
+#include "type_name_cache.h"
+#include "log.h"
+
+uint32_t SnapshotStringTable::add(std::string_view str) {
+    if (str.empty()) {
+        return 0;
+    }
+    auto [it, inserted] = offsets_.try_emplace(str, (uint32_t) data_.size());
+    if (inserted) {
+        data_.append(str).push_back('\0');
+    }
+    return it->second;
+}
+
+template<typename T>
+static SnapshotSection make_section(uint32_t id, const std::vector<T> &records) {
+    return {id, (uint32_t) sizeof(T), 0, records.size()};
+}
+
+bool SnapshotTables::write(const char *outPath) const {
+    SnapshotSection sections[] = {
+            {SNAPSHOT_SECTION_STRINGS, 1, 0, strings.data().size()},
+            make_section(SNAPSHOT_SECTION_IMAGES, images),
+            make_section(SNAPSHOT_SECTION_TYPES, types),
+            make_section(SNAPSHOT_SECTION_INTERFACES, interfaces),
+            make_section(SNAPSHOT_SECTION_FIELDS, fields),
+            make_section(SNAPSHOT_SECTION_PROPERTIES, properties),
+            make_section(SNAPSHOT_SECTION_METHODS, methods),
+            make_section(SNAPSHOT_SECTION_PARAMETERS, parameters),
+    };
+    const void *payloads[] = {strings.data().data(), images.data(), types.data(),
+                              interfaces.data(), fields.data(), properties.data(),
+                              methods.data(), parameters.data()};
+    constexpr auto sectionCount = std::size(sections);
+    SnapshotHeader header{SNAPSHOT_MAGIC, SNAPSHOT_VERSION_MAJOR, SNAPSHOT_VERSION_MINOR,
+                          sizeof(SnapshotHeader), sectionCount, il2cppBase};
+    uint64_t offset = sizeof(header) + sizeof(sections);
+    for (auto &section: sections) {
+        offset = (offset + 7) & ~7ull;
+        section.offset = offset;
+        offset += section.record_size * section.count;
+    }
+
+    DumpWriter writer;
+    if (!writer.open(outPath)) {
+        return false;
+    }
+    writer.write(&header, sizeof(header));
+    writer.write(sections, sizeof(sections));
+    static const char padding[8]{};
+    for (size_t i = 0; i < sectionCount; ++i) {
+        writer.write(padding, sections[i].offset - writer.bytes_written());
+        writer.write(payloads[i], sections[i].record_size * sections[i].count);
+    }
+    writer.close();
+    if (writer.failed()) {
+        return false;
+    }
+    LOGI("snapshot: %zu types, %zu fields, %zu methods, %zu strings bytes, %zu bytes total",
+         types.size(), fields.size(), methods.size(), strings.data().size(),
+         writer.bytes_written());
+    return true;
+}
+
+namespace {
+
+struct SnapshotBuilder : SnapshotTables {
+    // parent and interface links are resolved once every type has its index
+    std::unordered_map<Il2CppClass *, int32_t> typeIndices;
+    std::vector<Il2CppClass *> parents;
+    std::vector<Il2CppClass *> interfaceClasses;
+    TypeNameCache names;
+
+    void add_type(Il2CppClass *klass, uint32_t image);
+
+    void resolve_links();
+};
+
+void SnapshotBuilder::add_type(Il2CppClass *klass, uint32_t image) {
+    typeIndices.emplace(klass, (int32_t) types.size());
+    SnapshotType type{};
+    type.name = strings.add(names.declaration_name(klass));
+    type.namespaze = strings.add(il2cpp_class_get_namespace(klass));
+    type.image = image;
+    type.flags = il2cpp_class_get_flags(klass);
+    type.token = il2cpp_class_get_type_token(klass);
+    auto is_valuetype = il2cpp_class_is_valuetype(klass);
+    auto is_enum = il2cpp_class_is_enum(klass);
+    type.kind = (is_valuetype ? SNAPSHOT_TYPE_VALUETYPE : 0) | (is_enum ? SNAPSHOT_TYPE_ENUM : 0);
+    type.parent = SNAPSHOT_NONE;
+    auto parent = il2cpp_class_get_parent(klass);
+    parents.push_back(parent);
+    if (parent) {
+        type.parent_name = strings.add(names.type_name(il2cpp_class_get_type(parent)));
+    }
+
+    type.first_interface = interfaces.size();
+    void *iter = nullptr;
+    while (auto itf = il2cpp_class_get_interfaces(klass, &iter)) {
+        interfaces.push_back({strings.add(names.type_name(il2cpp_class_get_type(itf))),
+                              SNAPSHOT_NONE});
+        interfaceClasses.push_back(itf);
+    }
+    type.interface_count = interfaces.size() - type.first_interface;
+
+    type.first_field = fields.size();
+    iter = nullptr;
+    while (auto field = il2cpp_class_get_fields(klass, &iter)) {
+        fields.push_back({strings.add(il2cpp_field_get_name(field)),
+                          strings.add(names.type_name(il2cpp_field_get_type(field))),
+                          (uint32_t) il2cpp_field_get_flags(field),
+                          (uint32_t) il2cpp_field_get_offset(field)});
+    }
+    type.field_count = fields.size() - type.first_field;
+
+    type.first_method = methods.size();
+    std::unordered_map<const MethodInfo *, int32_t> methodIndices;
+    iter = nullptr;
+    while (auto method = il2cpp_class_get_methods(klass, &iter)) {
+        methodIndices.emplace(method, (int32_t) methods.size());
+        SnapshotMethod record{};
+        if (method->methodPointer) {
+            record.rva = (uint64_t) method->methodPointer - il2cppBase;
+        }
+        record.name = strings.add(il2cpp_method_get_name(method));
+        record.return_type = strings.add(names.type_name(il2cpp_method_get_return_type(method)));
+        record.flags = il2cpp_method_get_flags(method, &record.iflags);
+        record.token = il2cpp_method_get_token(method);
+        record.first_parameter = parameters.size();
+        record.parameter_count = il2cpp_method_get_param_count(method);
+        for (uint32_t i = 0; i < record.parameter_count; ++i) {
+            auto param = il2cpp_method_get_param(method, i);
+            auto byref = il2cpp_type_is_byref ? il2cpp_type_is_byref(param) : param->byref;
+            parameters.push_back({strings.add(il2cpp_method_get_param_name(method, i)),
+                                  strings.add(names.type_name(param)), param->attrs,
+                                  byref ? (uint32_t) SNAPSHOT_PARAMETER_BYREF : 0});
+        }
+        methods.push_back(record);
+    }
+    type.method_count = methods.size() - type.first_method;
+
+    auto method_index = [&](const MethodInfo *method) {
+        auto it = methodIndices.find(method);
+        return it == methodIndices.end() ? SNAPSHOT_NONE : it->second;
+    };
+    type.first_property = properties.size();
+    iter = nullptr;
+    while (auto prop_const = il2cpp_class_get_properties(klass, &iter)) {
+        auto prop = const_cast<PropertyInfo *>(prop_const);
+        auto get = il2cpp_property_get_get_method(prop);
+        auto set = il2cpp_property_get_set_method(prop);
+        const Il2CppType *prop_type = nullptr;
+        if (get) {
+            prop_type = il2cpp_method_get_return_type(get);
+        } else if (set) {
+            prop_type = il2cpp_method_get_param(set, 0);
+        }
+        properties.push_back({strings.add(il2cpp_property_get_name(prop)),
+                              prop_type ? strings.add(names.type_name(prop_type)) : 0,
+                              il2cpp_property_get_flags(prop), method_index(get),
+                              method_index(set), 0});
+    }
+    type.property_count = properties.size() - type.first_property;
+    types.push_back(type);
+}
+
+void SnapshotBuilder::resolve_links() {
+    auto type_index = [&](Il2CppClass *klass) {
+        auto it = typeIndices.find(klass);
+        return it == typeIndices.end() ? SNAPSHOT_NONE : it->second;
+    };
+    for (size_t i = 0; i < types.size(); ++i) {
+        if (parents[i]) {
+            types[i].parent = type_index(parents[i]);
+        }
+    }
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        interfaces[i].type = type_index(interfaceClasses[i]);
+    }
+}
+
+}
+
+bool il2cpp_dump_snapshot(const char *outPath, uint64_t il2cppBase) {
+    if (!il2cpp_image_get_class) {
+        LOGW("snapshot needs il2cpp_image_get_class, skipped");
+        return false;
+    }
+    size_t size;
+    auto domain = il2cpp_domain_get();
+    auto assemblies = il2cpp_domain_get_assemblies(domain, &size);
+    SnapshotBuilder builder;
+    builder.il2cppBase = il2cppBase;
+    for (size_t i = 0; i < size; ++i) {
+        auto image = il2cpp_assembly_get_image(assemblies[i]);
+        SnapshotImage record{};
+        record.name = builder.strings.add(il2cpp_image_get_name(image));
+        record.first_type = builder.types.size();
+        auto classCount = il2cpp_image_get_class_count(image);
+        for (size_t j = 0; j < classCount; ++j) {
+            auto klass = const_cast<Il2CppClass *>(il2cpp_image_get_class(image, j));
+            builder.add_type(klass, i);
+        }
+        record.type_count = builder.types.size() - record.first_type;
+        builder.images.push_back(record);
+    }
+    builder.resolve_links();
+    return builder.write(outPath);
+}
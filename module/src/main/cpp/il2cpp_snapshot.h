@@ -0,0 +1,55 @@
+//
+// Writes the binary snapshot described in snapshot_format.h.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_IL2CPP_SNAPSHOT_H
+#define ZYGISK_IL2CPPDUMPER_IL2CPP_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "snapshot_format.h"
+
+class SnapshotStringTable {
+public:
+    SnapshotStringTable() {
+        data_.push_back('\0');
+    }
+
+    // the views must stay valid until the table is written, which holds for
+    // runtime-owned names, metadata strings and names interned in a name cache
+    uint32_t add(std::string_view str);
+
+    uint32_t add(const char *str) {
+        return add(std::string_view(str ? str : ""));
+    }
+
+    const std::string &data() const { return data_; }
+
+private:
+    std::string data_;
+    std::unordered_map<std::string_view, uint32_t> offsets_;
+};
+
+// The records of a snapshot, filled from the il2cpp api or from global-metadata.dat
+// and written out the same way
+struct SnapshotTables {
+    SnapshotStringTable strings;
+    std::vector<SnapshotImage> images;
+    std::vector<SnapshotType> types;
+    std::vector<SnapshotInterface> interfaces;
+    std::vector<SnapshotField> fields;
+    std::vector<SnapshotProperty> properties;
+    std::vector<SnapshotMethod> methods;
+    std::vector<SnapshotParameter> parameters;
+    uint64_t il2cppBase = 0;
+
+    bool write(const char *outPath) const;
+};
+
+// requires il2cpp_image_get_class, i.e. Unity 2018.3 or later
+bool il2cpp_dump_snapshot(const char *outPath, uint64_t il2cppBase);
+
+#endif //ZYGISK_IL2CPPDUMPER_IL2CPP_SNAPSHOT_H
@@ -1,14 +1,12 @@
 #include <cstring>
 #include <thread>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <sys/types.h>
+#include <dlfcn.h>
 #include <unistd.h>
+#include <android/dlext.h>
 #include <cinttypes>
 #include "hack.h"
 #include "zygisk.hpp"
-#include "game.h"
+#include "companion.h"
 #include "log.h"
 
 using zygisk::Api;
@@ -32,7 +30,7 @@ public:
 
     void postAppSpecialize(const AppSpecializeArgs *) override {
         if (enable_hack) {
-            std::thread hack_thread(hack_prepare, game_data_dir, data, length);
+            std::thread hack_thread(dumper_entry, hack_args, payload_fd);
             hack_thread.detach();
         }
     }
@@ -41,40 +39,75 @@ private:
     Api *api;
     JNIEnv *env;
     bool enable_hack;
-    char *game_data_dir;
-    void *data;
-    size_t length;
+    HackArgs *hack_args;
+    HackPrepareFn dumper_entry = nullptr;
+    int payload_fd = -1;
+
+    // The dumper lives in its own library so that apps which are not targets only ever
+    // map this stub. It is loaded from the fd before specialization, while the module
+    // dir is still accessible.
+    static HackPrepareFn LoadDumper(int fd) {
+        android_dlextinfo info{};
+        info.flags = ANDROID_DLEXT_USE_LIBRARY_FD;
+        info.library_fd = fd;
+        auto handle = android_dlopen_ext(DumperLibraryName, RTLD_NOW, &info);
+        close(fd);
+        if (!handle) {
+            LOGE("load dumper failed: %s", dlerror());
+            return nullptr;
+        }
+        auto prepare = (HackPrepareFn) dlsym(handle, "hack_prepare");
+        if (!prepare) {
+            LOGE("hack_prepare not found");
+            dlclose(handle);
+        }
+        return prepare;
+    }
 
     void preSpecialize(const char *package_name, const char *app_data_dir) {
-        if (strcmp(package_name, GamePackageName) == 0) {
+        //不是目标时只查targets.bin; 目标或targets.bin不可用时由companion回答并带回fd,
+        //companion不可用时直接读取
+        CompanionReply reply{};
+        int dumper_fd = -1;
+        int module_dir = api->getModuleDir();
+        bool answered = probe_target(module_dir, package_name, reply) && !reply.target;
+        if (!answered) {
+            int client = api->connectCompanion();
+            answered = client != -1 &&
+                       companion_query(client, module_dir, package_name, reply, dumper_fd,
+                                       payload_fd);
+            if (client != -1) {
+                close(client);
+            }
+        }
+        if (!answered) {
+            LOGW("companion unavailable, reading module dir");
+            if (lookup_target(module_dir, package_name, reply)) {
+                dumper_fd = open_dumper(module_dir);
+                payload_fd = load_payload(module_dir);
+            }
+        }
+        if (reply.target && dumper_fd != -1) {
+            dumper_entry = LoadDumper(dumper_fd);
+        } else if (reply.target) {
+            LOGE("dumper library not available");
+        }
+        if (reply.target && !dumper_entry && payload_fd != -1) {
+            close(payload_fd);
+            payload_fd = -1;
+        }
+        if (reply.target && dumper_entry) {
             LOGI("detect game: %s", package_name);
             enable_hack = true;
-            game_data_dir = new char[strlen(app_data_dir) + 1];
+            auto game_data_dir = new char[strlen(app_data_dir) + 1];
             strcpy(game_data_dir, app_data_dir);
-
-#if defined(__i386__)
-            auto path = "zygisk/armeabi-v7a.so";
-#endif
-#if defined(__x86_64__)
-            auto path = "zygisk/arm64-v8a.so";
-#endif
-#if defined(__i386__) || defined(__x86_64__)
-            int dirfd = api->getModuleDir();
-            int fd = openat(dirfd, path, O_RDONLY);
-            if (fd != -1) {
-                struct stat sb{};
-                fstat(fd, &sb);
-                length = sb.st_size;
-                data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
-                close(fd);
-            } else {
-                LOGW("Unable to open arm file");
-            }
-#endif
+            hack_args = new HackArgs{game_data_dir, reply.threads, reply.snapshot,
+                                     reply.metadata};
         } else {
             api->setOption(zygisk::Option::DLCLOSE_MODULE_LIBRARY);
         }
     }
 };
 
-REGISTER_ZYGISK_MODULE(MyModule)
\ No newline at end of file
+REGISTER_ZYGISK_MODULE(MyModule)
+REGISTER_ZYGISK_COMPANION(companion_handler)
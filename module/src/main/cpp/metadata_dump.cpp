@@ -0,0 +1,598 @@
+//
+// dump.cs from the tables of global-metadata.dat, without calling the il2cpp api.
+//
+
+#include "metadata_dump.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log.h"
+#include "il2cpp-tabledefs.h"
+#include "dump_modifiers.h"
+#include "dump_buffer.h"
+#include "dump_driver.h"
+#include "type_name_cache.h"
+#include "il2cpp_snapshot.h"
+
+namespace {
+
+// TypeNameCache over metadata records, type definitions are keyed by index + 1
+class MetadataNames {
+public:
+    explicit MetadataNames(const Il2CppMetadata &metadata) : metadata_(metadata) {}
+
+    std::string_view declaration_name(int32_t index);
+
+    std::string_view type_name(const Il2CppType *type) {
+        if (!type) {
+            return "";
+        }
+        auto name = primitive_name(type->type);
+        if (!name.empty()) {
+            ++hits_;
+            return name;
+        }
+        if (auto cached = types_.find(type_key(type))) {
+            ++hits_;
+            return *cached;
+        }
+        ++misses_;
+        return resolve_type(type, 0);
+    }
+
+    size_t hits() const { return hits_; }
+
+    size_t misses() const { return misses_; }
+
+private:
+    // deeper nesting than this only shows up in corrupted metadata
+    static constexpr int kMaxDepth = 32;
+
+    static const void *key(int32_t index) { return (const void *) ((uintptr_t) index + 1); }
+
+    // Types that only differ in attrs or byref, like the copy il2cpp keeps for every
+    // field and parameter, share one entry. Element pointers and type definition handles
+    // get a tag that keeps them apart from the aligned pointers and from each other.
+    static const void *type_key(const Il2CppType *type) {
+        auto data = (uintptr_t) type->data.dummy;
+        switch (type->type) {
+            case IL2CPP_TYPE_SZARRAY:
+                return (const void *) (data + 1);
+            case IL2CPP_TYPE_PTR:
+                return (const void *) (data + 2);
+            case IL2CPP_TYPE_ARRAY:
+            case IL2CPP_TYPE_GENERICINST:
+                return (const void *) data;
+            case IL2CPP_TYPE_VAR:
+            case IL2CPP_TYPE_MVAR:
+                // the handle is an index before 2020.2
+                return type;
+            default:
+                return (const void *) (data + 3);
+        }
+    }
+
+    std::string_view resolve_class(int32_t index, int depth);
+
+    std::string_view resolve_type(const Il2CppType *type, int depth);
+
+    void append_outer_name(std::string &out, int32_t index, int depth);
+
+    const Il2CppMetadata &metadata_;
+    NameTable classes_;
+    NameTable declarations_;
+    NameTable types_;
+    NameArena arena_;
+    std::vector<const char *> parameters_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+std::string_view MetadataNames::declaration_name(int32_t index) {
+    if (auto name = declarations_.find(key(index))) {
+        return *name;
+    }
+    MetadataTypeDefinition definition{};
+    if (!metadata_.type_definition(index, definition)) {
+        return "";
+    }
+    std::string_view name = metadata_.string(definition.name);
+    if (definition.generic_container != kMetadataNone) {
+        std::string out(strip_arity(name));
+        if (metadata_.generic_parameter_names(definition.generic_container, parameters_) &&
+            !parameters_.empty()) {
+            out.append(1, '<');
+            for (size_t i = 0; i < parameters_.size(); ++i) {
+                if (i > 0) {
+                    out.append(", ");
+                }
+                out.append(parameters_[i]);
+            }
+            out.append(1, '>');
+        }
+        name = arena_.intern(out);
+    }
+    declarations_.insert(key(index), name);
+    return name;
+}
+
+void MetadataNames::append_outer_name(std::string &out, int32_t index, int depth) {
+    MetadataTypeDefinition definition{};
+    if (depth > kMaxDepth || !metadata_.type_definition(index, definition) ||
+        definition.declaring_type == kMetadataNone) {
+        return;
+    }
+    //嵌套类型以外层类型名作前缀, 外层不带泛型参数
+    auto declaring = metadata_.type(definition.declaring_type);
+    auto outer = declaring ? metadata_.type_definition_of(declaring) : kMetadataNone;
+    MetadataTypeDefinition outerDefinition{};
+    if (metadata_.type_definition(outer, outerDefinition)) {
+        append_outer_name(out, outer, depth + 1);
+        out.append(strip_arity(metadata_.string(outerDefinition.name))).append(1, '.');
+    }
+}
+
+std::string_view MetadataNames::resolve_class(int32_t index, int depth) {
+    if (auto name = classes_.find(key(index))) {
+        return *name;
+    }
+    MetadataTypeDefinition definition{};
+    if (!metadata_.type_definition(index, definition)) {
+        return "";
+    }
+    std::string_view name;
+    if (definition.declaring_type == kMetadataNone &&
+        definition.generic_container == kMetadataNone) {
+        //类名在metadata中, 无需复制
+        name = metadata_.string(definition.name);
+    } else {
+        std::string out;
+        append_outer_name(out, index, depth);
+        out.append(declaration_name(index));
+        name = arena_.intern(out);
+    }
+    classes_.insert(key(index), name);
+    return name;
+}
+
+std::string_view MetadataNames::resolve_type(const Il2CppType *type, int depth) {
+    if (!type || depth > kMaxDepth) {
+        return "";
+    }
+    if (auto name = types_.find(type_key(type))) {
+        return *name;
+    }
+    std::string_view name = primitive_name(type->type);
+    if (name.empty()) {
+        std::string out;
+        switch (type->type) {
+            case IL2CPP_TYPE_SZARRAY:
+                out.append(resolve_type(metadata_.element_type(type), depth + 1)).append("[]");
+                break;
+            case IL2CPP_TYPE_ARRAY: {
+                uint8_t rank = 0;
+                auto element = metadata_.element_type(type, &rank);
+                out.append(resolve_type(element, depth + 1)).append(1, '[');
+                out.append(rank > 1 ? rank - 1 : 0, ',').append(1, ']');
+                break;
+            }
+            case IL2CPP_TYPE_PTR:
+                out.append(resolve_type(metadata_.element_type(type), depth + 1)).append(1, '*');
+                break;
+            case IL2CPP_TYPE_GENERICINST: {
+                auto index = metadata_.type_definition_of(type);
+                MetadataTypeDefinition definition{};
+                if (metadata_.type_definition(index, definition)) {
+                    append_outer_name(out, index, depth);
+                    out.append(strip_arity(metadata_.string(definition.name)));
+                }
+                uint32_t argc = 0;
+                const Il2CppType *const *argv = nullptr;
+                if (metadata_.generic_arguments(type, &argc, &argv) && argc > 0) {
+                    out.append(1, '<');
+                    for (uint32_t i = 0; i < argc; ++i) {
+                        if (i > 0) {
+                            out.append(", ");
+                        }
+                        out.append(resolve_type(argv[i], depth + 1));
+                    }
+                    out.append(1, '>');
+                }
+                break;
+            }
+            case IL2CPP_TYPE_VAR:
+            case IL2CPP_TYPE_MVAR:
+                out.append(metadata_.generic_parameter_name(type));
+                break;
+            default:
+                name = resolve_class(metadata_.type_definition_of(type), depth + 1);
+                break;
+        }
+        if (name.empty()) {
+            name = arena_.intern(out);
+        }
+    }
+    types_.insert(type_key(type), name);
+    return name;
+}
+
+void dump_method(const Il2CppMetadata &metadata, const MetadataTypeDefinition &definition,
+                 size_t image, uint64_t il2cppBase, DumpBuffer &outPut, MetadataNames &names) {
+    outPut.append("\n\t// Methods\n");
+    MetadataMethod method{};
+    for (int32_t i = 0; i < definition.method_count; ++i) {
+        if (!metadata.method(definition.method_start + i, method)) {
+            break;
+        }
+        ++dump_counters.methods;
+        auto methodPointer = metadata.method_pointer(image, method.token);
+        if (methodPointer) {
+            outPut.append("\t// RVA: 0x");
+            outPut.append_hex((uint64_t) methodPointer - il2cppBase);
+            outPut.append(" VA: 0x");
+            outPut.append_hex((uint64_t) methodPointer);
+        } else {
+            outPut.append("\t// RVA: 0x VA: 0x0");
+        }
+        outPut.append("\n\t");
+        outPut.append(get_method_modifier(method.flags));
+        auto return_type = metadata.type(method.return_type);
+        if (return_type && Il2CppMetadata::is_byref(return_type)) {
+            outPut.append("ref ");
+        }
+        outPut.append(names.type_name(return_type)).append(' ')
+                .append(metadata.string(method.name)).append('(');
+        MetadataParameter param{};
+        for (int32_t j = 0; j < method.parameter_count; ++j) {
+            if (!metadata.parameter(method.parameter_start + j, param)) {
+                break;
+            }
+            if (j > 0) {
+                outPut.append(", ");
+            }
+            //参数的in/out记在其类型的attrs中
+            auto param_type = metadata.type(param.type);
+            if (param_type) {
+                outPut.append(get_param_modifier(param_type->attrs,
+                                                 Il2CppMetadata::is_byref(param_type)));
+            }
+            outPut.append(names.type_name(param_type)).append(' ')
+                    .append(metadata.string(param.name));
+        }
+        outPut.append(") { }\n");
+    }
+}
+
+void dump_property(const Il2CppMetadata &metadata, const MetadataTypeDefinition &definition,
+                   DumpBuffer &outPut, MetadataNames &names) {
+    outPut.append("\n\t// Properties\n");
+    MetadataProperty prop{};
+    for (int32_t i = 0; i < definition.property_count; ++i) {
+        if (!metadata.property(definition.property_start + i, prop)) {
+            break;
+        }
+        ++dump_counters.properties;
+        MetadataMethod get{};
+        MetadataMethod set{};
+        auto has_get = prop.get != kMetadataNone &&
+                       metadata.method(definition.method_start + prop.get, get);
+        auto has_set = prop.set != kMetadataNone &&
+                       metadata.method(definition.method_start + prop.set, set);
+        outPut.append('\t');
+        const Il2CppType *prop_type = nullptr;
+        if (has_get) {
+            outPut.append(get_method_modifier(get.flags));
+            prop_type = metadata.type(get.return_type);
+        } else if (has_set) {
+            outPut.append(get_method_modifier(set.flags));
+            MetadataParameter value{};
+            if (set.parameter_count > 0 && metadata.parameter(set.parameter_start, value)) {
+                prop_type = metadata.type(value.type);
+            }
+        }
+        if (prop_type) {
+            outPut.append(names.type_name(prop_type)).append(' ')
+                    .append(metadata.string(prop.name)).append(" { ");
+            if (has_get) {
+                outPut.append("get; ");
+            }
+            if (has_set) {
+                outPut.append("set; ");
+            }
+            outPut.append("}\n");
+        } else {
+            //与api导出保持一致, 不换行
+            outPut.append(" // unknown property ").append(metadata.string(prop.name));
+        }
+    }
+}
+
+void dump_field(const Il2CppMetadata &metadata, const MetadataTypeDefinition &definition,
+                int32_t index, DumpBuffer &outPut, MetadataNames &names) {
+    outPut.append("\n\t// Fields\n");
+    MetadataField field{};
+    for (int32_t i = 0; i < definition.field_count; ++i) {
+        if (!metadata.field(definition.field_start + i, field)) {
+            break;
+        }
+        ++dump_counters.fields;
+        outPut.append('\t');
+        //字段的attrs记在其类型中
+        auto field_type = metadata.type(field.type);
+        auto attrs = field_type ? field_type->attrs : 0;
+        outPut.append(get_field_modifier(attrs));
+        outPut.append(names.type_name(field_type)).append(' ')
+                .append(metadata.string(field.name));
+        if (attrs & FIELD_ATTRIBUTE_LITERAL && definition.enumtype) {
+            uint64_t val = 0;
+            metadata.field_default_value(definition.field_start + i, &val);
+            outPut.append(" = ").append_dec(val);
+        }
+        outPut.append("; // 0x").append_hex(metadata.field_offset(index, i)).append('\n');
+    }
+}
+
+void dump_type(const Il2CppMetadata &metadata, size_t image, int32_t index,
+               uint64_t il2cppBase, DumpBuffer &outPut, MetadataNames &names) {
+    MetadataTypeDefinition definition{};
+    if (!metadata.type_definition(index, definition)) {
+        return;
+    }
+    ++dump_counters.classes;
+    outPut.append("\n// Namespace: ").append(metadata.string(definition.namespaze))
+            .append('\n');
+    auto flags = definition.flags;
+    if (flags & TYPE_ATTRIBUTE_SERIALIZABLE) {
+        outPut.append("[Serializable]\n");
+    }
+    auto is_valuetype = definition.valuetype;
+    auto is_enum = definition.enumtype;
+    outPut.append(get_type_modifier(flags, is_valuetype, is_enum));
+    outPut.append(names.declaration_name(index));
+    std::vector<std::string_view> extends;
+    auto parent_type = metadata.type(definition.parent);
+    if (!is_valuetype && !is_enum && parent_type && parent_type->type != IL2CPP_TYPE_OBJECT) {
+        extends.emplace_back(names.type_name(parent_type));
+    }
+    for (int32_t i = 0; i < definition.interfaces_count; ++i) {
+        auto itf = metadata.type(metadata.interface_type(definition.interfaces_start + i));
+        if (itf) {
+            extends.emplace_back(names.type_name(itf));
+        }
+    }
+    if (!extends.empty()) {
+        outPut.append(" : ").append(extends[0]);
+        for (size_t i = 1; i < extends.size(); ++i) {
+            outPut.append(", ").append(extends[i]);
+        }
+    }
+    outPut.append("\n{");
+    dump_field(metadata, definition, index, outPut, names);
+    dump_property(metadata, definition, outPut, names);
+    dump_method(metadata, definition, image, il2cppBase, outPut, names);
+    outPut.append("}\n");
+}
+
+// metadata side of dump_chunks, chunks index the type definitions directly
+class MetadataDumpWorker {
+public:
+    MetadataDumpWorker(const Il2CppMetadata &metadata, uint64_t il2cppBase)
+            : metadata_(metadata), il2cpp_base_(il2cppBase), names_(metadata) {}
+
+    int32_t resolve(const DumpChunk &, size_t index) { return (int32_t) index; }
+
+    void format(int32_t index, const DumpChunk &chunk, DumpBuffer &outPut) {
+        dump_type(metadata_, chunk.image, index, il2cpp_base_, outPut, names_);
+    }
+
+    size_t hits() const { return names_.hits(); }
+
+    size_t misses() const { return names_.misses(); }
+
+private:
+    const Il2CppMetadata &metadata_;
+    uint64_t il2cpp_base_;
+    MetadataNames names_;
+};
+
+// dump.bin from the same tables, record for record what il2cpp_dump_snapshot writes
+struct MetadataSnapshotBuilder : SnapshotTables {
+    explicit MetadataSnapshotBuilder(const Il2CppMetadata &metadata)
+            : metadata(metadata), names(metadata),
+              typeIndices(metadata.type_definition_count(), SNAPSHOT_NONE) {}
+
+    const Il2CppMetadata &metadata;
+    MetadataNames names;
+    // parent and interface links are resolved once every type has its index, from type
+    // definition indices
+    std::vector<int32_t> typeIndices;
+    std::vector<int32_t> parents;
+    std::vector<int32_t> interfaceDefinitions;
+
+    void add_type(int32_t index, uint32_t image);
+
+    void resolve_links();
+};
+
+//泛型实例不在快照中, 与api导出一致
+static int32_t class_definition(const Il2CppMetadata &metadata, const Il2CppType *type) {
+    if (!type || type->type == IL2CPP_TYPE_GENERICINST) {
+        return kMetadataNone;
+    }
+    return metadata.type_definition_of(type);
+}
+
+void MetadataSnapshotBuilder::add_type(int32_t index, uint32_t image) {
+    MetadataTypeDefinition definition{};
+    if (!metadata.type_definition(index, definition)) {
+        return;
+    }
+    typeIndices[index] = (int32_t) types.size();
+    SnapshotType type{};
+    type.name = strings.add(names.declaration_name(index));
+    type.namespaze = strings.add(metadata.string(definition.namespaze));
+    type.image = image;
+    type.flags = definition.flags;
+    type.token = definition.token;
+    type.kind = (definition.valuetype ? SNAPSHOT_TYPE_VALUETYPE : 0) |
+                (definition.enumtype ? SNAPSHOT_TYPE_ENUM : 0);
+    type.parent = SNAPSHOT_NONE;
+    auto parent = metadata.type(definition.parent);
+    parents.push_back(class_definition(metadata, parent));
+    if (parent) {
+        type.parent_name = strings.add(names.type_name(parent));
+    }
+
+    type.first_interface = interfaces.size();
+    for (int32_t i = 0; i < definition.interfaces_count; ++i) {
+        auto itf = metadata.type(metadata.interface_type(definition.interfaces_start + i));
+        if (itf) {
+            interfaces.push_back({strings.add(names.type_name(itf)), SNAPSHOT_NONE});
+            interfaceDefinitions.push_back(class_definition(metadata, itf));
+        }
+    }
+    type.interface_count = interfaces.size() - type.first_interface;
+
+    type.first_field = fields.size();
+    MetadataField field{};
+    for (int32_t i = 0; i < definition.field_count; ++i) {
+        if (!metadata.field(definition.field_start + i, field)) {
+            break;
+        }
+        auto field_type = metadata.type(field.type);
+        fields.push_back({strings.add(metadata.string(field.name)),
+                          strings.add(names.type_name(field_type)),
+                          field_type ? (uint32_t) field_type->attrs : 0,
+                          (uint32_t) metadata.field_offset(index, i)});
+    }
+    type.field_count = fields.size() - type.first_field;
+
+    type.first_method = methods.size();
+    MetadataMethod method{};
+    for (int32_t i = 0; i < definition.method_count; ++i) {
+        if (!metadata.method(definition.method_start + i, method)) {
+            break;
+        }
+        SnapshotMethod record{};
+        if (auto methodPointer = metadata.method_pointer(image, method.token)) {
+            record.rva = (uint64_t) methodPointer - il2cppBase;
+        }
+        record.name = strings.add(metadata.string(method.name));
+        record.return_type = strings.add(names.type_name(metadata.type(method.return_type)));
+        record.flags = method.flags;
+        record.iflags = method.iflags;
+        record.token = method.token;
+        record.first_parameter = parameters.size();
+        MetadataParameter param{};
+        for (int32_t j = 0; j < method.parameter_count; ++j) {
+            if (!metadata.parameter(method.parameter_start + j, param)) {
+                break;
+            }
+            auto param_type = metadata.type(param.type);
+            auto byref = param_type && Il2CppMetadata::is_byref(param_type);
+            parameters.push_back({strings.add(metadata.string(param.name)),
+                                  strings.add(names.type_name(param_type)),
+                                  param_type ? (uint32_t) param_type->attrs : 0,
+                                  byref ? (uint32_t) SNAPSHOT_PARAMETER_BYREF : 0});
+        }
+        record.parameter_count = parameters.size() - record.first_parameter;
+        methods.push_back(record);
+    }
+    type.method_count = methods.size() - type.first_method;
+
+    //get/set是相对于类型method_start的下标, 只接受本类型已写出的方法
+    auto method_index = [&](int32_t relative) {
+        return relative >= 0 && (uint32_t) relative < type.method_count
+               ? (int32_t) (type.first_method + relative) : SNAPSHOT_NONE;
+    };
+    type.first_property = properties.size();
+    MetadataProperty prop{};
+    for (int32_t i = 0; i < definition.property_count; ++i) {
+        if (!metadata.property(definition.property_start + i, prop)) {
+            break;
+        }
+        auto get = method_index(prop.get);
+        auto set = method_index(prop.set);
+        MetadataMethod accessor{};
+        const Il2CppType *prop_type = nullptr;
+        if (get != SNAPSHOT_NONE &&
+            metadata.method(definition.method_start + prop.get, accessor)) {
+            prop_type = metadata.type(accessor.return_type);
+        } else if (set != SNAPSHOT_NONE &&
+                   metadata.method(definition.method_start + prop.set, accessor)) {
+            MetadataParameter value{};
+            if (accessor.parameter_count > 0 &&
+                metadata.parameter(accessor.parameter_start, value)) {
+                prop_type = metadata.type(value.type);
+            }
+        }
+        properties.push_back({strings.add(metadata.string(prop.name)),
+                              prop_type ? strings.add(names.type_name(prop_type)) : 0,
+                              prop.attrs, get, set, 0});
+    }
+    type.property_count = properties.size() - type.first_property;
+    types.push_back(type);
+}
+
+void MetadataSnapshotBuilder::resolve_links() {
+    auto type_index = [&](int32_t definition) {
+        return definition >= 0 && (size_t) definition < typeIndices.size()
+               ? typeIndices[definition] : SNAPSHOT_NONE;
+    };
+    for (size_t i = 0; i < types.size(); ++i) {
+        types[i].parent = type_index(parents[i]);
+    }
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        interfaces[i].type = type_index(interfaceDefinitions[i]);
+    }
+}
+
+}
+
+size_t metadata_dump(const Il2CppMetadata &metadata, uint64_t il2cppBase, unsigned int threads,
+                     DumpWriter &writer, DumpBuffer &outPut, size_t &nameHits,
+                     size_t &nameMisses) {
+    auto enumerateStart = metrics_now_ns();
+    std::vector<std::string> imageStrs(metadata.image_count());
+    std::vector<DumpChunk> chunks;
+    for (size_t i = 0; i < metadata.image_count(); ++i) {
+        MetadataImage image{};
+        metadata.image(i, image);
+        auto name = metadata.string(image.name);
+        outPut.append("// Image ").append_dec((uint64_t) i).append(": ").append(name)
+                .append('\n');
+        imageStrs[i] = std::string("\n// Dll : ").append(name);
+        size_t begin = image.type_start;
+        size_t end = begin + image.type_count;
+        for (auto j = begin; j < end; j += kClassesPerChunk) {
+            chunks.push_back({i, j, std::min(j + kClassesPerChunk, end)});
+        }
+    }
+    metrics_add_time(DumpPhase::Enumerate, metrics_now_ns() - enumerateStart);
+    LOGI("dumping %zu type definitions from metadata v%u",
+         metadata.type_definition_count(), metadata.version());
+    //只读metadata, 工作线程无需附加到il2cpp
+    return dump_chunks(chunks, imageStrs, threads, writer, outPut, nameHits, nameMisses,
+                       [&](bool) { return MetadataDumpWorker(metadata, il2cppBase); });
+}
+
+bool metadata_dump_snapshot(const Il2CppMetadata &metadata, uint64_t il2cppBase,
+                            const char *outPath) {
+    MetadataSnapshotBuilder builder(metadata);
+    builder.il2cppBase = il2cppBase;
+    for (size_t i = 0; i < metadata.image_count(); ++i) {
+        MetadataImage image{};
+        metadata.image(i, image);
+        SnapshotImage record{};
+        record.name = builder.strings.add(metadata.string(image.name));
+        record.first_type = builder.types.size();
+        for (uint32_t j = 0; j < image.type_count; ++j) {
+            builder.add_type(image.type_start + (int32_t) j, i);
+        }
+        record.type_count = builder.types.size() - record.first_type;
+        builder.images.push_back(record);
+    }
+    builder.resolve_links();
+    return builder.write(outPath);
+}
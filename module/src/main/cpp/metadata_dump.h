@@ -0,0 +1,25 @@
+//
+// dump.cs from the tables of global-metadata.dat, without calling the il2cpp api.
+// The output matches il2cpp_dump's byte for byte.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_METADATA_DUMP_H
+#define ZYGISK_IL2CPPDUMPER_METADATA_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include "il2cpp_metadata.h"
+#include "dump_buffer.h"
+#include "dump_writer.h"
+
+// Dumps the image list and every type definition through dump_chunks, with threads
+// workers when threads > 1. Returns the size of the largest type.
+size_t metadata_dump(const Il2CppMetadata &metadata, uint64_t il2cppBase, unsigned int threads,
+                     DumpWriter &writer, DumpBuffer &outPut, size_t &nameHits,
+                     size_t &nameMisses);
+
+// dump.bin from the same tables, with the records il2cpp_dump_snapshot would write
+bool metadata_dump_snapshot(const Il2CppMetadata &metadata, uint64_t il2cppBase,
+                            const char *outPath);
+
+#endif //ZYGISK_IL2CPPDUMPER_METADATA_DUMP_H
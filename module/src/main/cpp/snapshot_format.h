@@ -0,0 +1,152 @@
+//
+// Binary snapshot of the dumped metadata (dump.bin).
+//
+// The file is meant to be mmap'ed by host tools: a SnapshotHeader, followed by
+// section_count SnapshotSection entries, followed by the section payloads, each
+// aligned to 8 bytes. Sections hold flat arrays of fixed-width little-endian
+// records; all strings are offsets into the STRINGS section, which holds
+// deduplicated NUL-terminated strings and starts with the empty string.
+// Readers look sections up by id and skip the ones they don't know; a new
+// major version means existing records changed.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_SNAPSHOT_FORMAT_H
+#define ZYGISK_IL2CPPDUMPER_SNAPSHOT_FORMAT_H
+
+#include <stdint.h>
+
+#define SNAPSHOT_MAGIC 0x53443249 // "I2DS"
+#define SNAPSHOT_VERSION_MAJOR 1
+#define SNAPSHOT_VERSION_MINOR 0
+
+// index of a record that is not part of the snapshot
+#define SNAPSHOT_NONE (-1)
+
+enum SnapshotSectionId {
+    SNAPSHOT_SECTION_STRINGS = 1,
+    SNAPSHOT_SECTION_IMAGES = 2,
+    SNAPSHOT_SECTION_TYPES = 3,
+    SNAPSHOT_SECTION_FIELDS = 4,
+    SNAPSHOT_SECTION_PROPERTIES = 5,
+    SNAPSHOT_SECTION_METHODS = 6,
+    SNAPSHOT_SECTION_PARAMETERS = 7,
+    SNAPSHOT_SECTION_INTERFACES = 8,
+};
+
+typedef struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    // sizeof(SnapshotHeader) of the writer, the section table starts right after
+    uint32_t header_size;
+    uint32_t section_count;
+    uint64_t il2cpp_base;
+} SnapshotHeader;
+
+typedef struct SnapshotSection {
+    uint32_t id;
+    // bytes per record, 1 for STRINGS
+    uint32_t record_size;
+    // from the start of the file
+    uint64_t offset;
+    uint64_t count;
+} SnapshotSection;
+
+typedef struct SnapshotImage {
+    uint32_t name;
+    uint32_t first_type;
+    uint32_t type_count;
+    uint32_t reserved;
+} SnapshotImage;
+
+#define SNAPSHOT_TYPE_VALUETYPE 0x1
+#define SNAPSHOT_TYPE_ENUM 0x2
+
+typedef struct SnapshotType {
+    uint32_t name;
+    uint32_t namespaze;
+    uint32_t image;
+    // TYPE_ATTRIBUTE_*
+    uint32_t flags;
+    uint32_t token;
+    // SNAPSHOT_TYPE_*
+    uint32_t kind;
+    // index into TYPES, SNAPSHOT_NONE for generic instances and types outside the dump
+    int32_t parent;
+    // full C# name of the parent, 0 when there is none
+    uint32_t parent_name;
+    uint32_t first_interface;
+    uint32_t interface_count;
+    uint32_t first_field;
+    uint32_t field_count;
+    uint32_t first_property;
+    uint32_t property_count;
+    uint32_t first_method;
+    uint32_t method_count;
+} SnapshotType;
+
+typedef struct SnapshotInterface {
+    uint32_t type_name;
+    int32_t type;
+} SnapshotInterface;
+
+typedef struct SnapshotField {
+    uint32_t name;
+    uint32_t type_name;
+    // FIELD_ATTRIBUTE_*
+    uint32_t flags;
+    uint32_t offset;
+} SnapshotField;
+
+typedef struct SnapshotProperty {
+    uint32_t name;
+    uint32_t type_name;
+    // PROPERTY_ATTRIBUTE_*
+    uint32_t flags;
+    // indices into METHODS
+    int32_t get_method;
+    int32_t set_method;
+    uint32_t reserved;
+} SnapshotProperty;
+
+typedef struct SnapshotMethod {
+    // 0 when the method has no code
+    uint64_t rva;
+    uint32_t name;
+    uint32_t return_type;
+    // METHOD_ATTRIBUTE_*
+    uint32_t flags;
+    // METHOD_IMPL_ATTRIBUTE_*
+    uint32_t iflags;
+    uint32_t token;
+    uint32_t first_parameter;
+    uint32_t parameter_count;
+    uint32_t reserved;
+} SnapshotMethod;
+
+#define SNAPSHOT_PARAMETER_BYREF 0x1
+
+typedef struct SnapshotParameter {
+    uint32_t name;
+    uint32_t type_name;
+    // PARAM_ATTRIBUTE_*
+    uint32_t attrs;
+    // SNAPSHOT_PARAMETER_*
+    uint32_t flags;
+} SnapshotParameter;
+
+#ifdef __cplusplus
+
+static_assert(sizeof(SnapshotHeader) == 24);
+static_assert(sizeof(SnapshotSection) == 24);
+static_assert(sizeof(SnapshotImage) == 16);
+static_assert(sizeof(SnapshotType) == 64);
+static_assert(sizeof(SnapshotInterface) == 8);
+static_assert(sizeof(SnapshotField) == 16);
+static_assert(sizeof(SnapshotProperty) == 24);
+static_assert(sizeof(SnapshotMethod) == 40);
+static_assert(sizeof(SnapshotParameter) == 16);
+
+#endif
+
+#endif //ZYGISK_IL2CPPDUMPER_SNAPSHOT_FORMAT_H
@@ -0,0 +1,431 @@
+//
+// Packages to dump, read from targets.txt in the module dir.
+//
+
+#include "targets.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log.h"
+
+static constexpr uint64_t kFnvBasis = 0xcbf29ce484222325;
+static constexpr uint64_t kFnvPrime = 0x100000001b3;
+
+uint64_t fnv1a(std::string_view str) {
+    uint64_t hash = kFnvBasis;
+    for (unsigned char c: str) {
+        hash = (hash ^ c) * kFnvPrime;
+    }
+    return hash;
+}
+
+bool glob_match(std::string_view pattern, std::string_view str) {
+    size_t p = 0;
+    size_t s = 0;
+    // position after the last * and the character it is currently matched up to
+    size_t star = std::string_view::npos;
+    size_t starMatch = 0;
+    while (s < str.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+            ++p;
+            ++s;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = ++p;
+            starMatch = s;
+        } else if (star != std::string_view::npos) {
+            p = star;
+            s = ++starMatch;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+static std::string_view next_token(std::string_view &line) {
+    auto start = line.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        line = {};
+        return {};
+    }
+    line.remove_prefix(start);
+    auto end = line.find_first_of(" \t\r");
+    auto token = line.substr(0, end);
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+    return token;
+}
+
+static bool parse_option(std::string_view token, TargetOptions &options) {
+    auto eq = token.find('=');
+    if (eq == std::string_view::npos) {
+        return false;
+    }
+    auto key = token.substr(0, eq);
+    auto value = token.substr(eq + 1);
+    uint32_t number;
+    auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+        return false;
+    }
+    if (key == "threads") {
+        options.threads = number;
+    } else if (key == "snapshot") {
+        options.snapshot = number != 0;
+    } else if (key == "metadata") {
+        options.metadata = number != 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool TargetView::open(const void *data, size_t size) {
+    header_ = nullptr;
+    auto header = (const TargetFileHeader *) data;
+    if (size < sizeof(TargetFileHeader) || header->magic != TargetFileMagic ||
+        header->version != TargetFileVersion) {
+        return false;
+    }
+    uint64_t entries = (uint64_t) header->exact_count + header->glob_count;
+    if ((header->slot_count & (header->slot_count - 1)) || entries >= kGlobSlot) {
+        return false;
+    }
+    uint64_t slotsOffset = sizeof(TargetFileHeader);
+    uint64_t entriesOffset = slotsOffset + (uint64_t) header->slot_count * sizeof(Slot);
+    uint64_t lengthsOffset = entriesOffset + entries * sizeof(Entry);
+    uint64_t textOffset = lengthsOffset + (uint64_t) header->length_count * sizeof(uint32_t);
+    if (textOffset + header->text_size > size) {
+        return false;
+    }
+    auto base = (const char *) data;
+    header_ = header;
+    slots_ = (const Slot *) (base + slotsOffset);
+    entries_ = (const Entry *) (base + entriesOffset);
+    lengths_ = (const uint32_t *) (base + lengthsOffset);
+    text_ = base + textOffset;
+    return true;
+}
+
+const TargetView::Entry *TargetView::entry(uint32_t value) const {
+    uint64_t index;
+    if (value & kGlobSlot) {
+        auto glob = value & ~kGlobSlot;
+        if (!glob || glob > header_->glob_count) {
+            return nullptr;
+        }
+        index = (uint64_t) header_->exact_count + glob - 1;
+    } else {
+        if (!value || value > header_->exact_count) {
+            return nullptr;
+        }
+        index = value - 1;
+    }
+    auto entry = &entries_[index];
+    if ((uint64_t) entry->name + entry->name_size > header_->text_size ||
+        entry->prefix > entry->name_size) {
+        return nullptr;
+    }
+    return entry;
+}
+
+const TargetView::Entry *TargetView::find_glob(uint64_t hash, std::string_view prefix) const {
+    uint32_t mask = header_->slot_count - 1;
+    auto index = (uint32_t) hash & mask;
+    for (uint32_t probes = 0; probes <= mask; ++probes, index = (index + 1) & mask) {
+        auto &slot = slots_[index];
+        if (!slot.entry) {
+            break;
+        }
+        if (slot.hash == hash && (slot.entry & kGlobSlot)) {
+            auto glob = entry(slot.entry);
+            if (glob && name(*glob).substr(0, glob->prefix) == prefix) {
+                return glob;
+            }
+        }
+    }
+    return nullptr;
+}
+
+const TargetOptions *TargetView::find(std::string_view package) const {
+    if (empty()) {
+        return nullptr;
+    }
+    uint32_t mask = header_->slot_count - 1;
+    auto hash = fnv1a(package);
+    auto index = (uint32_t) hash & mask;
+    for (uint32_t probes = 0; probes <= mask; ++probes, index = (index + 1) & mask) {
+        auto &slot = slots_[index];
+        if (!slot.entry) {
+            break;
+        }
+        if (slot.hash == hash && !(slot.entry & kGlobSlot)) {
+            auto exact = entry(slot.entry);
+            if (exact && name(*exact) == package) {
+                return &exact->options;
+            }
+        }
+    }
+    // fnv1a extends one character at a time, so each prefix length costs one probe
+    const Entry *match = nullptr;
+    hash = kFnvBasis;
+    size_t hashed = 0;
+    for (uint32_t i = 0; i < header_->length_count; ++i) {
+        auto length = lengths_[i];
+        if (length > package.size()) {
+            break;
+        }
+        for (; hashed < length; ++hashed) {
+            hash = (hash ^ (unsigned char) package[hashed]) * kFnvPrime;
+        }
+        //多个glob匹配时以文件中最先出现的为准, 链表按文件顺序只向后走
+        for (auto glob = find_glob(hash, package.substr(0, length));
+             glob && (!match || glob < match);) {
+            if (glob_match(name(*glob), package)) {
+                match = glob;
+                break;
+            }
+            auto next = entry(kGlobSlot | glob->next);
+            glob = next > glob ? next : nullptr;
+        }
+    }
+    return match ? &match->options : nullptr;
+}
+
+void TargetTable::parse(std::string_view text, const TargetOptions &defaults) {
+    struct Line {
+        std::string_view name;
+        TargetOptions options;
+        uint32_t prefix;
+    };
+    std::vector<Line> exact;
+    std::vector<Line> globs;
+    std::vector<uint32_t> lengths;
+    size_t textSize = 0;
+    std::string_view rest = text;
+    while (!rest.empty()) {
+        auto newline = rest.find('\n');
+        auto line = rest.substr(0, newline);
+        rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+        line = line.substr(0, line.find('#'));
+        auto name = next_token(line);
+        if (name.empty()) {
+            continue;
+        }
+        auto options = defaults;
+        for (auto token = next_token(line); !token.empty(); token = next_token(line)) {
+            if (!parse_option(token, options)) {
+                LOGW("targets: ignoring '%.*s' for %.*s", (int) token.size(), token.data(),
+                     (int) name.size(), name.data());
+            }
+        }
+        auto prefix = name.find_first_of("*?");
+        if (prefix != std::string_view::npos) {
+            globs.push_back({name, options, (uint32_t) prefix});
+            lengths.push_back((uint32_t) prefix);
+        } else {
+            exact.push_back({name, options, (uint32_t) name.size()});
+        }
+        textSize += name.size();
+    }
+    std::sort(lengths.begin(), lengths.end());
+    lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+    // at most half full, so a miss usually stops at the first empty slot
+    auto entryCount = exact.size() + globs.size();
+    uint32_t slotCount = 0;
+    if (entryCount) {
+        slotCount = 8;
+        while (slotCount < entryCount * 2) {
+            slotCount *= 2;
+        }
+    }
+    auto slotsOffset = sizeof(TargetFileHeader);
+    auto entriesOffset = slotsOffset + slotCount * sizeof(TargetView::Slot);
+    auto lengthsOffset = entriesOffset + entryCount * sizeof(TargetView::Entry);
+    auto textOffset = lengthsOffset + lengths.size() * sizeof(uint32_t);
+    auto size = textOffset + textSize;
+    image_.assign((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    auto base = (char *) image_.data();
+    auto header = (TargetFileHeader *) base;
+    header->magic = TargetFileMagic;
+    header->version = TargetFileVersion;
+    header->slot_count = slotCount;
+    header->exact_count = (uint32_t) exact.size();
+    header->glob_count = (uint32_t) globs.size();
+    header->length_count = (uint32_t) lengths.size();
+    header->text_size = (uint32_t) textSize;
+    auto slots = (TargetView::Slot *) (base + slotsOffset);
+    auto entries = (TargetView::Entry *) (base + entriesOffset);
+    memcpy(base + lengthsOffset, lengths.data(), lengths.size() * sizeof(uint32_t));
+    auto names = base + textOffset;
+    size_t textUsed = 0;
+    for (auto *lines: {&exact, &globs}) {
+        for (auto &line: *lines) {
+            *entries++ = {(uint32_t) textUsed, (uint32_t) line.name.size(), line.prefix, 0,
+                          line.options};
+            memcpy(names + textUsed, line.name.data(), line.name.size());
+            textUsed += line.name.size();
+        }
+    }
+    entries = (TargetView::Entry *) (base + entriesOffset);
+
+    constexpr uint32_t globSlot = TargetView::kGlobSlot;
+
+    auto key = [&](uint32_t value) {
+        auto &entry = entries[(value & globSlot ? exact.size() : 0) +
+                              (value & ~globSlot) - 1];
+        return std::string_view(names + entry.name, entry.prefix);
+    };
+    auto insert = [&](uint32_t value) {
+        auto hash = fnv1a(key(value));
+        for (auto index = hash & (slotCount - 1);; index = (index + 1) & (slotCount - 1)) {
+            auto &slot = slots[index];
+            if (!slot.entry) {
+                slot = {hash, value, 0};
+                return;
+            }
+            if (slot.hash == hash && (slot.entry & globSlot) == (value & globSlot) &&
+                key(slot.entry) == key(value)) {
+                //重复的包名以后出现的为准, 同一前缀的glob则接在链表头
+                if (value & globSlot) {
+                    entries[exact.size() + (value & ~globSlot) - 1].next =
+                            slot.entry & ~globSlot;
+                }
+                slot.entry = value;
+                return;
+            }
+        }
+    };
+    for (size_t i = 0; i < exact.size(); ++i) {
+        insert((uint32_t) i + 1);
+    }
+    //同一前缀的glob按文件顺序串成链表, 从后往前插入使链表头为最先出现的
+    for (size_t i = globs.size(); i-- > 0;) {
+        insert(globSlot | ((uint32_t) i + 1));
+    }
+    view_.open(base, size);
+}
+
+void TargetTable::set_source(const struct stat &source) {
+    if (image_.empty()) {
+        return;
+    }
+    auto header = (TargetFileHeader *) image_.data();
+    header->source_dev = source.st_dev;
+    header->source_ino = source.st_ino;
+    header->source_size = source.st_size;
+    header->source_mtime_sec = source.st_mtim.tv_sec;
+    header->source_mtime_nsec = source.st_mtim.tv_nsec;
+}
+
+bool load_targets(int module_dir, const TargetOptions &defaults, TargetTable &table) {
+    int fd = openat(module_dir, "targets.txt", O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat sb{};
+    std::string text;
+    if (fstat(fd, &sb) == 0) {
+        text.resize(sb.st_size);
+        size_t size = 0;
+        while (size < text.size()) {
+            auto n = read(fd, text.data() + size, text.size() - size);
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            size += n;
+        }
+        text.resize(size);
+    }
+    close(fd);
+    table.parse(text, defaults);
+    table.set_source(sb);
+    return true;
+}
+
+bool store_targets(int module_dir, const TargetTable &table) {
+    //临时文件名带上pid, 写完后rename保证spawn看到的总是完整的文件
+    char tmp_name[32];
+    snprintf(tmp_name, sizeof(tmp_name), "targets.bin.%d", (int) getpid());
+    int fd = openat(module_dir, tmp_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        LOGW("create %s failed: %s", tmp_name, strerror(errno));
+        return false;
+    }
+    fchmod(fd, 0644);
+    auto data = (const char *) table.data();
+    size_t size = table.data_size();
+    while (size > 0) {
+        auto n = write(fd, data, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        data += n;
+        size -= n;
+    }
+    close(fd);
+    if (size > 0 || renameat(module_dir, tmp_name, module_dir, "targets.bin") != 0) {
+        LOGW("write targets.bin failed: %s", strerror(errno));
+        unlinkat(module_dir, tmp_name, 0);
+        return false;
+    }
+    return true;
+}
+
+static bool same_source(const TargetFileHeader &header, const struct stat &source) {
+    return header.source_dev == (uint64_t) source.st_dev &&
+           header.source_ino == (uint64_t) source.st_ino &&
+           header.source_size == (uint64_t) source.st_size &&
+           header.source_mtime_sec == (uint64_t) source.st_mtim.tv_sec &&
+           header.source_mtime_nsec == (uint64_t) source.st_mtim.tv_nsec;
+}
+
+TargetProbe probe_targets(int module_dir, std::string_view package, TargetOptions &options) {
+    struct stat source{};
+    if (fstatat(module_dir, "targets.txt", &source, 0) != 0) {
+        return errno == ENOENT ? TargetProbe::NoTargets : TargetProbe::Unknown;
+    }
+    int fd = openat(module_dir, "targets.bin", O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return TargetProbe::Unknown;
+    }
+    struct stat sb{};
+    void *map = MAP_FAILED;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        map = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return TargetProbe::Unknown;
+    }
+    auto probe = TargetProbe::Unknown;
+    TargetView view;
+    if (view.open(map, sb.st_size) && same_source(*view.header(), source)) {
+        auto target = view.find(package);
+        if (view.empty()) {
+            probe = TargetProbe::NoTargets;
+        } else if (target) {
+            options = *target;
+            probe = TargetProbe::Hit;
+        } else {
+            probe = TargetProbe::Miss;
+        }
+    }
+    munmap(map, sb.st_size);
+    return probe;
+}
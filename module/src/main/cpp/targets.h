@@ -0,0 +1,168 @@
+//
+// Packages to dump, read from targets.txt in the module dir so a new game does not
+// need a rebuild. preAppSpecialize runs for every app spawn on the device, so exact
+// names live in an open-addressing table and a spawn that is not a target costs one
+// hash and, almost always, a single probe. Globs share the table, keyed by the literal
+// part before their first * or ?, so a miss adds one probe per distinct prefix length
+// and only globs whose prefix matches are tried.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_TARGETS_H
+#define ZYGISK_IL2CPPDUMPER_TARGETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+
+struct TargetOptions {
+    uint32_t threads;
+    uint32_t snapshot;
+    uint32_t metadata;
+};
+
+// targets.bin, targets.txt compiled by the companion into the module dir. A spawn maps
+// it and probes it in place, so deciding that an app is not a target needs neither a
+// parse nor a companion round trip. The header is followed by the slots, the exact
+// entries and then the globs, the glob prefix lengths and the names; TargetTable builds
+// the same image in memory.
+struct TargetFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    // targets.txt the table was compiled from, a spawn only trusts the file while
+    // these still match
+    uint64_t source_dev;
+    uint64_t source_ino;
+    uint64_t source_size;
+    uint64_t source_mtime_sec;
+    uint64_t source_mtime_nsec;
+    // a power of two, 0 for a targets.txt without entries
+    uint32_t slot_count;
+    uint32_t exact_count;
+    uint32_t glob_count;
+    uint32_t length_count;
+    uint32_t text_size;
+    uint32_t reserved;
+};
+
+#define TargetFileMagic 0x54475449 // "ITGT"
+#define TargetFileVersion 1
+
+// Lookups over a compiled table. open() only checks the header, find() bounds-checks
+// every slot and entry it reads, so a damaged targets.bin gives a miss instead of a
+// crash and a spawn does not pay for the entries it never touches.
+class TargetView {
+public:
+    // false if data is not a table of this version
+    bool open(const void *data, size_t size);
+
+    // nullptr if package is not a target
+    const TargetOptions *find(std::string_view package) const;
+
+    bool empty() const { return !header_ || !header_->slot_count; }
+
+    size_t size() const { return header_ ? header_->exact_count + header_->glob_count : 0; }
+
+    const TargetFileHeader *header() const { return header_; }
+
+private:
+    struct Slot {
+        uint64_t hash;
+        // index into the exact entries plus one, or kGlobSlot | index into the globs
+        // plus one for the first glob with this prefix, 0 marks an empty slot
+        uint32_t entry;
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        // offset and size of the name in the text
+        uint32_t name;
+        uint32_t name_size;
+        // globs: length of the literal prefix before the first * or ?, and the next
+        // glob with the same prefix plus one, in file order
+        uint32_t prefix;
+        uint32_t next;
+        TargetOptions options;
+    };
+
+    static constexpr uint32_t kGlobSlot = 0x80000000;
+
+    const Entry *entry(uint32_t index) const;
+
+    std::string_view name(const Entry &entry) const {
+        return {text_ + entry.name, entry.name_size};
+    }
+
+    const Entry *find_glob(uint64_t hash, std::string_view prefix) const;
+
+    const TargetFileHeader *header_ = nullptr;
+    const Slot *slots_ = nullptr;
+    const Entry *entries_ = nullptr;
+    // distinct glob prefix lengths, ascending
+    const uint32_t *lengths_ = nullptr;
+    const char *text_ = nullptr;
+
+    friend class TargetTable;
+};
+
+class TargetTable {
+public:
+    TargetTable() = default;
+
+    // the view points into the image owned by the table
+    TargetTable(const TargetTable &) = delete;
+
+    TargetTable &operator=(const TargetTable &) = delete;
+
+    // One target per line, a package name or a glob using * and ?, optionally followed
+    // by threads=N, snapshot=0|1 and metadata=0|1. Missing options come from defaults,
+    // # starts a comment. Duplicate names keep the last line, of several matching globs
+    // the first one in the file wins, and an exact name always beats a glob.
+    void parse(std::string_view text, const TargetOptions &defaults);
+
+    // stamps the image with the targets.txt it was read from
+    void set_source(const struct stat &source);
+
+    // nullptr if package is not a target
+    const TargetOptions *find(std::string_view package) const { return view_.find(package); }
+
+    bool empty() const { return view_.size() == 0; }
+
+    size_t size() const { return view_.size(); }
+
+    const void *data() const { return image_.data(); }
+
+    size_t data_size() const { return image_.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> image_;
+    TargetView view_;
+};
+
+uint64_t fnv1a(std::string_view str);
+
+bool glob_match(std::string_view pattern, std::string_view str);
+
+// false if the module dir has no targets.txt
+bool load_targets(int module_dir, const TargetOptions &defaults, TargetTable &table);
+
+// Writes the table to targets.bin in the module dir, through a temp file so that a
+// spawn never maps a partial one
+bool store_targets(int module_dir, const TargetTable &table);
+
+enum class TargetProbe {
+    // targets.bin is missing, damaged or older than targets.txt
+    Unknown,
+    // there is no targets.txt, or it has no entries
+    NoTargets,
+    Miss,
+    Hit,
+};
+
+// What a spawn does before asking the companion: one stat of targets.txt, then
+// targets.bin mapped and probed once. options is set for a hit.
+TargetProbe probe_targets(int module_dir, std::string_view package, TargetOptions &options);
+
+#endif //ZYGISK_IL2CPPDUMPER_TARGETS_H
@@ -0,0 +1,298 @@
+//
+// Per-dump memo of type names, so each class name is fetched from the runtime once.
+//
+
+#include "type_name_cache.h"
+#include <cstring>
+#include "il2cpp_api.h"
+
+namespace {
+
+constexpr unsigned int kInitialBits = 10;
+
+}
+
+NameTable::NameTable() : slots_(1 << kInitialBits), shift_(64 - kInitialBits) {}
+
+size_t NameTable::slot_of(const void *key) const {
+    // fibonacci hashing, the low bits of a pointer are mostly alignment
+    return (size_t) (((uint64_t) (uintptr_t) key * 0x9e3779b97f4a7c15ull) >> shift_);
+}
+
+const std::string_view *NameTable::find(const void *key) const {
+    auto mask = slots_.size() - 1;
+    for (auto i = slot_of(key);; i = (i + 1) & mask) {
+        auto &slot = slots_[i];
+        if (slot.key == key) {
+            return &slot.name;
+        }
+        if (!slot.key) {
+            return nullptr;
+        }
+    }
+}
+
+void NameTable::insert(const void *key, std::string_view name) {
+    if ((size_ + 1) * 10 > slots_.size() * 7) {
+        grow();
+    }
+    auto mask = slots_.size() - 1;
+    auto i = slot_of(key);
+    while (slots_[i].key && slots_[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    if (!slots_[i].key) {
+        ++size_;
+    }
+    slots_[i] = {key, name};
+}
+
+void NameTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    --shift_;
+    size_ = 0;
+    for (auto &slot: old) {
+        if (slot.key) {
+            insert(slot.key, slot.name);
+        }
+    }
+}
+
+std::string_view primitive_name(int type) {
+    switch (type) {
+        case IL2CPP_TYPE_VOID:
+            return "void";
+        case IL2CPP_TYPE_BOOLEAN:
+            return "bool";
+        case IL2CPP_TYPE_CHAR:
+            return "char";
+        case IL2CPP_TYPE_I1:
+            return "sbyte";
+        case IL2CPP_TYPE_U1:
+            return "byte";
+        case IL2CPP_TYPE_I2:
+            return "short";
+        case IL2CPP_TYPE_U2:
+            return "ushort";
+        case IL2CPP_TYPE_I4:
+            return "int";
+        case IL2CPP_TYPE_U4:
+            return "uint";
+        case IL2CPP_TYPE_I8:
+            return "long";
+        case IL2CPP_TYPE_U8:
+            return "ulong";
+        case IL2CPP_TYPE_R4:
+            return "float";
+        case IL2CPP_TYPE_R8:
+            return "double";
+        case IL2CPP_TYPE_STRING:
+            return "string";
+        case IL2CPP_TYPE_I:
+            return "IntPtr";
+        case IL2CPP_TYPE_U:
+            return "UIntPtr";
+        case IL2CPP_TYPE_OBJECT:
+            return "object";
+        case IL2CPP_TYPE_TYPEDBYREF:
+            return "TypedReference";
+        default:
+            return {};
+    }
+}
+
+std::string_view strip_arity(std::string_view name) {
+    auto pos = name.find('`');
+    return pos == std::string_view::npos ? name : name.substr(0, pos);
+}
+
+namespace {
+
+std::string_view raw_class_name(Il2CppClass *klass) {
+    auto name = klass ? il2cpp_class_get_name(klass) : nullptr;
+    return name ? name : "";
+}
+
+}
+
+std::string_view TypeNameCache::class_name(Il2CppClass *klass) {
+    if (auto name = classes_.find(klass)) {
+        ++hits_;
+        return *name;
+    }
+    ++misses_;
+    return resolve_class(klass, 0);
+}
+
+std::string_view TypeNameCache::type_name(const Il2CppType *type) {
+    if (auto name = types_.find(type)) {
+        ++hits_;
+        return *name;
+    }
+    ++misses_;
+    return resolve_type(type, 0);
+}
+
+std::string_view TypeNameCache::declaration_name(Il2CppClass *klass) {
+    if (auto name = declarations_.find(klass)) {
+        return *name;
+    }
+    auto raw = raw_class_name(klass);
+    std::string_view name;
+    if (klass && il2cpp_class_is_generic(klass)) {
+        std::string out(strip_arity(raw));
+        append_generic_parameters(out, klass);
+        name = intern(out);
+    } else {
+        name = raw;
+    }
+    declarations_.insert(klass, name);
+    return name;
+}
+
+void TypeNameCache::append_outer_name(std::string &out, Il2CppClass *klass, int depth) {
+    if (depth > kMaxDepth) {
+        return;
+    }
+    //嵌套类型以外层类型名作前缀, 外层不带泛型参数
+    if (auto declaring = il2cpp_class_get_declaring_type(klass)) {
+        append_outer_name(out, declaring, depth + 1);
+        out.append(strip_arity(raw_class_name(declaring))).append(1, '.');
+    }
+}
+
+void TypeNameCache::append_generic_parameters(std::string &out, Il2CppClass *klass) {
+    // The runtime only exposes generic parameter names through the IL name of the
+    // definition, e.g. System.Collections.Generic.Dictionary`2<TKey,TValue>
+    auto full = il2cpp_type_get_name(il2cpp_class_get_type(klass));
+    if (!full) {
+        return;
+    }
+    std::string_view view(full);
+    auto raw = raw_class_name(klass);
+    auto pos = view.rfind(raw);
+    if (pos != std::string_view::npos) {
+        auto params = view.substr(pos + raw.size());
+        if (params.size() > 2 && params.front() == '<' && params.back() == '>') {
+            for (auto c: params) {
+                out.append(1, c);
+                if (c == ',') {
+                    out.append(1, ' ');
+                }
+            }
+        }
+    }
+    il2cpp_free(full);
+}
+
+std::string_view TypeNameCache::resolve_class(Il2CppClass *klass, int depth) {
+    if (auto name = classes_.find(klass)) {
+        return *name;
+    }
+    std::string_view name;
+    if (!klass) {
+        name = "";
+    } else if (!il2cpp_class_get_declaring_type(klass) && !il2cpp_class_is_generic(klass)) {
+        //类名由运行时持有, 无需复制
+        name = raw_class_name(klass);
+    } else {
+        std::string out;
+        append_outer_name(out, klass, depth);
+        out.append(declaration_name(klass));
+        name = intern(out);
+    }
+    classes_.insert(klass, name);
+    return name;
+}
+
+std::string_view TypeNameCache::resolve_type(const Il2CppType *type, int depth) {
+    if (auto name = types_.find(type)) {
+        return *name;
+    }
+    if (!type || depth > kMaxDepth) {
+        return "";
+    }
+    std::string_view name = primitive_name(type->type);
+    if (name.empty()) {
+        std::string out;
+        switch (type->type) {
+            case IL2CPP_TYPE_SZARRAY:
+                out.append(resolve_type(type->data.type, depth + 1)).append("[]");
+                break;
+            case IL2CPP_TYPE_ARRAY: {
+                auto array = type->data.array;
+                out.append(resolve_type(array->etype, depth + 1)).append(1, '[');
+                out.append(array->rank > 1 ? array->rank - 1 : 0, ',').append(1, ']');
+                break;
+            }
+            case IL2CPP_TYPE_PTR:
+                out.append(resolve_type(type->data.type, depth + 1)).append(1, '*');
+                break;
+            case IL2CPP_TYPE_GENERICINST: {
+                auto klass = il2cpp_class_from_type(type);
+                append_outer_name(out, klass, depth);
+                out.append(strip_arity(raw_class_name(klass)));
+                auto inst = type->data.generic_class->context.class_inst;
+                if (inst && inst->type_argc > 0) {
+                    out.append(1, '<');
+                    for (uint32_t i = 0; i < inst->type_argc; ++i) {
+                        if (i > 0) {
+                            out.append(", ");
+                        }
+                        out.append(resolve_type(inst->type_argv[i], depth + 1));
+                    }
+                    out.append(1, '>');
+                }
+                break;
+            }
+            case IL2CPP_TYPE_VAR:
+            case IL2CPP_TYPE_MVAR: {
+                //泛型参数名只能通过il2cpp_type_get_name获取
+                if (auto param = il2cpp_type_get_name(type)) {
+                    out.append(param);
+                    il2cpp_free(param);
+                } else {
+                    out.append(raw_class_name(il2cpp_class_from_type(type)));
+                }
+                break;
+            }
+            default:
+                name = resolve_class(il2cpp_class_from_type(type), depth + 1);
+                break;
+        }
+        if (name.empty()) {
+            name = intern(out);
+        }
+    }
+    types_.insert(type, name);
+    return name;
+}
+
+std::string_view NameArena::intern(std::string_view name) {
+    if (name.empty()) {
+        //空名称无需占用块, 此时可能还没有块
+        return {};
+    }
+    if (name.size() > kBlockSize / 4) {
+        // oversized names get a block of their own, inserted below the one being filled
+        auto block = new char[name.size()];
+        memcpy(block, name.data(), name.size());
+        blocks_.emplace(blocks_.empty() ? blocks_.end() : blocks_.end() - 1, block);
+        bytes_ += name.size();
+        return {block, name.size()};
+    }
+    if (kBlockSize - used_ < name.size()) {
+        blocks_.emplace_back(new char[kBlockSize]);
+        used_ = 0;
+        bytes_ += kBlockSize;
+    }
+    auto data = blocks_.back().get() + used_;
+    memcpy(data, name.data(), name.size());
+    used_ += name.size();
+    return {data, name.size()};
+}
+
+size_t TypeNameCache::memory() const {
+    return classes_.memory() + types_.memory() + arena_.memory();
+}
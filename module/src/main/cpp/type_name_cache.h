@@ -0,0 +1,107 @@
+//
+// Per-dump C# type name resolver. Every Il2CppType and Il2CppClass is resolved
+// once, generic instances, arrays, pointers and nested types included.
+//
+
+#ifndef ZYGISK_IL2CPPDUMPER_TYPE_NAME_CACHE_H
+#define ZYGISK_IL2CPPDUMPER_TYPE_NAME_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "il2cpp-class.h"
+
+// C# keyword of a primitive Il2CppTypeEnum, empty for every other type
+std::string_view primitive_name(int type);
+
+// List`1 -> List
+std::string_view strip_arity(std::string_view name);
+
+// Open-addressing pointer -> name map with linear probing.
+class NameTable {
+public:
+    NameTable();
+
+    // nullptr when key is missing
+    const std::string_view *find(const void *key) const;
+
+    void insert(const void *key, std::string_view name);
+
+    size_t size() const { return size_; }
+
+    size_t memory() const { return slots_.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        const void *key;
+        std::string_view name;
+    };
+
+    size_t slot_of(const void *key) const;
+
+    void grow();
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+    unsigned int shift_;
+};
+
+// Append-only storage for resolved names, freed as a whole with the cache.
+class NameArena {
+public:
+    std::string_view intern(std::string_view name);
+
+    size_t memory() const { return bytes_; }
+
+private:
+    static constexpr size_t kBlockSize = 16 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t used_ = kBlockSize;
+    size_t bytes_ = 0;
+};
+
+class TypeNameCache {
+public:
+    // name used when referring to the class, e.g. Dictionary.KeyCollection<TKey, TValue>
+    std::string_view class_name(Il2CppClass *klass);
+
+    // name used in the class declaration itself, e.g. KeyCollection<TKey, TValue>
+    std::string_view declaration_name(Il2CppClass *klass);
+
+    // full C# name, e.g. List<int>[], ref modifiers are left to the caller
+    std::string_view type_name(const Il2CppType *type);
+
+    // copies name into storage owned by the cache
+    std::string_view intern(std::string_view name) { return arena_.intern(name); }
+
+    size_t hits() const { return hits_; }
+
+    size_t misses() const { return misses_; }
+
+    size_t memory() const;
+
+private:
+    // deeper nesting than this only shows up in corrupted metadata
+    static constexpr int kMaxDepth = 32;
+
+    std::string_view resolve_class(Il2CppClass *klass, int depth);
+
+    std::string_view resolve_type(const Il2CppType *type, int depth);
+
+    void append_outer_name(std::string &out, Il2CppClass *klass, int depth);
+
+    void append_generic_parameters(std::string &out, Il2CppClass *klass);
+
+    NameTable classes_;
+    NameTable declarations_;
+    NameTable types_;
+    NameArena arena_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+#endif //ZYGISK_IL2CPPDUMPER_TYPE_NAME_CACHE_H
@@ -35,6 +35,7 @@
 #include <dlfcn.h>
 #include <link.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,17 +63,51 @@ typedef struct {
 //
 #define XDL_TRY_FORCE_LOAD    0x01
 #define XDL_ALWAYS_FORCE_LOAD 0x02
+#define XDL_MMAP_SYMTAB       0x04  // map .symtab & .strtab from the file instead of copying them
+#define XDL_NO_CACHE          0x08  // private handle instead of the shared, refcounted one
+
+//
+// Without XDL_NO_CACHE or XDL_MMAP_SYMTAB, handles are shared: xdl_close() drops a reference
+// and the .symtab loaded by xdl_dsym() / xdl_addr() stays in memory until the library
+// unloads. Open with XDL_NO_CACHE to have xdl_close() free it.
+//
 void *xdl_open(const char *filename, int flags);
 void *xdl_close(void *handle);
 void *xdl_sym(void *handle, const char *symbol, size_t *symbol_size);
 void *xdl_dsym(void *handle, const char *symbol, size_t *symbol_size);
 
+//
+// Directory where xdl_dsym() and xdl_addr() keep the .symtab decompressed from
+// .gnu_debugdata, keyed by library pathname and build-id (or size and mtime). Later
+// loads in any process map the file instead of running LZMA again. NULL turns it off.
+//
+int xdl_set_debugdata_cache(const char *dir);
+
+//
+// Resolve many .dynsym symbols at once. gnu_hash must be the GNU hash of name (it can be
+// computed at compile time), addr is set to the symbol address or NULL.
+// Returns the number of symbols found.
+//
+typedef struct {
+  const char *name;
+  uint32_t gnu_hash;
+  void *addr;
+} xdl_sym_req_t;
+size_t xdl_sym_batch(void *handle, xdl_sym_req_t *reqs, size_t reqs_cnt);
+
 //
 // Enhanced dladdr().
 //
 int xdl_addr(void *addr, xdl_info_t *info, void **cache);
 void xdl_addr_clean(void **cache);
 
+//
+// xdl_addr() for many addresses, e.g. a crash stack or sampled PCs. infos[i] is filled for
+// addrs[i], the handles go to the same cache. Returns the number of addresses that resolved
+// to a symbol.
+//
+size_t xdl_addr_batch(void *const *addrs, xdl_info_t *infos, size_t cnt, void **cache);
+
 //
 // Enhanced dl_iterate_phdr().
 //
@@ -83,6 +118,14 @@ int xdl_iterate_phdr(int (*callback)(struct dl_phdr_info *, size_t, void *), voi
 // Custom dlinfo().
 //
 #define XDL_DI_DLINFO 1  // type of info: xdl_info_t
+#define XDL_DI_SYMTAB 2  // type of info: xdl_symtab_info_t
+typedef struct {
+  size_t symtab_cnt;        // entries in .symtab, 0 until xdl_dsym() loaded it
+  size_t symtab_bytes;      // heap holding .symtab and .strtab
+  size_t symtab_map_bytes;  // file mapping holding them instead, with XDL_MMAP_SYMTAB
+  size_t index_cnt;         // symbols in the xdl_dsym() hash index
+  size_t index_bytes;       // heap used by the index
+} xdl_symtab_info_t;
 int xdl_info(void *handle, int request, void *info);
 
 #ifdef __cplusplus
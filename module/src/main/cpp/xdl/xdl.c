@@ -70,6 +70,17 @@ typedef struct xdl {
   struct xdl *next;     // to next xdl obj for cache in xdl_addr()
   void *linker_handle;  // hold handle returned by xdl_linker_load()
 
+  // for the handle cache of xdl_open(), see xdl_handles
+  bool cacheable;          // found through dl_iterate_phdr(), unloads show in its counters
+  bool cached;             // in xdl_handles or dropped from it while still referenced
+  bool cache_stale;        // library unloaded, freed by the last xdl_close()
+  uint32_t cache_refs;     // xdl_open() calls not yet closed
+  struct xdl *cache_next;  // to next xdl obj in xdl_handles
+
+  // the lazy parts below are built once under this lock, cached handles are shared
+  // between threads (all-zero is PTHREAD_MUTEX_INITIALIZER on bionic and glibc)
+  pthread_mutex_t load_lock;
+
   //
   // (1) for searching symbols from .dynsym
   //
@@ -95,6 +106,7 @@ typedef struct xdl {
     const ElfW(Addr) *bloom;
     uint32_t bloom_cnt;
     uint32_t bloom_shift;
+    uint32_t syms_cnt;  // index after the last hashed symbol in .dynsym
   } gnu_hash;
 
   //
@@ -102,17 +114,58 @@ typedef struct xdl {
   //
 
   bool symtab_try_load;
+  bool symtab_try_mmap;  // XDL_MMAP_SYMTAB
   uintptr_t base;
 
   ElfW(Sym) *symtab;  // .symtab
   size_t symtab_cnt;
   char *strtab;  // .strtab
   size_t strtab_sz;
+  void *symtab_map;  // read-only file mapping holding both, NULL when they are on the heap
+  size_t symtab_map_sz;
+
+  // open addressing index over the exported .symtab entries, built on the first
+  // xdl_dsym(). NULL slots falls back to the linear scan.
+  struct {
+    bool try_build;
+    struct xdl_symtab_slot *slots;
+    size_t slots_cnt;  // power of two
+    size_t syms_cnt;
+  } symtab_index;
+
+  //
+  // (3) for xdl_addr(), one index per table, built on the first reverse lookup in it
+  //
+
+  struct xdl_addr_index {
+    bool try_build;
+    struct xdl_addr_slot *slots;  // sorted by start, NULL falls back to the linear scan
+    size_t slots_cnt;
+  } dynsym_addr_index, symtab_addr_index;
 } xdl_t;
 
+typedef struct xdl_symtab_slot {
+  uint32_t hash;  // GNU hash of the name
+  uint32_t sym;   // index into .symtab, 0 (STN_UNDEF) marks an empty slot
+} xdl_symtab_slot_t;
+
+typedef struct xdl_addr_slot {
+  uintptr_t start;    // st_value
+  uintptr_t size;     // st_size, never 0
+  uintptr_t end_max;  // highest start + size of this and all earlier slots
+  uint32_t sym;       // index into .dynsym or .symtab
+} xdl_addr_slot_t;
+
 #pragma clang diagnostic pop
 
 // load from memory
+// bionic leaves the d_ptr values in .dynamic as offsets, glibc relocates them in place
+#ifdef __GLIBC__
+#define XDL_DYN_PTR(self, d_ptr) ((d_ptr) >= (self)->load_bias ? (d_ptr) : (self)->load_bias + (d_ptr))
+#else
+#define XDL_DYN_PTR(self, d_ptr) ((self)->load_bias + (d_ptr))
+#endif
+
 static int xdl_dynsym_load(xdl_t *self) {
   // find the dynamic segment
   ElfW(Dyn) *dynamic = NULL;
@@ -129,23 +182,23 @@ static int xdl_dynsym_load(xdl_t *self) {
   for (ElfW(Dyn) *entry = dynamic; entry && entry->d_tag != DT_NULL; entry++) {
     switch (entry->d_tag) {
       case DT_SYMTAB:  //.dynsym
-        self->dynsym = (ElfW(Sym) *)(self->load_bias + entry->d_un.d_ptr);
+        self->dynsym = (ElfW(Sym) *)(XDL_DYN_PTR(self, entry->d_un.d_ptr));
         break;
       case DT_STRTAB:  //.dynstr
-        self->dynstr = (const char *)(self->load_bias + entry->d_un.d_ptr);
+        self->dynstr = (const char *)(XDL_DYN_PTR(self, entry->d_un.d_ptr));
         break;
       case DT_HASH:  //.hash
-        self->sysv_hash.buckets_cnt = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[0];
-        self->sysv_hash.chains_cnt = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[1];
-        self->sysv_hash.buckets = &(((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[2]);
+        self->sysv_hash.buckets_cnt = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[0];
+        self->sysv_hash.chains_cnt = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[1];
+        self->sysv_hash.buckets = &(((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[2]);
         self->sysv_hash.chains = &(self->sysv_hash.buckets[self->sysv_hash.buckets_cnt]);
         break;
       case DT_GNU_HASH:  //.gnu.hash
-        self->gnu_hash.buckets_cnt = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[0];
-        self->gnu_hash.symoffset = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[1];
-        self->gnu_hash.bloom_cnt = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[2];
-        self->gnu_hash.bloom_shift = ((const uint32_t *)(self->load_bias + entry->d_un.d_ptr))[3];
-        self->gnu_hash.bloom = (const ElfW(Addr) *)(self->load_bias + entry->d_un.d_ptr + 16);
+        self->gnu_hash.buckets_cnt = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[0];
+        self->gnu_hash.symoffset = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[1];
+        self->gnu_hash.bloom_cnt = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[2];
+        self->gnu_hash.bloom_shift = ((const uint32_t *)(XDL_DYN_PTR(self, entry->d_un.d_ptr)))[3];
+        self->gnu_hash.bloom = (const ElfW(Addr) *)(XDL_DYN_PTR(self, entry->d_un.d_ptr) + 16);
         self->gnu_hash.buckets = (const uint32_t *)(&(self->gnu_hash.bloom[self->gnu_hash.bloom_cnt]));
         self->gnu_hash.chains = (const uint32_t *)(&(self->gnu_hash.buckets[self->gnu_hash.buckets_cnt]));
         break;
@@ -163,6 +216,20 @@ static int xdl_dynsym_load(xdl_t *self) {
     return -1;
   }
 
+  // the last chain starts at the largest bucket and ends with the lowest bit set
+  if (self->gnu_hash.buckets_cnt > 0) {
+    uint32_t last = 0;
+    for (size_t i = 0; i < self->gnu_hash.buckets_cnt; i++) {
+      if (self->gnu_hash.buckets[i] > last) last = self->gnu_hash.buckets[i];
+    }
+    if (last >= self->gnu_hash.symoffset) {
+      while (0 == (self->gnu_hash.chains[last - self->gnu_hash.symoffset] & (uint32_t)1)) last++;
+      self->gnu_hash.syms_cnt = last + 1;
+    } else {
+      self->gnu_hash.syms_cnt = self->gnu_hash.symoffset;
+    }
+  }
+
   return 0;
 }
 
@@ -220,6 +287,181 @@ static void *xdl_get_memory_by_section(void *mem, size_t mem_sz, ElfW(Shdr) *shd
   return xdl_get_memory(mem, mem_sz, (size_t)shdr->sh_offset, shdr->sh_size);
 }
 
+// map .symtab & .strtab straight from the file, only the pages lookups touch become resident
+static int xdl_symtab_map(xdl_t *self, int file_fd, size_t file_sz, ElfW(Shdr) *shdr_symtab,
+                          ElfW(Shdr) *shdr_strtab) {
+  size_t symtab_off = (size_t)shdr_symtab->sh_offset, strtab_off = (size_t)shdr_strtab->sh_offset;
+  if (0 == shdr_symtab->sh_size || 0 == shdr_strtab->sh_size) return -1;
+  if (symtab_off >= file_sz || shdr_symtab->sh_size > file_sz - symtab_off) return -1;
+  if (strtab_off >= file_sz || shdr_strtab->sh_size > file_sz - strtab_off) return -1;
+  if (0 != symtab_off % sizeof(ElfW(Addr))) return -1;
+
+  size_t page_sz = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = (symtab_off < strtab_off ? symtab_off : strtab_off) & ~(page_sz - 1);
+  size_t symtab_end = symtab_off + shdr_symtab->sh_size, strtab_end = strtab_off + shdr_strtab->sh_size;
+  size_t end = symtab_end > strtab_end ? symtab_end : strtab_end;
+
+  void *map = mmap(NULL, end - start, PROT_READ, MAP_PRIVATE, file_fd, (off_t)start);
+  if (MAP_FAILED == map) return -1;
+
+  self->symtab = (ElfW(Sym) *)((uintptr_t)map + (symtab_off - start));
+  self->symtab_cnt = shdr_symtab->sh_size / shdr_symtab->sh_entsize;
+  self->strtab = (char *)((uintptr_t)map + (strtab_off - start));
+  self->strtab_sz = shdr_strtab->sh_size;
+  self->symtab_map = map;
+  self->symtab_map_sz = end - start;
+  return 0;
+}
+
+//
+// cache of decompressed .gnu_debugdata, one file per library:
+// header | key | .symtab (aligned) | .strtab, mapped back like XDL_MMAP_SYMTAB
+//
+
+#define XDL_CACHE_MAGIC   "XDLSYMT1"
+#define XDL_CACHE_KEY_MAX 1536
+
+typedef struct {
+  char magic[8];
+  uint32_t sym_size;  // sizeof(ElfW(Sym)), 32 and 64-bit processes may share the dir
+  uint32_t key_len;
+  uint64_t symtab_off;
+  uint64_t symtab_cnt;
+  uint64_t strtab_off;
+  uint64_t strtab_sz;
+} xdl_cache_header_t;
+
+static char *xdl_cache_dir = NULL;
+
+int xdl_set_debugdata_cache(const char *dir) {
+  char *copy = NULL;
+  if (NULL != dir && NULL == (copy = strdup(dir))) return -1;
+  // a replaced dir may still be read by a concurrent lookup, keep it
+  __atomic_store_n(&xdl_cache_dir, copy, __ATOMIC_RELEASE);
+  return 0;
+}
+
+// pathname plus the build-id note of the loaded image, or file size and mtime without one
+static size_t xdl_cache_key(xdl_t *self, int file_fd, char *key, size_t key_sz) {
+  int n = snprintf(key, key_sz, "%s\n", self->pathname);
+  if (n < 0 || (size_t)n >= key_sz) return 0;
+  size_t len = (size_t)n;
+
+  for (size_t i = 0; i < self->dlpi_phnum; i++) {
+    const ElfW(Phdr) *phdr = &(self->dlpi_phdr[i]);
+    if (PT_NOTE != phdr->p_type) continue;
+    uintptr_t note = self->load_bias + phdr->p_vaddr, note_end = note + phdr->p_memsz;
+    while (note + sizeof(ElfW(Nhdr)) <= note_end) {
+      const ElfW(Nhdr) *nhdr = (const ElfW(Nhdr) *)note;
+      uintptr_t name = note + sizeof(ElfW(Nhdr));
+      uintptr_t desc = name + ((nhdr->n_namesz + 3) & ~3u);
+      note = desc + ((nhdr->n_descsz + 3) & ~3u);
+      if (note > note_end) break;
+      if (NT_GNU_BUILD_ID != nhdr->n_type || 4 != nhdr->n_namesz || 0 != memcmp((void *)name, "GNU", 4))
+        continue;
+      if (len + 9 + 2 * nhdr->n_descsz >= key_sz) return 0;
+      len += (size_t)snprintf(key + len, key_sz - len, "build-id ");
+      for (size_t j = 0; j < nhdr->n_descsz; j++)
+        len += (size_t)snprintf(key + len, key_sz - len, "%02x", ((const uint8_t *)desc)[j]);
+      return len;
+    }
+  }
+
+  struct stat st;
+  if (0 != fstat(file_fd, &st)) return 0;
+  n = snprintf(key + len, key_sz - len, "size %lld mtime %lld.%09ld", (long long)st.st_size,
+               (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+  if (n < 0 || (size_t)n >= key_sz - len) return 0;
+  return len + (size_t)n;
+}
+
+static int xdl_cache_pathname(const char *dir, xdl_t *self, char *buf, size_t buf_sz) {
+  // FNV-1a of the library pathname, a newer build of the library replaces the old entry
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const char *c = self->pathname; '\0' != *c; c++) h = (h ^ (uint8_t)*c) * 0x100000001b3ULL;
+  int n = snprintf(buf, buf_sz, "%s/%016" PRIx64 ".xdlsym", dir, h);
+  return (n < 0 || (size_t)n >= buf_sz) ? -1 : 0;
+}
+
+static int xdl_cache_load(xdl_t *self, const char *dir, const char *key, size_t key_len) {
+  char pathname[1024];
+  if (0 != xdl_cache_pathname(dir, self, pathname, sizeof(pathname))) return -1;
+  int fd = open(pathname, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (0 == fstat(fd, &st) && (size_t)st.st_size > sizeof(xdl_cache_header_t))
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == map) return -1;
+
+  size_t map_sz = (size_t)st.st_size;
+  const xdl_cache_header_t *hdr = (const xdl_cache_header_t *)map;
+  if (0 != memcmp(hdr->magic, XDL_CACHE_MAGIC, sizeof(hdr->magic)) || sizeof(ElfW(Sym)) != hdr->sym_size ||
+      key_len != hdr->key_len || map_sz - sizeof(xdl_cache_header_t) < key_len ||
+      0 != memcmp((const char *)(hdr + 1), key, key_len) || 0 == hdr->symtab_cnt || 0 == hdr->strtab_sz ||
+      0 != hdr->symtab_off % sizeof(ElfW(Addr)) || hdr->symtab_off > map_sz ||
+      hdr->symtab_cnt > (map_sz - hdr->symtab_off) / sizeof(ElfW(Sym)) || hdr->strtab_off > map_sz ||
+      hdr->strtab_sz > map_sz - hdr->strtab_off ||
+      '\0' != ((const char *)map)[hdr->strtab_off + hdr->strtab_sz - 1]) {
+    munmap(map, map_sz);
+    return -1;
+  }
+
+  self->symtab = (ElfW(Sym) *)((uintptr_t)map + hdr->symtab_off);
+  self->symtab_cnt = (size_t)hdr->symtab_cnt;
+  self->strtab = (char *)((uintptr_t)map + hdr->strtab_off);
+  self->strtab_sz = (size_t)hdr->strtab_sz;
+  self->symtab_map = map;
+  self->symtab_map_sz = map_sz;
+  return 0;
+}
+
+static int xdl_cache_write(int fd, const void *data, size_t len) {
+  for (const uint8_t *p = (const uint8_t *)data; len > 0;) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    ssize_t n = XDL_UTIL_TEMP_FAILURE_RETRY(write(fd, p, len));
+#pragma clang diagnostic pop
+    if (n <= 0) return -1;
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+// written to a temporary file and renamed, readers only ever see complete entries; the
+// temporary name is unique, so threads storing the same library never share a file
+static void xdl_cache_store(xdl_t *self, const char *dir, const char *key, size_t key_len) {
+  char pathname[1024], tmp_pathname[1040];
+  if (0 != xdl_cache_pathname(dir, self, pathname, sizeof(pathname))) return;
+  snprintf(tmp_pathname, sizeof(tmp_pathname), "%s.XXXXXX", pathname);
+  int fd = mkostemp(tmp_pathname, O_CLOEXEC);
+  if (fd < 0) return;
+  fchmod(fd, 0644);
+
+  size_t symtab_off = (sizeof(xdl_cache_header_t) + key_len + sizeof(ElfW(Addr)) - 1) &
+                      ~(sizeof(ElfW(Addr)) - 1);
+  xdl_cache_header_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, XDL_CACHE_MAGIC, sizeof(hdr.magic));
+  hdr.sym_size = sizeof(ElfW(Sym));
+  hdr.key_len = (uint32_t)key_len;
+  hdr.symtab_off = symtab_off;
+  hdr.symtab_cnt = self->symtab_cnt;
+  hdr.strtab_off = symtab_off + self->symtab_cnt * sizeof(ElfW(Sym));
+  hdr.strtab_sz = self->strtab_sz;
+  static const uint8_t zeros[sizeof(ElfW(Addr))] = {0};
+
+  int r = xdl_cache_write(fd, &hdr, sizeof(hdr));
+  if (0 == r) r = xdl_cache_write(fd, key, key_len);
+  if (0 == r) r = xdl_cache_write(fd, zeros, symtab_off - sizeof(hdr) - key_len);
+  if (0 == r) r = xdl_cache_write(fd, self->symtab, self->symtab_cnt * sizeof(ElfW(Sym)));
+  if (0 == r) r = xdl_cache_write(fd, self->strtab, self->strtab_sz);
+  if (0 != close(fd)) r = -1;
+  if (0 != r || 0 != rename(tmp_pathname, pathname)) unlink(tmp_pathname);
+}
+
 // load from disk and memory
 static int xdl_symtab_load_from_debugdata(xdl_t *self, int file_fd, size_t file_sz,
                                           ElfW(Shdr) *shdr_debugdata) {
@@ -227,6 +469,14 @@ static int xdl_symtab_load_from_debugdata(xdl_t *self, int file_fd, size_t file_
   ElfW(Shdr) *shdrs = NULL;
   int r = -1;
 
+  // a cached copy skips the decompression
+  char key[XDL_CACHE_KEY_MAX];
+  size_t key_len = 0;
+  const char *cache_dir = __atomic_load_n(&xdl_cache_dir, __ATOMIC_ACQUIRE);
+  if (NULL != cache_dir && 0 != (key_len = xdl_cache_key(self, file_fd, key, sizeof(key))) &&
+      0 == xdl_cache_load(self, cache_dir, key, key_len))
+    return 0;
+
   // get zipped .gnu_debugdata
   uint8_t *debugdata_zip = (uint8_t *)xdl_read_file_to_heap_by_section(file_fd, file_sz, shdr_debugdata);
   if (NULL == debugdata_zip) return -1;
@@ -283,6 +533,7 @@ end:
   free(debugdata_zip);
   if (NULL != debugdata) free(debugdata);
   if (NULL != shdrs) free(shdrs);
+  if (0 == r && 0 != key_len) xdl_cache_store(self, cache_dir, key, key_len);
   return r;
 }
 
@@ -350,6 +601,12 @@ static int xdl_symtab_load(xdl_t *self) {
       ElfW(Shdr) *shdr_strtab = shdrs + shdr->sh_link;
       if (SHT_STRTAB != shdr_strtab->sh_type) continue;
 
+      if (self->symtab_try_mmap && 0 == xdl_symtab_map(self, file_fd, file_sz, shdr, shdr_strtab)) {
+        // OK
+        r = 0;
+        break;
+      }
+
       // get .symtab & .strtab
       ElfW(Sym) *symtab = (ElfW(Sym) *)xdl_read_file_to_heap_by_section(file_fd, file_sz, shdr);
       if (NULL == symtab) continue;
@@ -423,6 +680,22 @@ static xdl_t *xdl_find_from_auxv(unsigned long type, const char *pathname) {
   return self;
 }
 
+static bool xdl_find_is_match(const char *filename, const char *pathname) {
+  if ('[' == filename[0]) {
+    return 0 == strcmp(pathname, filename);
+  } else if ('/' == filename[0]) {
+    if ('/' == pathname[0])
+      return 0 == strcmp(pathname, filename);
+    else
+      return xdl_util_ends_with(filename, pathname);
+  } else {
+    if ('/' == pathname[0])
+      return xdl_util_ends_with(pathname, filename);
+    else
+      return 0 == strcmp(pathname, filename);
+  }
+}
+
 static int xdl_find_iterate_cb(struct dl_phdr_info *info, size_t size, void *arg) {
   (void)size;
 
@@ -434,21 +707,7 @@ static int xdl_find_iterate_cb(struct dl_phdr_info *info, size_t size, void *arg
   if (0 == info->dlpi_addr || NULL == info->dlpi_name) return 0;
 
   // check pathname
-  if ('[' == filename[0]) {
-    if (0 != strcmp(info->dlpi_name, filename)) return 0;
-  } else if ('/' == filename[0]) {
-    if ('/' == info->dlpi_name[0]) {
-      if (0 != strcmp(info->dlpi_name, filename)) return 0;
-    } else {
-      if (!xdl_util_ends_with(filename, info->dlpi_name)) return 0;
-    }
-  } else {
-    if ('/' == info->dlpi_name[0]) {
-      if (!xdl_util_ends_with(info->dlpi_name, filename)) return 0;
-    } else {
-      if (0 != strcmp(info->dlpi_name, filename)) return 0;
-    }
-  }
+  if (!xdl_find_is_match(filename, info->dlpi_name)) return 0;
 
   // found the target ELF
   if (NULL == ((*self) = calloc(1, sizeof(xdl_t)))) return 1;  // return failed
@@ -462,6 +721,7 @@ static int xdl_find_iterate_cb(struct dl_phdr_info *info, size_t size, void *arg
   (*self)->dlpi_phnum = info->dlpi_phnum;
   (*self)->dynsym_try_load = false;
   (*self)->symtab_try_load = false;
+  (*self)->cacheable = true;
   return 1;  // return OK
 }
 
@@ -529,28 +789,153 @@ static void *xdl_open_try_force(const char *filename) {
   return (void *)self;
 }
 
+static void *xdl_free(xdl_t *self) {
+  if (NULL != self->pathname) free(self->pathname);
+  if (NULL != self->symtab_map) {
+    munmap(self->symtab_map, self->symtab_map_sz);
+  } else {
+    if (NULL != self->symtab) free(self->symtab);
+    if (NULL != self->strtab) free(self->strtab);
+  }
+  if (NULL != self->symtab_index.slots) free(self->symtab_index.slots);
+  if (NULL != self->dynsym_addr_index.slots) free(self->dynsym_addr_index.slots);
+  if (NULL != self->symtab_addr_index.slots) free(self->symtab_addr_index.slots);
+  pthread_mutex_destroy(&self->load_lock);
+
+  void *linker_handle = self->linker_handle;
+  free(self);
+  return linker_handle;
+}
+
+//
+// Handles returned by xdl_open() for libraries found through dl_iterate_phdr(), shared and
+// refcounted, so repeated opens skip the module walk and keep the loaded .dynsym and
+// .symtab. A handle stays cached after its last xdl_close() until its library unloads,
+// which shows up as a change of the loader's dlpi_subs, and so does the .symtab heap copy.
+// Without the counters (before Android R) nothing is cached. XDL_NO_CACHE and
+// XDL_MMAP_SYMTAB opens get a private handle that xdl_close() frees.
+//
+
+static struct {
+  pthread_mutex_t lock;
+  xdl_t *head;
+  unsigned long long adds;
+  unsigned long long subs;
+} xdl_handles = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static int xdl_handles_alive_cb(struct dl_phdr_info *info, size_t size, void *arg) {
+  (void)size, (void)arg;
+
+  if (NULL == info->dlpi_name) return 0;
+  for (xdl_t *self = xdl_handles.head; NULL != self; self = self->cache_next)
+    if (self->load_bias == info->dlpi_addr && self->dlpi_phdr == info->dlpi_phdr &&
+        0 == strcmp(self->pathname, info->dlpi_name))
+      self->cache_stale = false;
+  return 0;
+}
+
+// drop the handles of unloaded libraries, called with the lock held
+static bool xdl_handles_sync(void) {
+  unsigned long long adds, subs;
+  if (!xdl_iterate_get_counters(&adds, &subs)) return false;
+  if (subs != xdl_handles.subs && NULL != xdl_handles.head) {
+    for (xdl_t *self = xdl_handles.head; NULL != self; self = self->cache_next) self->cache_stale = true;
+    xdl_iterate_phdr(xdl_handles_alive_cb, NULL, XDL_DEFAULT);
+
+    xdl_t **link = &xdl_handles.head;
+    while (NULL != *link) {
+      xdl_t *self = *link;
+      if (!self->cache_stale) {
+        link = &self->cache_next;
+        continue;
+      }
+      *link = self->cache_next;
+      if (0 == self->cache_refs) xdl_free(self);
+    }
+  }
+  xdl_handles.adds = adds;
+  xdl_handles.subs = subs;
+  return true;
+}
+
+static xdl_t *xdl_handles_get(const char *filename) {
+  xdl_t *found = NULL;
+  pthread_mutex_lock(&xdl_handles.lock);
+  if (xdl_handles_sync()) {
+    for (xdl_t *self = xdl_handles.head; NULL != self; self = self->cache_next) {
+      if (xdl_find_is_match(filename, self->pathname)) {
+        self->cache_refs++;
+        found = self;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&xdl_handles.lock);
+  return found;
+}
+
+// self was found while the loader counters were adds / subs
+static xdl_t *xdl_handles_put(xdl_t *self, unsigned long long adds, unsigned long long subs) {
+  pthread_mutex_lock(&xdl_handles.lock);
+  if (!xdl_handles_sync() || adds != xdl_handles.adds || subs != xdl_handles.subs) {
+    // something was loaded or unloaded meanwhile, hand out self uncached
+    pthread_mutex_unlock(&xdl_handles.lock);
+    return self;
+  }
+
+  // opened under another name already
+  for (xdl_t *cached = xdl_handles.head; NULL != cached; cached = cached->cache_next) {
+    if (cached->load_bias == self->load_bias) {
+      cached->cache_refs++;
+      pthread_mutex_unlock(&xdl_handles.lock);
+      xdl_free(self);
+      return cached;
+    }
+  }
+
+  self->cached = true;
+  self->cache_refs = 1;
+  self->cache_next = xdl_handles.head;
+  xdl_handles.head = self;
+  pthread_mutex_unlock(&xdl_handles.lock);
+  return self;
+}
+
 void *xdl_open(const char *filename, int flags) {
   if (NULL == filename) return NULL;
 
-  if (flags & XDL_ALWAYS_FORCE_LOAD)
-    return xdl_open_always_force(filename);
-  else if (flags & XDL_TRY_FORCE_LOAD)
-    return xdl_open_try_force(filename);
-  else
-    return xdl_find(filename);
+  xdl_t *self = NULL;
+  if (flags & XDL_ALWAYS_FORCE_LOAD) {
+    self = (xdl_t *)xdl_open_always_force(filename);
+  } else if (flags & (XDL_NO_CACHE | XDL_MMAP_SYMTAB)) {
+    // a shared handle would switch every other holder to the mapping and keep it past xdl_close()
+    self = (xdl_t *)((flags & XDL_TRY_FORCE_LOAD) ? xdl_open_try_force(filename) : xdl_find(filename));
+  } else if (NULL == (self = xdl_handles_get(filename))) {
+    unsigned long long adds = 0, subs = 0;
+    bool has_counters = xdl_iterate_get_counters(&adds, &subs);
+    if (flags & XDL_TRY_FORCE_LOAD)
+      self = (xdl_t *)xdl_open_try_force(filename);
+    else
+      self = xdl_find(filename);
+    if (NULL != self && has_counters && self->cacheable && NULL == self->linker_handle)
+      self = xdl_handles_put(self, adds, subs);
+  }
+
+  if (NULL != self && (flags & XDL_MMAP_SYMTAB)) self->symtab_try_mmap = true;
+  return (void *)self;
 }
 
 void *xdl_close(void *handle) {
   if (NULL == handle) return NULL;
 
   xdl_t *self = (xdl_t *)handle;
-  if (NULL != self->pathname) free(self->pathname);
-  if (NULL != self->symtab) free(self->symtab);
-  if (NULL != self->strtab) free(self->strtab);
-
-  void *linker_handle = self->linker_handle;
-  free(self);
-  return linker_handle;
+  if (self->cached) {
+    pthread_mutex_lock(&xdl_handles.lock);
+    bool release = 0 == --self->cache_refs && self->cache_stale;
+    pthread_mutex_unlock(&xdl_handles.lock);
+    return release ? xdl_free(self) : NULL;
+  }
+  return xdl_free(self);
 }
 
 static uint32_t xdl_sysv_hash(const uint8_t *name) {
@@ -574,6 +959,89 @@ static uint32_t xdl_gnu_hash(const uint8_t *name) {
   return h;
 }
 
+// same as xdl_gnu_hash() for names in .strtab, which is not trusted to be terminated
+static uint32_t xdl_gnu_hash_n(const uint8_t *name, size_t len) {
+  uint32_t h = 5381;
+
+  for (size_t i = 0; i < len && name[i]; i++) {
+    h += (h << 5) + name[i];
+  }
+  return h;
+}
+
+static bool xdl_symtab_name_eq(xdl_t *self, ElfW(Sym) *sym, const char *symbol) {
+  return 0 == strncmp(self->strtab + sym->st_name, symbol, self->strtab_sz - sym->st_name);
+}
+
+static void xdl_symtab_index_build(xdl_t *self) {
+  size_t exported_cnt = 0;
+  for (size_t i = 0; i < self->symtab_cnt; i++) {
+    ElfW(Sym) *sym = self->symtab + i;
+    if (XDL_SYMTAB_IS_EXPORT_SYM(sym->st_shndx) && 0 != sym->st_name && sym->st_name < self->strtab_sz)
+      exported_cnt++;
+  }
+  if (0 == exported_cnt || self->symtab_cnt > UINT32_MAX) return;
+
+  // at most half full
+  size_t slots_cnt = 16;
+  while (slots_cnt < exported_cnt * 2) slots_cnt <<= 1;
+  xdl_symtab_slot_t *slots = calloc(slots_cnt, sizeof(xdl_symtab_slot_t));
+  if (NULL == slots) return;
+
+  size_t mask = slots_cnt - 1;
+  size_t indexed_cnt = 0;
+  for (size_t i = 0; i < self->symtab_cnt; i++) {
+    ElfW(Sym) *sym = self->symtab + i;
+    if (!XDL_SYMTAB_IS_EXPORT_SYM(sym->st_shndx) || 0 == sym->st_name || sym->st_name >= self->strtab_sz)
+      continue;
+    const char *name = self->strtab + sym->st_name;
+    uint32_t hash = xdl_gnu_hash_n((const uint8_t *)name, self->strtab_sz - sym->st_name);
+    size_t j = hash & mask;
+    for (; 0 != slots[j].sym; j = (j + 1) & mask) {
+      // keep the first of several symbols with one name, like the linear scan did
+      if (slots[j].hash == hash && xdl_symtab_name_eq(self, self->symtab + slots[j].sym, name)) break;
+    }
+    if (0 != slots[j].sym) continue;
+    slots[j].hash = hash;
+    slots[j].sym = (uint32_t)i;
+    indexed_cnt++;
+  }
+
+  self->symtab_index.slots = slots;
+  self->symtab_index.slots_cnt = slots_cnt;
+  self->symtab_index.syms_cnt = indexed_cnt;
+}
+
+static void xdl_dynsym_ensure(xdl_t *self) {
+  if (__atomic_load_n(&self->dynsym_try_load, __ATOMIC_ACQUIRE)) return;
+  pthread_mutex_lock(&self->load_lock);
+  if (!self->dynsym_try_load) {
+    (void)xdl_dynsym_load(self);
+    __atomic_store_n(&self->dynsym_try_load, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&self->load_lock);
+}
+
+static void xdl_symtab_ensure(xdl_t *self) {
+  if (__atomic_load_n(&self->symtab_try_load, __ATOMIC_ACQUIRE)) return;
+  pthread_mutex_lock(&self->load_lock);
+  if (!self->symtab_try_load) {
+    (void)xdl_symtab_load(self);
+    __atomic_store_n(&self->symtab_try_load, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&self->load_lock);
+}
+
+static void xdl_symtab_index_ensure(xdl_t *self) {
+  if (__atomic_load_n(&self->symtab_index.try_build, __ATOMIC_ACQUIRE)) return;
+  pthread_mutex_lock(&self->load_lock);
+  if (!self->symtab_index.try_build) {
+    xdl_symtab_index_build(self);
+    __atomic_store_n(&self->symtab_index.try_build, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&self->load_lock);
+}
+
 static ElfW(Sym) *xdl_dynsym_find_symbol_use_sysv_hash(xdl_t *self, const char *sym_name) {
   uint32_t hash = xdl_sysv_hash((const uint8_t *)sym_name);
 
@@ -587,9 +1055,8 @@ static ElfW(Sym) *xdl_dynsym_find_symbol_use_sysv_hash(xdl_t *self, const char *
   return NULL;
 }
 
-static ElfW(Sym) *xdl_dynsym_find_symbol_use_gnu_hash(xdl_t *self, const char *sym_name) {
-  uint32_t hash = xdl_gnu_hash((const uint8_t *)sym_name);
-
+static ElfW(Sym) *xdl_dynsym_find_symbol_use_gnu_hash(xdl_t *self, const char *sym_name,
+                                                       uint32_t hash) {
   static uint32_t elfclass_bits = sizeof(ElfW(Addr)) * 8;
   size_t word = self->gnu_hash.bloom[(hash / elfclass_bits) % self->gnu_hash.bloom_cnt];
   size_t mask = 0 | (size_t)1 << (hash % elfclass_bits) |
@@ -629,17 +1096,14 @@ void *xdl_sym(void *handle, const char *symbol, size_t *symbol_size) {
   xdl_t *self = (xdl_t *)handle;
 
   // load .dynsym only once
-  if (!self->dynsym_try_load) {
-    self->dynsym_try_load = true;
-    if (0 != xdl_dynsym_load(self)) return NULL;
-  }
+  xdl_dynsym_ensure(self);
 
   // find symbol
   if (NULL == self->dynsym) return NULL;
   ElfW(Sym) *sym = NULL;
   if (self->gnu_hash.buckets_cnt > 0) {
     // use GNU hash (.gnu.hash -> .dynsym -> .dynstr), O(x) + O(1) + O(1)
-    sym = xdl_dynsym_find_symbol_use_gnu_hash(self, symbol);
+    sym = xdl_dynsym_find_symbol_use_gnu_hash(self, symbol, xdl_gnu_hash((const uint8_t *)symbol));
   }
   if (NULL == sym && self->sysv_hash.buckets_cnt > 0) {
     // use SYSV hash (.hash -> .dynsym -> .dynstr), O(x) + O(1) + O(1)
@@ -651,6 +1115,74 @@ void *xdl_sym(void *handle, const char *symbol, size_t *symbol_size) {
   return (void *)(self->load_bias + sym->st_value);
 }
 
+// the request table for a pass over .gnu.hash stays on the stack up to this many slots
+#define XDL_SYM_BATCH_STACK_SLOTS 1024
+
+size_t xdl_sym_batch(void *handle, xdl_sym_req_t *reqs, size_t reqs_cnt) {
+  if (NULL == handle || NULL == reqs) return 0;
+  for (size_t i = 0; i < reqs_cnt; i++) reqs[i].addr = NULL;
+  if (0 == reqs_cnt) return 0;
+
+  xdl_t *self = (xdl_t *)handle;
+
+  // load .dynsym only once
+  xdl_dynsym_ensure(self);
+  if (NULL == self->dynsym) return 0;
+
+  size_t found = 0;
+  uint32_t exported_cnt = self->gnu_hash.syms_cnt - self->gnu_hash.symoffset;
+  size_t slots_cnt = 16;
+  while (slots_cnt < reqs_cnt * 2) slots_cnt <<= 1;
+
+  // SYSV only, or so many exports that probing each name beats reading every chain entry
+  if (0 == self->gnu_hash.buckets_cnt || exported_cnt / 8 > reqs_cnt) {
+    for (size_t i = 0; i < reqs_cnt; i++) {
+      ElfW(Sym) *sym = NULL;
+      if (self->gnu_hash.buckets_cnt > 0)
+        sym = xdl_dynsym_find_symbol_use_gnu_hash(self, reqs[i].name, reqs[i].gnu_hash);
+      if (NULL == sym && self->sysv_hash.buckets_cnt > 0)
+        sym = xdl_dynsym_find_symbol_use_sysv_hash(self, reqs[i].name);
+      if (NULL == sym || !XDL_DYNSYM_IS_EXPORT_SYM(sym->st_shndx)) continue;
+      reqs[i].addr = (void *)(self->load_bias + sym->st_value);
+      found++;
+    }
+    return found;
+  }
+
+  // requests in an open addressing table keyed by hash, entries are index + 1
+  uint32_t stack_slots[XDL_SYM_BATCH_STACK_SLOTS];
+  uint32_t *slots = stack_slots;
+  if (slots_cnt > XDL_SYM_BATCH_STACK_SLOTS) {
+    if (NULL == (slots = malloc(slots_cnt * sizeof(uint32_t)))) return 0;
+  }
+  memset(slots, 0, slots_cnt * sizeof(uint32_t));
+  size_t mask = slots_cnt - 1;
+  for (size_t i = 0; i < reqs_cnt; i++) {
+    size_t j = (reqs[i].gnu_hash >> 1) & mask;
+    while (0 != slots[j]) j = (j + 1) & mask;
+    slots[j] = (uint32_t)i + 1;
+  }
+
+  // chains[] holds the hash of every exported symbol in .dynsym order (the lowest bit only
+  // marks the end of a bucket), so one walk over it finds all names without hashing them
+  const uint32_t *chains = self->gnu_hash.chains;
+  for (uint32_t k = 0; k < exported_cnt && found < reqs_cnt; k++) {
+    uint32_t hash = chains[k] | (uint32_t)1;
+    for (size_t j = (hash >> 1) & mask; 0 != slots[j]; j = (j + 1) & mask) {
+      xdl_sym_req_t *req = &reqs[slots[j] - 1];
+      if ((req->gnu_hash | (uint32_t)1) != hash || NULL != req->addr) continue;
+      ElfW(Sym) *sym = self->dynsym + self->gnu_hash.symoffset + k;
+      if (!XDL_DYNSYM_IS_EXPORT_SYM(sym->st_shndx)) continue;
+      if (0 != strcmp(self->dynstr + sym->st_name, req->name)) continue;
+      req->addr = (void *)(self->load_bias + sym->st_value);
+      found++;
+    }
+  }
+
+  if (slots != stack_slots) free(slots);
+  return found;
+}
+
 void *xdl_dsym(void *handle, const char *symbol, size_t *symbol_size) {
   if (NULL == handle || NULL == symbol) return NULL;
   if (NULL != symbol_size) *symbol_size = 0;
@@ -658,13 +1190,24 @@ void *xdl_dsym(void *handle, const char *symbol, size_t *symbol_size) {
   xdl_t *self = (xdl_t *)handle;
 
   // load .symtab only once
-  if (!self->symtab_try_load) {
-    self->symtab_try_load = true;
-    if (0 != xdl_symtab_load(self)) return NULL;
-  }
+  xdl_symtab_ensure(self);
 
   // find symbol
   if (NULL == self->symtab) return NULL;
+  xdl_symtab_index_ensure(self);
+  if (NULL != self->symtab_index.slots) {
+    uint32_t hash = xdl_gnu_hash((const uint8_t *)symbol);
+    size_t mask = self->symtab_index.slots_cnt - 1;
+    for (size_t j = hash & mask; 0 != self->symtab_index.slots[j].sym; j = (j + 1) & mask) {
+      if (self->symtab_index.slots[j].hash != hash) continue;
+      ElfW(Sym) *sym = self->symtab + self->symtab_index.slots[j].sym;
+      if (!xdl_symtab_name_eq(self, sym, symbol)) continue;
+
+      if (NULL != symbol_size) *symbol_size = sym->st_size;
+      return (void *)(self->load_bias + sym->st_value);
+    }
+    return NULL;
+  }
   for (size_t i = 0; i < self->symtab_cnt; i++) {
     ElfW(Sym) *sym = self->symtab + i;
 
@@ -731,27 +1274,107 @@ static void *xdl_open_by_addr(void *addr) {
 
 static bool xdl_sym_is_match(ElfW(Sym) *sym, uintptr_t offset, bool is_symtab) {
   if (is_symtab) {
-    if (!XDL_SYMTAB_IS_EXPORT_SYM(sym->st_shndx)) false;
+    if (!XDL_SYMTAB_IS_EXPORT_SYM(sym->st_shndx)) return false;
   } else {
-    if (!XDL_DYNSYM_IS_EXPORT_SYM(sym->st_shndx)) false;
+    if (!XDL_DYNSYM_IS_EXPORT_SYM(sym->st_shndx)) return false;
   }
 
   return ELF_ST_TYPE(sym->st_info) != STT_TLS && offset >= sym->st_value &&
          offset < sym->st_value + sym->st_size;
 }
 
+static int xdl_addr_slot_cmp(const void *a, const void *b) {
+  const xdl_addr_slot_t *x = (const xdl_addr_slot_t *)a, *y = (const xdl_addr_slot_t *)b;
+  if (x->start != y->start) return x->start < y->start ? -1 : 1;
+  // same start: higher index first, so the backward walk meets the lowest index first
+  return x->sym > y->sym ? -1 : (x->sym < y->sym ? 1 : 0);
+}
+
+static void xdl_addr_index_build(struct xdl_addr_index *index, ElfW(Sym) *syms, size_t from, size_t to,
+                                 bool is_symtab) {
+  if (to <= from || to > UINT32_MAX) return;
+
+  size_t cnt = 0;
+  for (size_t i = from; i < to; i++)
+    if (xdl_sym_is_match(syms + i, syms[i].st_value, is_symtab)) cnt++;
+  if (0 == cnt) return;
+
+  xdl_addr_slot_t *slots = malloc(cnt * sizeof(xdl_addr_slot_t));
+  if (NULL == slots) return;
+  size_t j = 0;
+  for (size_t i = from; i < to; i++) {
+    ElfW(Sym) *sym = syms + i;
+    if (!xdl_sym_is_match(sym, sym->st_value, is_symtab)) continue;
+    slots[j].start = sym->st_value;
+    slots[j].size = sym->st_size;
+    slots[j].sym = (uint32_t)i;
+    j++;
+  }
+  qsort(slots, cnt, sizeof(xdl_addr_slot_t), xdl_addr_slot_cmp);
+
+  uintptr_t end_max = 0;
+  for (size_t i = 0; i < cnt; i++) {
+    uintptr_t end = slots[i].start + slots[i].size;
+    if (end > end_max) end_max = end;
+    slots[i].end_max = end_max;
+  }
+
+  index->slots = slots;
+  index->slots_cnt = cnt;
+}
+
+// the symbol with the highest start that contains offset, the lowest index among equal starts
+static ElfW(Sym) *xdl_addr_index_find(struct xdl_addr_index *index, ElfW(Sym) *syms, uintptr_t offset) {
+  xdl_addr_slot_t *slots = index->slots;
+
+  // number of slots with start <= offset
+  size_t lo = 0, hi = index->slots_cnt;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (slots[mid].start <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  // walk back over the slots that may still cover offset
+  for (size_t i = lo; i > 0 && slots[i - 1].end_max > offset; i--) {
+    if (offset < slots[i - 1].start + slots[i - 1].size) return syms + slots[i - 1].sym;
+  }
+  return NULL;
+}
+
+static void xdl_addr_index_ensure(xdl_t *self, bool is_symtab) {
+  struct xdl_addr_index *index = is_symtab ? &self->symtab_addr_index : &self->dynsym_addr_index;
+  if (__atomic_load_n(&index->try_build, __ATOMIC_ACQUIRE)) return;
+  pthread_mutex_lock(&self->load_lock);
+  if (!index->try_build) {
+    if (is_symtab)
+      xdl_addr_index_build(index, self->symtab, 0, self->symtab_cnt, true);
+    // index the same symbols the .dynsym scan visits
+    else if (self->gnu_hash.buckets_cnt > 0)
+      xdl_addr_index_build(index, self->dynsym, self->gnu_hash.symoffset, self->gnu_hash.syms_cnt, false);
+    else
+      xdl_addr_index_build(index, self->dynsym, 0, self->sysv_hash.chains_cnt, false);
+    __atomic_store_n(&index->try_build, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&self->load_lock);
+}
+
 static ElfW(Sym) *xdl_sym_by_addr(void *handle, void *addr) {
   xdl_t *self = (xdl_t *)handle;
 
   // load .dynsym only once
-  if (!self->dynsym_try_load) {
-    self->dynsym_try_load = true;
-    if (0 != xdl_dynsym_load(self)) return NULL;
-  }
+  xdl_dynsym_ensure(self);
 
   // find symbol
   if (NULL == self->dynsym) return NULL;
   uintptr_t offset = (uintptr_t)addr - self->load_bias;
+
+  xdl_addr_index_ensure(self, false);
+  if (NULL != self->dynsym_addr_index.slots)
+    return xdl_addr_index_find(&self->dynsym_addr_index, self->dynsym, offset);
+
   if (self->gnu_hash.buckets_cnt > 0) {
     const uint32_t *chains_all = self->gnu_hash.chains - self->gnu_hash.symoffset;
     for (size_t i = 0; i < self->gnu_hash.buckets_cnt; i++) {
@@ -776,14 +1399,16 @@ static ElfW(Sym) *xdl_dsym_by_addr(void *handle, void *addr) {
   xdl_t *self = (xdl_t *)handle;
 
   // load .symtab only once
-  if (!self->symtab_try_load) {
-    self->symtab_try_load = true;
-    if (0 != xdl_symtab_load(self)) return NULL;
-  }
+  xdl_symtab_ensure(self);
 
   // find symbol
   if (NULL == self->symtab) return NULL;
   uintptr_t offset = (uintptr_t)addr - self->load_bias;
+
+  xdl_addr_index_ensure(self, true);
+  if (NULL != self->symtab_addr_index.slots)
+    return xdl_addr_index_find(&self->symtab_addr_index, self->symtab, offset);
+
   for (size_t i = 0; i < self->symtab_cnt; i++) {
     ElfW(Sym) *sym = self->symtab + i;
     if (xdl_sym_is_match(sym, offset, true)) return sym;
@@ -792,11 +1417,7 @@ static ElfW(Sym) *xdl_dsym_by_addr(void *handle, void *addr) {
   return NULL;
 }
 
-int xdl_addr(void *addr, xdl_info_t *info, void **cache) {
-  if (NULL == addr || NULL == info || NULL == cache) return 0;
-
-  memset(info, 0, sizeof(Dl_info));
-
+static xdl_t *xdl_addr_find_handle(void *addr, void **cache) {
   // find handle from cache
   xdl_t *handle = NULL;
   for (handle = *((xdl_t **)cache); NULL != handle; handle = handle->next)
@@ -805,11 +1426,14 @@ int xdl_addr(void *addr, xdl_info_t *info, void **cache) {
   // create new handle, save handle to cache
   if (NULL == handle) {
     handle = (xdl_t *)xdl_open_by_addr(addr);
-    if (NULL == handle) return 0;
+    if (NULL == handle) return NULL;
     handle->next = *(xdl_t **)cache;
     *(xdl_t **)cache = handle;
   }
+  return handle;
+}
 
+static void xdl_addr_fill(xdl_t *handle, void *addr, xdl_info_t *info) {
   // we have at least: load_bias, pathname, dlpi_phdr, dlpi_phnum
   info->dli_fbase = (void *)handle->load_bias;
   info->dli_fname = handle->pathname;
@@ -830,10 +1454,44 @@ int xdl_addr(void *addr, xdl_info_t *info, void **cache) {
     info->dli_saddr = (void *)(handle->load_bias + sym->st_value);
     info->dli_ssize = sym->st_size;
   }
+}
+
+int xdl_addr(void *addr, xdl_info_t *info, void **cache) {
+  if (NULL == addr || NULL == info || NULL == cache) return 0;
 
+  memset(info, 0, sizeof(Dl_info));
+
+  xdl_t *handle = xdl_addr_find_handle(addr, cache);
+  if (NULL == handle) return 0;
+  xdl_addr_fill(handle, addr, info);
   return 1;
 }
 
+size_t xdl_addr_batch(void *const *addrs, xdl_info_t *infos, size_t cnt, void **cache) {
+  if (NULL == addrs || NULL == infos || NULL == cache) return 0;
+
+  size_t found = 0;
+  xdl_t *last = NULL;
+  for (size_t i = 0; i < cnt; i++) {
+    void *addr = addrs[i];
+    xdl_info_t *info = infos + i;
+    memset(info, 0, sizeof(xdl_info_t));
+    if (NULL == addr) continue;
+
+    // stack frames and samples mostly stay in one library
+    xdl_t *handle = last;
+    if (NULL == handle ||
+        !xdl_elf_is_match(handle->load_bias, handle->dlpi_phdr, handle->dlpi_phnum, (uintptr_t)addr))
+      handle = xdl_addr_find_handle(addr, cache);
+    if (NULL == handle) continue;
+    last = handle;
+
+    xdl_addr_fill(handle, addr, info);
+    if (NULL != info->dli_sname) found++;
+  }
+  return found;
+}
+
 void xdl_addr_clean(void **cache) {
   if (NULL == cache) return;
 
@@ -853,9 +1511,21 @@ int xdl_iterate_phdr(int (*callback)(struct dl_phdr_info *, size_t, void *), voi
 }
 
 int xdl_info(void *handle, int request, void *info) {
-  if (NULL == handle || XDL_DI_DLINFO != request || NULL == info) return -1;
+  if (NULL == handle || NULL == info) return -1;
 
   xdl_t *self = (xdl_t *)handle;
+  if (XDL_DI_SYMTAB == request) {
+    xdl_symtab_info_t *symtab_info = (xdl_symtab_info_t *)info;
+    symtab_info->symtab_cnt = NULL != self->symtab ? self->symtab_cnt : 0;
+    symtab_info->symtab_bytes = NULL != self->symtab && NULL == self->symtab_map
+                                    ? self->symtab_cnt * sizeof(ElfW(Sym)) + self->strtab_sz
+                                    : 0;
+    symtab_info->symtab_map_bytes = self->symtab_map_sz;
+    symtab_info->index_cnt = self->symtab_index.syms_cnt;
+    symtab_info->index_bytes = self->symtab_index.slots_cnt * sizeof(xdl_symtab_slot_t);
+    return 0;
+  }
+  if (XDL_DI_DLINFO != request) return -1;
   xdl_info_t *dlinfo = (xdl_info_t *)info;
 
   dlinfo->dli_fbase = (void *)self->load_bias;
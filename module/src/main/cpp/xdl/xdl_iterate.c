@@ -27,14 +27,18 @@
 #include <ctype.h>
 #include <dlfcn.h>
 #include <elf.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <link.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/auxv.h>
+#include <unistd.h>
 
 #include "xdl.h"
 #include "xdl_linker.h"
@@ -71,48 +75,208 @@ static uintptr_t xdl_iterate_get_min_vaddr(struct dl_phdr_info *info) {
   return min_vaddr;
 }
 
-static int xdl_iterate_open_or_rewind_maps(FILE **maps) {
-  if (NULL == *maps) {
-    *maps = fopen("/proc/self/maps", "r");
-    if (NULL == *maps) return -1;
-  } else
-    rewind(*maps);
+//
+// /proc/self/maps, read with one bulk read() and parsed into a table sorted by address.
+// The table is kept until the loader's dlpi_adds / dlpi_subs counters move, without them
+// (before Android R) every lookup rereads the file once.
+//
+
+typedef struct {
+  uintptr_t start;
+  uintptr_t end;
+  uintptr_t offset;
+  const char *pathname;  // into the maps buffer, NULL for anonymous regions
+  char perms[4];
+} xdl_maps_region_t;
+
+static struct {
+  pthread_mutex_t lock;
+  char *buf;
+  size_t buf_cap;
+  xdl_maps_region_t *regions;
+  size_t regions_cnt;
+  size_t regions_cap;
+  bool valid;
+  unsigned long long adds;
+  unsigned long long subs;
+  uintptr_t reads;  // bumped by every read, never 0 afterwards
+} xdl_maps = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static bool xdl_maps_has_counters(size_t size) {
+  return size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(unsigned long long);
+}
+
+static int xdl_maps_get_counters_cb(struct dl_phdr_info *info, size_t size, void *arg) {
+  unsigned long long *counters = (unsigned long long *)arg;
+  if (!xdl_maps_has_counters(size)) return -1;
+  counters[0] = info->dlpi_adds;
+  counters[1] = info->dlpi_subs;
+  return 1;
+}
+
+bool xdl_iterate_get_counters(unsigned long long *adds, unsigned long long *subs) {
+  if (NULL == dl_iterate_phdr) return false;
+  unsigned long long counters[2];
+  if (1 != dl_iterate_phdr(xdl_maps_get_counters_cb, counters)) return false;
+  *adds = counters[0];
+  *subs = counters[1];
+  return true;
+}
+
+static const char *xdl_maps_scan_hex(const char *p, uintptr_t *val) {
+  uintptr_t v = 0;
+  const char *begin = p;
+  for (;; p++) {
+    if ('0' <= *p && *p <= '9')
+      v = (v << 4) | (uintptr_t)(*p - '0');
+    else if ('a' <= *p && *p <= 'f')
+      v = (v << 4) | (uintptr_t)(*p - 'a' + 10);
+    else
+      break;
+  }
+  *val = v;
+  return p == begin ? NULL : p;
+}
+
+// "start-end perms offset dev inode pathname", the line is NUL-terminated in place
+static bool xdl_maps_parse_line(char *line, char *line_end, xdl_maps_region_t *region) {
+  const char *p = line;
+  if (NULL == (p = xdl_maps_scan_hex(p, &region->start)) || '-' != *p++) return false;
+  if (NULL == (p = xdl_maps_scan_hex(p, &region->end)) || ' ' != *p++) return false;
+  if (line_end - p < 5 || ' ' != p[4]) return false;
+  memcpy(region->perms, p, sizeof(region->perms));
+  p += 5;
+  if (NULL == (p = xdl_maps_scan_hex(p, &region->offset)) || ' ' != *p++) return false;
+
+  // skip dev and inode
+  for (int field = 0; field < 2; field++) {
+    while (p < line_end && ' ' != *p) p++;
+    while (p < line_end && ' ' == *p) p++;
+  }
+
+  // trim the ending like xdl_util_trim_ending()
+  char *end = line_end;
+  while (end > p && isspace((unsigned char)end[-1])) end--;
+  *end = '\0';
+  region->pathname = (p < end ? p : NULL);
+  return true;
+}
+
+static int xdl_maps_region_cmp(const void *a, const void *b) {
+  const xdl_maps_region_t *x = (const xdl_maps_region_t *)a, *y = (const xdl_maps_region_t *)b;
+  return x->start < y->start ? -1 : (x->start > y->start ? 1 : 0);
+}
+
+static int xdl_maps_read(void) {
+  int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+
+  size_t len = 0;
+  for (;;) {
+    // keep one byte for the terminating NUL
+    if (xdl_maps.buf_cap - len < 4096 + 1) {
+      size_t cap = xdl_maps.buf_cap ? xdl_maps.buf_cap * 2 : 64 * 1024;
+      char *buf = realloc(xdl_maps.buf, cap);
+      if (NULL == buf) {
+        close(fd);
+        return -1;
+      }
+      xdl_maps.buf = buf;
+      xdl_maps.buf_cap = cap;
+    }
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-statement-expression"
+    ssize_t n = XDL_UTIL_TEMP_FAILURE_RETRY(read(fd, xdl_maps.buf + len, xdl_maps.buf_cap - len - 1));
+#pragma clang diagnostic pop
+    if (n < 0) {
+      close(fd);
+      return -1;
+    }
+    if (0 == n) break;
+    len += (size_t)n;
+  }
+  close(fd);
+  xdl_maps.buf[len] = '\0';
+
+  size_t cnt = 0;
+  bool sorted = true;
+  for (char *line = xdl_maps.buf, *buf_end = xdl_maps.buf + len; line < buf_end;) {
+    char *line_end = memchr(line, '\n', (size_t)(buf_end - line));
+    if (NULL == line_end) line_end = buf_end;
+
+    if (cnt == xdl_maps.regions_cap) {
+      size_t cap = xdl_maps.regions_cap ? xdl_maps.regions_cap * 2 : 1024;
+      xdl_maps_region_t *regions = realloc(xdl_maps.regions, cap * sizeof(xdl_maps_region_t));
+      if (NULL == regions) return -1;
+      xdl_maps.regions = regions;
+      xdl_maps.regions_cap = cap;
+    }
+    xdl_maps_region_t *region = xdl_maps.regions + cnt;
+    if (xdl_maps_parse_line(line, line_end, region)) {
+      if (cnt > 0 && region->start < region[-1].start) sorted = false;
+      cnt++;
+    }
+    line = line_end + 1;
+  }
+  if (!sorted) qsort(xdl_maps.regions, cnt, sizeof(xdl_maps_region_t), xdl_maps_region_cmp);
+
+  xdl_maps.regions_cnt = cnt;
+  return 0;
+}
 
+// Take the lock and make sure the table matches the loader state given by the counters.
+// Without them (before Android R) a table is only trusted within the dl_iterate_phdr() pass
+// that read it: pass_read holds the read seen by the current pass, 0 before the first one.
+static int xdl_maps_acquire(bool has_counters, unsigned long long adds, unsigned long long subs,
+                            uintptr_t *pass_read) {
+  pthread_mutex_lock(&xdl_maps.lock);
+  if (xdl_maps.valid && has_counters && adds == xdl_maps.adds && subs == xdl_maps.subs) return 0;
+  if (!has_counters && NULL != pass_read && 0 != *pass_read && *pass_read == xdl_maps.reads) return 0;
+
+  xdl_maps.valid = false;
+  if (0 != xdl_maps_read()) {
+    pthread_mutex_unlock(&xdl_maps.lock);
+    return -1;
+  }
+  xdl_maps.valid = has_counters;
+  xdl_maps.adds = adds;
+  xdl_maps.subs = subs;
+  if (0 == ++xdl_maps.reads) xdl_maps.reads = 1;
+  if (NULL != pass_read) *pass_read = xdl_maps.reads;
   return 0;
 }
 
-static int xdl_iterate_get_pathname_from_maps(uintptr_t base, char *buf, size_t buf_len, FILE **maps) {
-  // open or rewind maps-file
-  if (0 != xdl_iterate_open_or_rewind_maps(maps)) return -1;  // failed
-
-  char line[1024];
-  while (fgets(line, sizeof(line), *maps)) {
-    // check base address
-    uintptr_t start, end;
-    if (2 != sscanf(line, "%" SCNxPTR "-%" SCNxPTR " r", &start, &end)) continue;
-    if (base < start) break;  // failed
-    if (base >= end) continue;
-
-    // get pathname
-    char *pathname = strchr(line, '/');
-    if (NULL == pathname) break;  // failed
-    xdl_util_trim_ending(pathname);
-
-    // found it
-    strlcpy(buf, pathname, buf_len);
-    return 0;  // OK
+static void xdl_maps_release(void) {
+  pthread_mutex_unlock(&xdl_maps.lock);
+}
+
+static int xdl_maps_get_pathname(uintptr_t base, char *buf, size_t buf_len) {
+  // the region containing base
+  size_t lo = 0, hi = xdl_maps.regions_cnt;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (xdl_maps.regions[mid].start <= base)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
+  if (0 == lo) return -1;
+  xdl_maps_region_t *region = xdl_maps.regions + lo - 1;
+  if (base >= region->end) return -1;
 
-  return -1;  // failed
+  // get pathname
+  if (NULL == region->pathname || NULL == strchr(region->pathname, '/')) return -1;
+  strlcpy(buf, strchr(region->pathname, '/'), buf_len);
+  return 0;
 }
 
 static int xdl_iterate_by_linker_cb(struct dl_phdr_info *info, size_t size, void *arg) {
   uintptr_t *pkg = (uintptr_t *)arg;
   xdl_iterate_phdr_cb_t cb = (xdl_iterate_phdr_cb_t)*pkg++;
   void *cb_arg = (void *)*pkg++;
-  FILE **maps = (FILE **)*pkg++;
   uintptr_t linker_load_bias = *pkg++;
-  int flags = (int)*pkg;
+  int flags = (int)*pkg++;
+  uintptr_t *pass_read = pkg;
 
   // ignore invalid ELF
   if (0 == info->dlpi_addr || NULL == info->dlpi_name || '\0' == info->dlpi_name[0]) return 0;
@@ -120,6 +284,7 @@ static int xdl_iterate_by_linker_cb(struct dl_phdr_info *info, size_t size, void
   // ignore linker if we have returned it already
   if (linker_load_bias == info->dlpi_addr) return 0;
 
+  struct dl_phdr_info *info_orig = info;
   struct dl_phdr_info info_fixed;
   info_fixed.dlpi_addr = info->dlpi_addr;
   info_fixed.dlpi_name = info->dlpi_name;
@@ -141,8 +306,15 @@ static int xdl_iterate_by_linker_cb(struct dl_phdr_info *info, size_t size, void
     if (UINTPTR_MAX == min_vaddr) return 0;  // ignore this ELF
     uintptr_t base = (uintptr_t)(info->dlpi_addr + min_vaddr);
 
+    // the counters are the same for every ELF of one dl_iterate_phdr() pass
+    bool has_counters = xdl_maps_has_counters(size);
+    if (0 != xdl_maps_acquire(has_counters, has_counters ? info_orig->dlpi_adds : 0,
+                              has_counters ? info_orig->dlpi_subs : 0, pass_read))
+      return 0;  // ignore this ELF
     char buf[1024];
-    if (0 != xdl_iterate_get_pathname_from_maps(base, buf, sizeof(buf), maps)) return 0;  // ignore this ELF
+    int r = xdl_maps_get_pathname(base, buf, sizeof(buf));
+    xdl_maps_release();
+    if (0 != r) return 0;  // ignore this ELF
 
     info->dlpi_name = (const char *)buf;
   }
@@ -183,7 +355,6 @@ static int xdl_iterate_by_linker(xdl_iterate_phdr_cb_t cb, void *cb_arg, int fla
   if (NULL == dl_iterate_phdr) return 0;
 
   int api_level = xdl_util_get_api_level();
-  FILE *maps = NULL;
   int r;
 
   // dl_iterate_phdr(3) does NOT contain linker/linker64 when Android version < 8.1 (API level 27).
@@ -197,12 +368,12 @@ static int xdl_iterate_by_linker(xdl_iterate_phdr_cb_t cb, void *cb_arg, int fla
   }
 
   // for other ELF
-  uintptr_t pkg[5] = {(uintptr_t)cb, (uintptr_t)cb_arg, (uintptr_t)&maps, linker_load_bias, (uintptr_t)flags};
+  // the last slot is the maps table read during this pass, so it is parsed at most once per pass
+  uintptr_t pkg[5] = {(uintptr_t)cb, (uintptr_t)cb_arg, linker_load_bias, (uintptr_t)flags, 0};
   if (__ANDROID_API_L__ == api_level || __ANDROID_API_L_MR1__ == api_level) xdl_linker_lock();
   r = dl_iterate_phdr(xdl_iterate_by_linker_cb, pkg);
   if (__ANDROID_API_L__ == api_level || __ANDROID_API_L_MR1__ == api_level) xdl_linker_unlock();
 
-  if (NULL != maps) fclose(maps);
   return r;
 }
 
@@ -290,8 +461,10 @@ int xdl_iterate_phdr_impl(xdl_iterate_phdr_cb_t cb, void *cb_arg, int flags) {
 }
 
 int xdl_iterate_get_full_pathname(uintptr_t base, char *buf, size_t buf_len) {
-  FILE *maps = NULL;
-  int r = xdl_iterate_get_pathname_from_maps(base, buf, buf_len, &maps);
-  if (NULL != maps) fclose(maps);
+  unsigned long long adds = 0, subs = 0;
+  bool has_counters = xdl_iterate_get_counters(&adds, &subs);
+  if (0 != xdl_maps_acquire(has_counters, adds, subs, NULL)) return -1;
+  int r = xdl_maps_get_pathname(base, buf, buf_len);
+  xdl_maps_release();
   return r;
 }
@@ -25,6 +25,7 @@
 #define IO_HEXHACKING_XDL_ITERATE
 
 #include <link.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
@@ -36,6 +37,9 @@ int xdl_iterate_phdr_impl(xdl_iterate_phdr_cb_t cb, void *cb_arg, int flags);
 
 int xdl_iterate_get_full_pathname(uintptr_t base, char *buf, size_t buf_len);
 
+// the loader's dlpi_adds / dlpi_subs, false before Android R where it has none
+bool xdl_iterate_get_counters(unsigned long long *adds, unsigned long long *subs);
+
 #ifdef __cplusplus
 }
 #endif
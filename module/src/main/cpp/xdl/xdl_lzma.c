@@ -24,7 +24,9 @@
 #include "xdl_lzma.h"
 
 #include <ctype.h>
+#include <elf.h>
 #include <inttypes.h>
+#include <link.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -36,11 +38,13 @@
 #include "xdl_util.h"
 
 // LZMA library pathname & symbol names
+#ifndef XDL_LZMA_PATHNAME
 #ifndef __LP64__
 #define XDL_LZMA_PATHNAME "/system/lib/liblzma.so"
 #else
 #define XDL_LZMA_PATHNAME "/system/lib64/liblzma.so"
 #endif
+#endif
 #define XDL_LZMA_SYM_CRCGEN     "CrcGenerateTable"
 #define XDL_LZMA_SYM_CRC64GEN   "Crc64GenerateTable"
 #define XDL_LZMA_SYM_CONSTRUCT  "XzUnpacker_Construct"
@@ -116,6 +120,23 @@ static void xdl_lzma_internal_free(ISzAllocPtr p, void *address) {
   free(address);
 }
 
+// size of the embedded ELF from its header, the section headers come last, 0 if unknown
+static size_t xdl_lzma_elf_size(const uint8_t *data) {
+  const ElfW(Ehdr) *ehdr = (const ElfW(Ehdr) *)data;
+  if (0 != memcmp(ehdr->e_ident, ELFMAG, SELFMAG)) return 0;
+#ifndef __LP64__
+  if (ELFCLASS32 != ehdr->e_ident[EI_CLASS]) return 0;
+#else
+  if (ELFCLASS64 != ehdr->e_ident[EI_CLASS]) return 0;
+#endif
+  if (ehdr->e_shentsize != sizeof(ElfW(Shdr)) || 0 == ehdr->e_shnum) return 0;
+
+  size_t size = (size_t)ehdr->e_shoff + (size_t)ehdr->e_shnum * ehdr->e_shentsize;
+  size_t ph_end = (size_t)ehdr->e_phoff + (size_t)ehdr->e_phnum * ehdr->e_phentsize;
+  if (size < ph_end) size = ph_end;
+  return size < ((size_t)1 << 30) ? size : 0;
+}
+
 int xdl_lzma_decompress(uint8_t *src, size_t src_size, uint8_t **dst, size_t *dst_size) {
   size_t src_offset = 0;
   size_t dst_offset = 0;
@@ -136,13 +157,22 @@ int xdl_lzma_decompress(uint8_t *src, size_t src_size, uint8_t **dst, size_t *ds
 
   xdl_lzma_construct(&state, &alloc);
 
-  *dst_size = 2 * src_size;
+  // decompress the ELF header first and size the buffer from it, doubling is the fallback
+  // when the header gives no size or the data runs past it
+  bool sized = false;
+  size_t want = sizeof(ElfW(Ehdr));
+  *dst_size = 0;
   *dst = NULL;
   do {
-    *dst_size *= 2;
-    if (NULL == (*dst = realloc(*dst, *dst_size))) {
-      xdl_lzma_free(&state);
-      return -1;
+    if (want > *dst_size) {
+      uint8_t *tmp = realloc(*dst, want);
+      if (NULL == tmp) {
+        free(*dst);
+        xdl_lzma_free(&state);
+        return -1;
+      }
+      *dst = tmp;
+      *dst_size = want;
     }
 
     src_remaining = src_size - src_offset;
@@ -166,6 +196,16 @@ int xdl_lzma_decompress(uint8_t *src, size_t src_size, uint8_t **dst, size_t *ds
 
     src_offset += src_remaining;
     dst_offset += dst_remaining;
+
+    if (!sized && dst_offset >= sizeof(ElfW(Ehdr))) {
+      sized = true;
+      size_t elf_size = xdl_lzma_elf_size(*dst);
+      // one spare byte lets the unpacker run to the end of the stream instead of stopping
+      // at a full buffer
+      want = elf_size > dst_offset ? elf_size + 1 : 4 * src_size;
+    } else if (dst_offset == *dst_size || (0 == src_remaining && 0 == dst_remaining)) {
+      want = sized ? 2 * *dst_size : 4 * src_size;
+    }
   } while (status == CODER_STATUS_NOT_FINISHED);
 
   xdl_lzma_free(&state);